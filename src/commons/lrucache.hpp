@@ -3,26 +3,32 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-#include <unordered_map>
+#ifndef COMMONS_LRUCACHE_HPP
+#define COMMONS_LRUCACHE_HPP
+
+#include <cstdint>
+#include <functional>
 #include <list>
+#include <unordered_map>
 
 /**
  * Least Recently Used Cache
  * the newest data is in the front
  */
-template< class Key, class Data>
+template< class Key, class Data, class Hash = std::hash<Key> >
 class CLruCache {
 public:
     typedef std::pair<Key, Data> Item;
     typedef std::list< Item > Queue;
     typedef typename Queue::iterator QueueIterator;
-    typedef std::unordered_map< Key, QueueIterator > Map;
+    typedef std::unordered_map< Key, QueueIterator, Hash > Map;
     typedef std::function<uint32_t(const Item &item)> SizeFunc;
 protected:
     Queue queue;
     Map index;
     uint32_t max_size = 0;
     uint32_t curr_size = 0;
+    uint64_t evicted_count = 0;
     SizeFunc size_func = nullptr;
 
 public:
@@ -38,7 +44,17 @@ public:
     /** @brief Gets the current abstract size of the cache.
      *  @return current size
      */
-    inline uint32_t GetSize() const { return queue.size(); }
+    inline uint32_t GetSize() const { return curr_size; }
+
+    /** @brief Gets the count of the cached items.
+     *  @return item count
+     */
+    inline uint32_t GetCount() const { return queue.size(); }
+
+    /** @brief Gets the count of the items evicted for exceeding the maximum size.
+     *  @return evicted count
+     */
+    inline uint64_t GetEvictedCount() const { return evicted_count; }
 
     /** @brief Gets the maximum sbstract size of the cache.
      *  @return maximum size
@@ -58,6 +74,7 @@ public:
     void Clear() {
         queue.clear();
         index.clear();
+        curr_size = 0;
     };
 
     /** @brief Checks for the existance of a key in the cache.
@@ -74,6 +91,7 @@ public:
     inline void Remove( const Key &key ) {
         auto mapIt = index.find( key );
         if (mapIt != index.end()) {
+            DecSize(*mapIt->second);
             queue.erase(mapIt->second);
             index.erase(mapIt);
         }
@@ -112,8 +130,12 @@ public:
         if(mapIt != index.end()) {
             // the key exists
             auto &qIt = mapIt->second;
+            DecSize(*qIt);
             qIt->second = data;
+            curr_size += GetItemSize(*qIt);
             TouchInList(qIt);
+            CleanExcess();
+            return;
         }
 
         // new cache item
@@ -137,13 +159,21 @@ private:
         while( curr_size > max_size ) {
             // remove the last element.
             const auto &lastData = queue.back();
-            curr_size -= GetItemSize(lastData);
-            queue.pop_back();
+            DecSize(lastData);
             index.erase( lastData.first );
+            queue.pop_back();
+            evicted_count++;
         }
     }
 
+    inline void DecSize(const Item &item) {
+        uint32_t sz = GetItemSize(item);
+        curr_size = curr_size > sz ? curr_size - sz : 0;
+    }
+
     inline uint32_t GetItemSize(const Item &item) {
         return size_func == nullptr ? 1 : size_func(item);
     }
-};
\ No newline at end of file
+};
+
+#endif //COMMONS_LRUCACHE_HPP
@@ -0,0 +1,183 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "metrics.h"
+
+#include "commons/tinyformat.h"
+
+using namespace std;
+
+uint32_t CMetricHistogram::GetBucketIndex(uint64_t us) {
+    if (us < LINEAR_BUCKETS)
+        return us;
+
+    uint32_t exponent = 63 - __builtin_clzll(us);  // us >= 16, so exponent >= 4
+    if (exponent >= MAX_EXPONENT)
+        return BUCKET_COUNT - 1;
+
+    uint32_t subIndex = (us >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return LINEAR_BUCKETS + (exponent - 4) * SUB_BUCKETS + subIndex;
+}
+
+uint64_t CMetricHistogram::GetBucketLowerBound(uint32_t index) {
+    if (index < LINEAR_BUCKETS)
+        return index;
+
+    uint32_t exponent = 4 + (index - LINEAR_BUCKETS) / SUB_BUCKETS;
+    uint32_t subIndex = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+    return uint64_t(SUB_BUCKETS + subIndex) << (exponent - SUB_BUCKET_BITS);
+}
+
+void CMetricHistogram::Record(uint64_t us) {
+    buckets[GetBucketIndex(us)].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(us, memory_order_relaxed);
+
+    uint64_t curMax = max.load(memory_order_relaxed);
+    while (us > curMax && !max.compare_exchange_weak(curMax, us, memory_order_relaxed)) {
+    }
+}
+
+void CMetricHistogram::Reset() {
+    for (auto &bucket : buckets)
+        bucket.store(0, memory_order_relaxed);
+    count.store(0, memory_order_relaxed);
+    sum.store(0, memory_order_relaxed);
+    max.store(0, memory_order_relaxed);
+}
+
+// the percentiles are the middle of the buckets they fall in, the concurrent records may be partially counted
+CMetricHistogram::Stat CMetricHistogram::GetStat() const {
+    Stat stat;
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = buckets[i].load(memory_order_relaxed);
+        total += counts[i];
+    }
+    stat.count = total;
+    stat.sum   = sum.load(memory_order_relaxed);
+    stat.max   = max.load(memory_order_relaxed);
+    if (total == 0)
+        return stat;
+
+    auto getPercentile = [&](double percent) -> uint64_t {
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(percent * total + 0.5));
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                if (i + 1 == BUCKET_COUNT || i < LINEAR_BUCKETS)
+                    return std::min(GetBucketLowerBound(i), stat.max);
+                uint64_t lower = GetBucketLowerBound(i);
+                return std::min((lower + GetBucketLowerBound(i + 1)) / 2, stat.max);
+            }
+        }
+        return stat.max;
+    };
+    stat.p50 = getPercentile(0.50);
+    stat.p90 = getPercentile(0.90);
+    stat.p99 = getPercentile(0.99);
+    return stat;
+}
+
+CMetricsRegistry &CMetricsRegistry::Instance() {
+    static CMetricsRegistry registry;
+    return registry;
+}
+
+template <typename MetricType>
+static MetricType &GetOrAddMetric(map<string, unique_ptr<MetricType>> &metrics, const string &name) {
+    auto &pMetric = metrics[name];
+    if (!pMetric)
+        pMetric.reset(new MetricType());
+    return *pMetric;
+}
+
+CMetricCounter &CMetricsRegistry::GetCounter(const string &name) {
+    lock_guard<mutex> lock(mtx);
+    return GetOrAddMetric(counters, name);
+}
+
+CMetricGauge &CMetricsRegistry::GetGauge(const string &name) {
+    lock_guard<mutex> lock(mtx);
+    return GetOrAddMetric(gauges, name);
+}
+
+CMetricHistogram &CMetricsRegistry::GetHistogram(const string &name) {
+    lock_guard<mutex> lock(mtx);
+    return GetOrAddMetric(histograms, name);
+}
+
+void CMetricsRegistry::GetCounters(vector<pair<string, uint64_t>> &countersOut) const {
+    lock_guard<mutex> lock(mtx);
+    for (const auto &item : counters)
+        countersOut.emplace_back(item.first, item.second->Get());
+}
+
+void CMetricsRegistry::GetGauges(vector<pair<string, int64_t>> &gaugesOut) const {
+    lock_guard<mutex> lock(mtx);
+    for (const auto &item : gauges)
+        gaugesOut.emplace_back(item.first, item.second->Get());
+}
+
+void CMetricsRegistry::GetHistograms(vector<pair<string, CMetricHistogram::Stat>> &histogramsOut) const {
+    lock_guard<mutex> lock(mtx);
+    for (const auto &item : histograms)
+        histogramsOut.emplace_back(item.first, item.second->GetStat());
+}
+
+// the gauges describe the current states, so they are not reset
+void CMetricsRegistry::Reset() {
+    lock_guard<mutex> lock(mtx);
+    for (auto &item : counters)
+        item.second->Reset();
+    for (auto &item : histograms)
+        item.second->Reset();
+}
+
+static string EscapeLabelValue(const string &value) {
+    string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"')
+            escaped += string("\\") + c;
+        else if (c == '\n')
+            escaped += "\\n";
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+string CMetricsRegistry::ToPrometheusText() const {
+    vector<pair<string, uint64_t>> counterList;
+    vector<pair<string, int64_t>> gaugeList;
+    vector<pair<string, CMetricHistogram::Stat>> histogramList;
+    GetCounters(counterList);
+    GetGauges(gaugeList);
+    GetHistograms(histogramList);
+
+    string text;
+    for (const auto &item : counterList) {
+        text += strprintf("# TYPE coin_%s counter\n", item.first);
+        text += strprintf("coin_%s %llu\n", item.first, item.second);
+    }
+    for (const auto &item : gaugeList) {
+        text += strprintf("# TYPE coin_%s gauge\n", item.first);
+        text += strprintf("coin_%s %lld\n", item.first, item.second);
+    }
+    if (!histogramList.empty()) {
+        text += "# TYPE coin_benchmark_duration_us summary\n";
+        for (const auto &item : histogramList) {
+            string name = EscapeLabelValue(item.first);
+            const auto &stat = item.second;
+            text += strprintf("coin_benchmark_duration_us{name=\"%s\",quantile=\"0.5\"} %llu\n", name, stat.p50);
+            text += strprintf("coin_benchmark_duration_us{name=\"%s\",quantile=\"0.9\"} %llu\n", name, stat.p90);
+            text += strprintf("coin_benchmark_duration_us{name=\"%s\",quantile=\"0.99\"} %llu\n", name, stat.p99);
+            text += strprintf("coin_benchmark_duration_us_sum{name=\"%s\"} %llu\n", name, stat.sum);
+            text += strprintf("coin_benchmark_duration_us_count{name=\"%s\"} %llu\n", name, stat.count);
+        }
+    }
+    return text;
+}
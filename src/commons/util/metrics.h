@@ -0,0 +1,119 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_METRICS_H
+#define COIN_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** A monotonically increasing count */
+class CMetricCounter {
+public:
+    void Increase(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Get() const { return value.load(std::memory_order_relaxed); }
+    void Reset() { value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+/** A value which can go up and down */
+class CMetricGauge {
+public:
+    void Set(int64_t n) { value.store(n, std::memory_order_relaxed); }
+    void Add(int64_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t Get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value{0};
+};
+
+/**
+ * A log-linear histogram of the latencies in microseconds. The values below 16 have a bucket each, every
+ * power of 2 above them is split into 8 linear buckets, so a percentile is within 1/16 of the real value.
+ */
+class CMetricHistogram {
+public:
+    static const uint32_t LINEAR_BUCKETS = 16;
+    static const uint32_t SUB_BUCKET_BITS = 3;
+    static const uint32_t SUB_BUCKETS    = 1 << SUB_BUCKET_BITS;
+    static const uint32_t MAX_EXPONENT   = 40;  // about 12 days in us, larger values go to the last bucket
+    static const uint32_t BUCKET_COUNT   = LINEAR_BUCKETS + (MAX_EXPONENT - 4) * SUB_BUCKETS;
+
+    struct Stat {
+        uint64_t count = 0;
+        uint64_t sum   = 0;
+        uint64_t max   = 0;
+        uint64_t p50   = 0;
+        uint64_t p90   = 0;
+        uint64_t p99   = 0;
+    };
+
+public:
+    void Record(uint64_t us);
+    void Reset();
+    Stat GetStat() const;
+
+    static uint32_t GetBucketIndex(uint64_t us);
+    static uint64_t GetBucketLowerBound(uint32_t index);
+
+private:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+};
+
+/**
+ * The registry of the process-wide metrics. A metric is registered once by its name and keeps its address until
+ * exit, so the call sites cache the reference and update it lock-free without any allocation.
+ */
+class CMetricsRegistry {
+public:
+    static CMetricsRegistry &Instance();
+
+    CMetricCounter &GetCounter(const std::string &name);
+    CMetricGauge &GetGauge(const std::string &name);
+    CMetricHistogram &GetHistogram(const std::string &name);
+
+    void GetCounters(std::vector<std::pair<std::string, uint64_t>> &counters) const;
+    void GetGauges(std::vector<std::pair<std::string, int64_t>> &gauges) const;
+    void GetHistograms(std::vector<std::pair<std::string, CMetricHistogram::Stat>> &histograms) const;
+    void Reset();
+
+    /** Export all of the metrics in the Prometheus text format */
+    std::string ToPrometheusText() const;
+
+private:
+    mutable std::mutex mtx;
+    std::map<std::string, std::unique_ptr<CMetricCounter>> counters;
+    std::map<std::string, std::unique_ptr<CMetricGauge>> gauges;
+    std::map<std::string, std::unique_ptr<CMetricHistogram>> histograms;
+};
+
+// resolve the metric of the call site once, name must be a string literal
+#define METRIC_COUNTER(name)                                                                  \
+    (*[]() {                                                                                  \
+        static CMetricCounter *pMetric = &CMetricsRegistry::Instance().GetCounter(name);      \
+        return pMetric;                                                                       \
+    }())
+#define METRIC_GAUGE(name)                                                                    \
+    (*[]() {                                                                                  \
+        static CMetricGauge *pMetric = &CMetricsRegistry::Instance().GetGauge(name);          \
+        return pMetric;                                                                       \
+    }())
+#define METRIC_HISTOGRAM(name)                                                                \
+    (*[]() {                                                                                  \
+        static CMetricHistogram *pMetric = &CMetricsRegistry::Instance().GetHistogram(name);  \
+        return pMetric;                                                                       \
+    }())
+
+#endif  // COIN_METRICS_H
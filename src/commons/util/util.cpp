@@ -1078,12 +1078,6 @@ bool  ConvertPermsToString(uint64_t perms, uint8_t total_perms_count, string& pe
 //     return true;
 // }
 
-shared_ptr<Benchmark> MakeBenchmark(const char *msg, const char *fileIn, int lineIn,
-                                    const char *funcIn) {
-    return SysCfg().IsBenchmark() ? make_shared<Benchmark>(msg, fileIn, lineIn, funcIn) : nullptr;
-}
-
-shared_ptr<Benchmark> MakeBenchmark(const char *msg, const char *fileIn, int lineIn,
-                                    const char *funcIn, const Benchmark::Time &startIn) {
-    return SysCfg().IsBenchmark() ? make_shared<Benchmark>(msg, fileIn, lineIn, funcIn, startIn) : nullptr;
+bool IsBenchmarkPrinted() {
+    return SysCfg().IsBenchmark();
 }
\ No newline at end of file
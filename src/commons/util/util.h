@@ -16,6 +16,7 @@
 #include "commons/tinyformat.h"
 #include "commons/compat/compat.h"
 #include "commons/json/json_spirit_value.h"
+#include "commons/util/metrics.h"
 
 #include <stdarg.h>
 #include <stdint.h>
@@ -472,17 +473,23 @@ static inline bool CalcAmountByRatio(uint64_t amountIn, uint64_t ratio, uint64_t
 ////////////////////////////////////////////////////////////////////////////////
 // Benchmark
 
+/** Whether to print each benchmark to stdout, see -benchmark */
+bool IsBenchmarkPrinted();
+
+// Measure the time spent in the scope into the latency histogram of the call site
 class Benchmark {
 public:
     using system_clock = std::chrono::system_clock;
     typedef std::chrono::time_point<system_clock> Time;
 
 public:
-    Benchmark(const char *msgIn, const char *fileIn, int lineIn, const char *funcIn)
-        : Benchmark(msgIn, fileIn, lineIn, funcIn, system_clock::now()) {}
-    Benchmark(const char *msgIn, const char *fileIn, int lineIn, const char *funcIn,
+    Benchmark(CMetricHistogram &histogramIn, const char *msgIn, const char *fileIn, int lineIn, const char *funcIn)
+        : Benchmark(histogramIn, msgIn, fileIn, lineIn, funcIn, system_clock::now()) {}
+    Benchmark(CMetricHistogram &histogramIn, const char *msgIn, const char *fileIn, int lineIn, const char *funcIn,
               const Time &startIn)
-        : msg(msgIn), file(fileIn), line(lineIn), func(funcIn), start(startIn) {}
+        : histogram(histogramIn), msg(msgIn), file(fileIn), line(lineIn), func(funcIn), start(startIn) {}
+    Benchmark(const Benchmark &) = delete;
+    Benchmark &operator=(const Benchmark &) = delete;
     ~Benchmark() { end(); }
 
     inline void log(const char *msgIn, const char *fileIn, int lineIn, const char *funcIn,
@@ -494,10 +501,15 @@ public:
     }
     inline void end() {
         if (!is_end) {
-            log(msg, file, line, func, system_clock::now());
+            Time endTime = system_clock::now();
+            auto us      = std::chrono::duration_cast<std::chrono::microseconds>(endTime - start).count();
+            histogram.Record(us > 0 ? us : 0);
+            if (IsBenchmarkPrinted())
+                log(msg, file, line, func, endTime);
             is_end = true;
         }
     }
+    CMetricHistogram &histogram;
     const char *msg  = nullptr;
     const char *file = nullptr;
     int line         = 0;
@@ -507,13 +519,8 @@ public:
     bool is_end = false;
 };
 
-std::shared_ptr<Benchmark> MakeBenchmark(const char *msg, const char *fileIn, int lineIn,
-                                         const char *funcIn);
-
-std::shared_ptr<Benchmark> MakeBenchmark(const char *msg, const char *fileIn, int lineIn,
-                                         const char *funcIn, const Benchmark::Time &startIn);
-
-#define MAKE_BENCHMARK(msg) MakeBenchmark(msg, __FILE__, __LINE__, __func__)
-#define MAKE_BENCHMARK_START(msg, start) MakeBenchmark(msg, __FILE__, __LINE__, __func__, start)
+// msg must be a string literal, it names the latency histogram shared by the call sites of the same msg
+#define MAKE_BENCHMARK(msg) Benchmark(METRIC_HISTOGRAM(msg), msg, __FILE__, __LINE__, __func__)
+#define MAKE_BENCHMARK_START(msg, start) Benchmark(METRIC_HISTOGRAM(msg), msg, __FILE__, __LINE__, __func__, start)
 
 #endif
\ No newline at end of file
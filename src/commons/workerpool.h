@@ -0,0 +1,157 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_WORKERPOOL_H
+#define COIN_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "commons/util/util.h"
+
+/**
+ * A fixed pool of worker threads to run a batch of independent jobs in parallel.
+ * The calling thread takes part in the batch too, so a pool without any worker
+ * thread simply runs the jobs serially.
+ */
+class CWorkerPool final {
+public:
+    using Job = std::function<void(size_t index)>;
+
+public:
+    CWorkerPool() {}
+    ~CWorkerPool() { Stop(); }
+
+    CWorkerPool(const CWorkerPool &) = delete;
+    CWorkerPool &operator=(const CWorkerPool &) = delete;
+
+public:
+    void Start(const std::string &name, uint32_t threadCount);
+    void Stop();
+
+    uint32_t GetThreadCount() const { return thread_count; }
+
+    /** Run job(0) ... job(count - 1) and return after all of them are done */
+    void Run(size_t count, const Job &job);
+
+private:
+    void WorkerLoop(const std::string &name);
+    void Process(const Job &job, size_t count);
+
+private:
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> thread_count{0};
+
+    std::mutex run_mtx;  //!< serializes concurrent Run() callers
+    std::mutex mtx;
+    std::condition_variable work_cond;
+    std::condition_variable done_cond;
+
+    const Job *p_job          = nullptr;
+    size_t job_count          = 0;
+    std::atomic<size_t> next_index{0};
+    uint32_t busy_workers     = 0;
+    uint64_t generation       = 0;
+    bool stopping             = false;
+};
+
+inline void CWorkerPool::Start(const std::string &name, uint32_t threadCount) {
+    Stop();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    stopping   = false;
+    generation = 0;  // the new workers must not take the last batch before the restart for a new one
+    for (uint32_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(&CWorkerPool::WorkerLoop, this, name + "-" + std::to_string(i));
+    }
+    thread_count = threadCount;
+}
+
+inline void CWorkerPool::Stop() {
+    std::unique_lock<std::mutex> runLock(run_mtx);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (threads.empty())
+            return;
+
+        stopping     = true;
+        thread_count = 0;
+    }
+    work_cond.notify_all();
+
+    for (auto &t : threads) {
+        if (t.joinable())
+            t.join();
+    }
+    threads.clear();
+}
+
+inline void CWorkerPool::Run(size_t count, const Job &job) {
+    if (count == 0)
+        return;
+
+    std::unique_lock<std::mutex> runLock(run_mtx);
+    if (threads.empty() || count == 1) {
+        for (size_t i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        p_job        = &job;
+        job_count    = count;
+        next_index   = 0;
+        busy_workers = threads.size();
+        generation++;
+    }
+    work_cond.notify_all();
+
+    Process(job, count);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    done_cond.wait(lock, [this] { return busy_workers == 0; });
+    p_job     = nullptr;
+    job_count = 0;
+}
+
+inline void CWorkerPool::WorkerLoop(const std::string &name) {
+    RenameThread(strprintf("coin-%s", name).c_str());
+
+    uint64_t seenGeneration = 0;
+    while (true) {
+        const Job *pJob = nullptr;
+        size_t count    = 0;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            work_cond.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping)
+                return;
+
+            seenGeneration = generation;
+            pJob           = p_job;
+            count          = job_count;
+        }
+
+        Process(*pJob, count);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (--busy_workers == 0)
+            done_cond.notify_all();
+    }
+}
+
+inline void CWorkerPool::Process(const Job &job, size_t count) {
+    size_t index;
+    while ((index = next_index.fetch_add(1)) < count) {
+        job(index);
+    }
+}
+
+#endif  // COIN_WORKERPOOL_H
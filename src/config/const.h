@@ -152,6 +152,13 @@ static const uint32_t MAX_BLOCK_SIZE = 4000000;
 /** Default for -blockmaxsize which control the range of sizes the mining code will create **/
 static const uint32_t DEFAULT_BLOCK_MAX_SIZE = 3750000;
 
+/** Default for -wasmmodulecache, the maximum memory of the instantiated wasm modules kept in cache, in megabytes */
+static const uint32_t DEFAULT_WASM_MODULE_CACHE_SIZE = 256;
+/** Max for -wasmmodulecache in megabytes */
+static const uint32_t MAX_WASM_MODULE_CACHE_SIZE = 4095;
+/** Default for -maxmempool, the maximum total size of the txs kept in the memory pool, in megabytes */
+static const uint32_t DEFAULT_MAX_MEMPOOL_SIZE = 300;
+
 /** The maximum size for transactions we're willing to relay/mine */
 static const uint32_t MAX_STANDARD_TX_SIZE = 100000;
 /** The maximum size for transactions we're willing to relay/mine */
@@ -178,9 +185,19 @@ static const int64_t DEFAULT_DB_CACHE = 100;
 static const int64_t MAX_DB_CACHE = sizeof(void *) > 4 ? 4096 : 1024;
 /** min. -dbcache in (MiB) */
 static const int64_t MIN_DB_CACHE = 4;
+/** -par default (number of signature verification threads, 0 = auto) */
+static const int32_t DEFAULT_SIGCHECK_THREADS = 0;
+/** max. -par */
+static const int32_t MAX_SIGCHECK_THREADS = 16;
 
 /** Coinbase transaction outputs can only be spent after this number of new blocks (network rule) */
 static const int32_t BLOCK_REWARD_MATURITY = 100;
+/** Blocks kept in the recent block cache beyond the tx cache window, for reorg */
+static const int32_t RECENT_BLOCK_CACHE_EXTRA_COUNT = 100;
+/** Default for -undocache, the recently connected blocks kept in memory with their undo data for reorg */
+static const int32_t DEFAULT_UNDO_CACHE_BLOCKS = 100;
+/** Default for -txbodycache, the MB of the confirmed txs kept in memory for the lookups by txid */
+static const int32_t DEFAULT_TX_BODY_CACHE_SIZE = 16;
 /** RegId's mature period measured by blocks */
 static const int32_t REG_ID_MATURITY = 100;
 
@@ -25,6 +25,7 @@
 using namespace json_spirit;
 
 class CAccountDBCache;
+class CDelegateDBCache;
 
 
 // perms for an account
@@ -191,6 +192,8 @@ struct CAccount {
     void SetEmpty() { keyid.SetEmpty(); }  // TODO: need set other fields to empty()??
     string ToString() const;
     Object ToJsonObj() const;
+    // the votes are read from delegateCache, for the queries of the state view
+    Object ToJsonObj(CDelegateDBCache &delegateCache, int32_t tipHeight) const;
 
     void SetRegId(CRegID & regIdIn) { regid = regIdIn; }
 
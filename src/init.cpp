@@ -11,20 +11,25 @@
 #include "logging.h"
 #include "init.h"
 #include "config/configuration.h"
+#include "crypto/sha256.h"
 #include "p2p/addrman.h"
 
 #include "rpc/core/rpcserver.h"
 #include "vm/luavm/lua/lua.h"
+#include "vm/luavm/luavm.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #include "main.h"
 #include "miner/miner.h"
 #include "net.h"
 #include "p2p/node.h"
+#include "p2p/socketevents.h"
 #include "persistence/blockdb.h"
+#include "persistence/blockundo.h"
 #include "persistence/accountdb.h"
 #include "persistence/txdb.h"
 #include "persistence/contractdb.h"
+#include "persistence/memcachesnapshot.h"
 #include "tx/tx.h"
 #include "commons/util/util.h"
 #include "commons/util/time.h"
@@ -60,6 +65,7 @@
 #include <boost/assign/list_of.hpp>
 
 #include "wasm/modules/wasm_native_dispatch.hpp"
+#include "wasm/wasm_interface.hpp"
 
 using namespace std;
 using namespace boost::assign;
@@ -83,6 +89,51 @@ extern void wasm_code_cache_free();
 #define MIN_CORE_FILEDESCRIPTORS 150
 #endif
 
+// the contracts of the cached wasm modules at last shutdown, which are instantiated again on startup
+static const string WASM_MODULES_FILE = "wasmmodules.dat";
+
+static void SaveWasmModuleContracts() {
+    boost::filesystem::path path = GetDataDir() / WASM_MODULES_FILE;
+    CAutoFile fileout = CAutoFile(fopen(path.string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+    if (!fileout) {
+        LogPrint(BCLog::ERROR, "Failed to open file %s\n", path.string());
+        return;
+    }
+
+    try {
+        fileout << wasm::wasm_interface::get_cached_contracts();
+    } catch (std::exception &e) {
+        LogPrint(BCLog::ERROR, "Serialize or I/O error - %s\n", e.what());
+    }
+}
+
+static void PreloadWasmModules() {
+    boost::filesystem::path path = GetDataDir() / WASM_MODULES_FILE;
+    if (!boost::filesystem::exists(path))
+        return;
+
+    vector<uint64_t> contracts;
+    CAutoFile filein = CAutoFile(fopen(path.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
+    try {
+        if (filein)
+            filein >> contracts;
+    } catch (std::exception &e) {
+        LogPrint(BCLog::ERROR, "Deserialize or I/O error - %s\n", e.what());
+    }
+
+    uint32_t count = 0;
+    for (auto contract : contracts) {
+        CUniversalContractStore contractStore;
+        if (!pCdMan->pContractCache->GetContract(CRegID(contract), contractStore) || contractStore.vm_type != VMType::WASM_VM)
+            continue;
+
+        wasm::wasm_interface::preload(contract, vector<uint8_t>(contractStore.code.begin(), contractStore.code.end()),
+                                      contractStore.code_hash);
+        count++;
+    }
+    LogPrint(BCLog::INFO, "Preloading the wasm modules of %u contracts\n", count);
+}
+
 // Used to pass flags to the Bind() function
 enum BindFlags {
     BF_NONE         = 0,
@@ -146,6 +197,8 @@ void Shutdown() {
     StopNode();
     UnregisterNodeSignals(GetNodeSignals());
 
+    signatureCheckPool.Stop();
+
     {
         LOCK(cs_main);
 
@@ -155,7 +208,10 @@ void Shutdown() {
         }
 
         if (pCdMan != nullptr) {
+            ReleaseStateView();
             pCdMan->Flush();
+            if (chainActive.Tip() != nullptr)
+                CMemCacheSnapshot(GetDataDir() / MEM_CACHE_SNAPSHOT_FILE).Write(chainActive.Tip(), *pCdMan);
             delete pCdMan;
             pCdMan = nullptr;
         }
@@ -171,7 +227,9 @@ void Shutdown() {
     globalVerifyHandle.reset();
     ECC_Stop();
 
+    SaveWasmModuleContracts();
     wasm_code_cache_free();
+    CLuaStatePool::Instance().Stop();
 
     LogPrint(BCLog::INFO, "Shutdown() : done\n");
 }
@@ -219,6 +277,12 @@ string HelpMessage() {
 #endif
     strUsage += "  -datadir=<dir>         " + _("Specify data directory") + "\n";
     strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), MIN_DB_CACHE, MAX_DB_CACHE, DEFAULT_DB_CACHE) + "\n";
+    strUsage += "  -singlestatedb         " + _("Store all of the state databases in one database and commit them atomically, the existing databases are migrated on startup (default: 0)") + "\n";
+    strUsage += "  -undocache=<n>         " + strprintf(_("Keep the last <n> connected blocks and their undo data in memory to reorg without reading disk (default: %d)"), DEFAULT_UNDO_CACHE_BLOCKS) + "\n";
+    strUsage += "  -txbodycache=<n>       " + strprintf(_("Keep <n> MB of the confirmed txs in memory for the lookups by txid, requires -txindex, 0 to disable (default: %d)"), DEFAULT_TX_BODY_CACHE_SIZE) + "\n";
+    strUsage += "  -wasmvm=<vm>           " + strprintf(_("Execute the wasm contracts by the interpreter or the jit of the vm, the jit is available on x86_64 linux only (default: %s)"), wasm::wasm_interface::get_vm_type_name(wasm::default_vm_type)) + "\n";
+    strUsage += "  -wasmmodulecache=<n>   " + strprintf(_("Keep the instantiated wasm contract modules below <n> megabytes, the least recently used are evicted first (0 to %u, default: %u)"), MAX_WASM_MODULE_CACHE_SIZE, DEFAULT_WASM_MODULE_CACHE_SIZE) + "\n";
+    strUsage += "  -par=<n>               " + strprintf(_("Set the number of signature verification threads (%d to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), -MAX_SIGCHECK_THREADS, MAX_SIGCHECK_THREADS, DEFAULT_SIGCHECK_THREADS) + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
     strUsage += "  -pid=<file>            " + _("Specify pid file (default: coin.pid)") + "\n";
     strUsage += "  -reindex               " + _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup") + "\n";
@@ -233,6 +297,7 @@ string HelpMessage() {
     strUsage += "  -bantime=<n>           " + _("Number of seconds to keep misbehaving peers from reconnecting (default: 86400)") + "\n";
     strUsage += "  -bind=<addr>           " + _("Bind to given address and always listen on it. Use [host]:port notation for IPv6") + "\n";
     strUsage += "  -connect=<ip>          " + _("Connect only to the specified node(s)") + "\n";
+    strUsage += "  -compactblocks         " + _("Relay the new blocks by their short tx ids, the peers rebuild them from their mempools (default: 1)") + "\n";
     strUsage += "  -discover              " + _("Discover own IP address (default: 1 when listening and no -externalip)") + "\n";
     strUsage += "  -dns                   " + _("Allow DNS lookups for -addnode, -seednode and -connect") + " " + _("(default: 1)") + "\n";
     strUsage += "  -dnsseed               " + _("Query for peer addresses via DNS lookup, if low on addresses (default: 1 unless -connect)") + "\n";
@@ -240,6 +305,8 @@ string HelpMessage() {
     strUsage += "  -externalip=<ip>       " + _("Specify your own public address") + "\n";
     strUsage += "  -listen                " + _("Accept connections from outside (default: 1 if no -proxy or -connect)") + "\n";
     strUsage += "  -maxconnections=<n>    " + _("Maintain at most <n> connections to peers (default: 125)") + "\n";
+    strUsage += "  -socketevents=<mode>   " + strprintf(_("Wait for the peer sockets by <mode>: select or epoll, select limits the connections below FD_SETSIZE (default: %s)"), DEFAULT_SOCKET_EVENTS) + "\n";
+    strUsage += "  -maxmempool=<n>        " + strprintf(_("Keep the transaction memory pool below <n> megabytes, the lowest fee rate transactions are evicted first (0 = unlimited, default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE) + "\n";
     strUsage += "  -maxreceivebuffer=<n>  " + _("Maximum per-connection receive buffer, <n>*1000 bytes (default: 5000)") + "\n";
     strUsage += "  -maxsendbuffer=<n>     " + _("Maximum per-connection send buffer, <n>*1000 bytes (default: 1000)") + "\n";
     strUsage += "  -onion=<ip:port>       " + _("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: -proxy)") + "\n";
@@ -275,7 +342,7 @@ string HelpMessage() {
 
     strUsage += "\n" + _("Debugging/Testing options:") + "\n";
     if (SysCfg().GetBoolArg("-help-debug", false)) {
-        strUsage += "  -benchmark             " + _("Show benchmark information (default: 0)") + "\n";
+        strUsage += "  -benchmark             " + _("Print each benchmark to stdout, they are always aggregated for getmetrics (default: 0)") + "\n";
         strUsage += "  -dblogsize=<n>         " + _("Flush database activity from memory pool to disk log every <n> megabytes (default: 100)") + "\n";
         strUsage += "  -disablesafemode       " + _("Disable safemode, override a real safe mode event (default: 0)") + "\n";
         strUsage += "  -testsafemode          " + _("Force safe mode (default: 0)") + "\n";
@@ -316,6 +383,7 @@ string HelpMessage() {
     strUsage += "  -rpcport=<port>        " + _("Listen for JSON-RPC connections on <port> (default: 8332 or testnet: 18332)") + "\n";
     strUsage += "  -rpcallowip=<ip>       " + _("Allow JSON-RPC connections from specified IP address") + "\n";
     strUsage += "  -rpcthreads=<n>        " + _("Set the number of threads to service RPC calls (default: 4)") + "\n";
+    strUsage += "  -rpcmetrics            " + _("Serve the metrics in Prometheus text format at /metrics of the RPC port without authorization, subject to -rpcallowip (default: 0)") + "\n";
 
     strUsage += "\n" + _("RPC SSL options: (see the Coin Wiki for SSL setup instructions)") + "\n";
     strUsage += "  -rpcssl                                  " + _("Use OpenSSL (https) for JSON-RPC connections") + "\n";
@@ -348,7 +416,8 @@ void ThreadImport(vector<boost::filesystem::path> vImportFiles) {
     if (SysCfg().IsReindex()) {
 
         CImportingNow imp;
-        int32_t nFile = 0;
+        int64_t nStart = GetTimeMillis();
+        int32_t nFile  = 0;
         while (true) {
             CDiskBlockPos pos(nFile, 0);
             FILE *file = OpenBlockFile(pos, true);
@@ -361,7 +430,14 @@ void ThreadImport(vector<boost::filesystem::path> vImportFiles) {
         }
         pCdMan->pBlockCache->WriteReindexing(false);
         SysCfg().SetReIndex(false);
-        LogPrint(BCLog::INFO, "Reindexing finished\n");
+        int64_t nElapsed = std::max<int64_t>(GetTimeMillis() - nStart, 1);
+        int32_t nHeight  = 0;
+        {
+            LOCK(cs_main);
+            nHeight = chainActive.Height();
+        }
+        LogPrint(BCLog::INFO, "Reindexing finished, connected %d blocks in %dms (%.2f blocks/s)\n", nHeight,
+                 nElapsed, nHeight * 1000.0 / nElapsed);
         // To avoid ending up in a situation without genesis block, re-try initializing (no-op if reindexing worked):
         InitBlockIndex();
         pWalletMain->ResendWalletTransactions();
@@ -466,6 +542,9 @@ bool AppInit(boost::thread_group &threadGroup) {
     sa_hup.sa_flags = 0;
     sigaction(SIGHUP, &sa_hup, nullptr);
 
+    // Select the fastest SHA256 implementation supported by the CPU
+    string sha256Algo = SHA256AutoDetect();
+
     // Initialize elliptic curve code
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -528,10 +607,24 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetTxTrace(SysCfg().GetBoolArg("-txtrace", true));
 
-    // Make sure enough file descriptors are available
+    string socketEventsMode = SysCfg().GetArg("-socketevents", DEFAULT_SOCKET_EVENTS);
+    if (!InitSocketEvents(socketEventsMode))
+        return InitError(strprintf(_("Unsupported socket events mode: '%s'"), socketEventsMode));
+
+    wasm::vm_type wasmVmType;
+    string wasmVm = SysCfg().GetArg("-wasmvm", wasm::wasm_interface::get_vm_type_name(wasm::default_vm_type));
+    if (!wasm::wasm_interface::parse_vm_type(wasmVm, wasmVmType))
+        return InitError(strprintf(_("Unsupported wasm vm: '%s'"), wasmVm));
+    wasm::wasm_interface::set_vm_type(wasmVmType);
+    LogPrint(BCLog::INFO, "Using the wasm %s vm to execute the contracts\n", wasmVm);
+
+    // Make sure enough file descriptors are available, select() can not watch the sockets beyond FD_SETSIZE
     int32_t nBind   = max((int32_t)SysCfg().IsArgCount("-bind"), 1);
     nMaxConnections = SysCfg().GetArg("-maxconnections", 125);
-    nMaxConnections = max(min(nMaxConnections, (int32_t)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
+    if (socketEventsMode == "select")
+        nMaxConnections = max(min(nMaxConnections, (int32_t)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
+    else
+        nMaxConnections = max(nMaxConnections, 0);
     int32_t nFD     = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
@@ -541,6 +634,9 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetBenchMark(SysCfg().GetBoolArg("-benchmark", false));
     mempool.SetSanityCheck(SysCfg().GetBoolArg("-checkmempool", RegTest()));
+    wasm::wasm_interface::set_module_cache_size(std::min<int64_t>(std::max<int64_t>(0,
+        SysCfg().GetArg("-wasmmodulecache", DEFAULT_WASM_MODULE_CACHE_SIZE)), MAX_WASM_MODULE_CACHE_SIZE) << 20);
+    mempool.SetMaxSize(std::max<int64_t>(0, SysCfg().GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE)) * 1000000);
 
     setvbuf(stdout, nullptr, _IOLBF, 0);
 
@@ -562,6 +658,7 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     LogPrint(BCLog::INFO, "%s version %s (%s)\n", IniCfg().GetCoinName().c_str(), FormatFullVersion().c_str(), CLIENT_DATE);
     LogPrint(BCLog::INFO, "Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
+    LogPrint(BCLog::INFO, "Using the '%s' SHA256 implementation\n", sha256Algo);
 #ifdef USE_LUA
     LogPrint(BCLog::INFO, "Using Lua version %s\n", LUA_RELEASE);
 #endif
@@ -695,6 +792,15 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetGenReceipt(SysCfg().GetBoolArg("-genreceipt", false));
 
+    // -par=0 means autodetect, -par=-n leaves n cores free; the thread running ConnectBlock
+    // takes part in the checks, so one worker less than the requested parallelism is started.
+    int32_t nSigCheckThreads = SysCfg().GetArg("-par", DEFAULT_SIGCHECK_THREADS);
+    if (nSigCheckThreads <= 0)
+        nSigCheckThreads += std::thread::hardware_concurrency();
+    nSigCheckThreads = max(1, min(nSigCheckThreads, MAX_SIGCHECK_THREADS));
+    signatureCheckPool.Start("sigcheck", nSigCheckThreads - 1);
+    LogPrint(BCLog::INFO, "Using %d threads for signature verification\n", nSigCheckThreads);
+
     filesystem::path blocksDir = GetDataDir() / "blocks";
     if (!filesystem::exists(blocksDir)) {
         filesystem::create_directories(blocksDir);
@@ -708,6 +814,13 @@ bool AppInit(boost::thread_group &threadGroup) {
         std::cout << "load wallet failed: " << e.what() << std::endl;
     }
 
+    // cover the tx memory cache window and the mature block reward, with some more blocks for reorg
+    recentBlockCache.SetMaxCount(std::max<int32_t>(SysCfg().GetTxCacheHeight(), BLOCK_REWARD_MATURITY) +
+                                 RECENT_BLOCK_CACHE_EXTRA_COUNT);
+    blockUndoCache.SetMaxCount(std::max<int64_t>(0, SysCfg().GetArg("-undocache", DEFAULT_UNDO_CACHE_BLOCKS)));
+    int64_t nTxBodyCacheSize = SysCfg().GetArg("-txbodycache", DEFAULT_TX_BODY_CACHE_SIZE);
+    txBodyCache.SetMaxSize(std::min<int64_t>(std::max<int64_t>(0, nTxBodyCacheSize), 4095) << 20);
+
     int64_t nStart = GetTimeMillis();
     bool fLoaded   = false;
     while (!fLoaded) {
@@ -782,7 +895,9 @@ bool AppInit(boost::thread_group &threadGroup) {
         return false;
     }
 
-    LogPrint(BCLog::INFO, "Build %lu block indexes into memory (%lldms)\n", mapBlockIndex.size(), GetTimeMillis() - nStart);
+    LogPrint(BCLog::INFO, "Build %lu block indexes into memory (%lldms), map %llu bytes, arena %llu bytes\n",
+             mapBlockIndex.size(), GetTimeMillis() - nStart, GetBlockMapMemoryUsage(mapBlockIndex),
+             blockIndexArena.GetMemoryUsage());
 
     if (SysCfg().GetBoolArg("-printblockindex", false) || SysCfg().GetBoolArg("-printblocktree", false)) {
         PrintBlockTree();
@@ -792,7 +907,7 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (SysCfg().IsArgCount("-printblock")) {
         string strMatch = SysCfg().GetArg("-printblock", "");
         int32_t nFound  = 0;
-        for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+        for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
             uint256 hash = (*mi).first;
             if (strncmp(hash.ToString().c_str(), strMatch.c_str(), strMatch.size()) == 0) {
                 CBlockIndex *pIndex = (*mi).second;
@@ -816,26 +931,34 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (!ActivateBestChain(state))
         return InitError("Failed to connect best block");
 
-    nStart                   = GetTimeMillis();
-    CBlockIndex *pBlockIndex = chainActive.Tip();
-    int32_t nCacheHeight     = SysCfg().GetTxCacheHeight();
-    int32_t nCount           = 0;
-    CBlock block;
-    while (pBlockIndex && nCacheHeight-- > 0) {
-        if (!ReadBlockFromDisk(pBlockIndex, block))
-            return InitError("Failed to read block from disk");
-
-        if (!pCdMan->pTxCache->AddBlockTx(block))
-            return InitError("Failed to add block to transaction memory cache");
+    // load the memory caches from the snapshot of last clean shutdown, or rebuild them from the recent blocks
+    nStart = GetTimeMillis();
+    if (CMemCacheSnapshot(GetDataDir() / MEM_CACHE_SNAPSHOT_FILE).Load(chainActive.Tip(), *pCdMan)) {
+        LogPrint(BCLog::INFO, "Loaded memory caches from snapshot (%dms)\n", GetTimeMillis() - nStart);
+    } else {
+        CBlockIndex *pBlockIndex = chainActive.Tip();
+        int32_t nCacheHeight     = SysCfg().GetTxCacheHeight();
+        int32_t nCount           = 0;
+        CRecentBlockCache::InfoPtr pBlockInfo;
+        while (pBlockIndex && nCacheHeight-- > 0) {
+            if (!recentBlockCache.GetOrRead(pBlockIndex, pBlockInfo))
+                return InitError("Failed to read block from disk");
+
+            if (!pCdMan->pTxCache->AddBlockTx(pBlockInfo->txids))
+                return InitError("Failed to add block to transaction memory cache");
+
+            pBlockIndex = pBlockIndex->pprev;
+            ++nCount;
+        }
+        LogPrint(BCLog::INFO, "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
 
-        pBlockIndex = pBlockIndex->pprev;
-        ++nCount;
+        if (!pCdMan->pPpCache->ReleadBlocks(*pCdMan->pSysParamCache, chainActive.Tip())) {
+            return InitError("Init prices of PriceFeedMemCache failed");
+        }
+        LogPrint(BCLog::INFO, "Rebuilt memory caches from blocks (%dms)\n", GetTimeMillis() - nStart);
     }
-    LogPrint(BCLog::INFO, "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
 
-    if (!pCdMan->pPpCache->ReleadBlocks(*pCdMan->pSysParamCache, chainActive.Tip())) {
-        return InitError("Init prices of PriceFeedMemCache failed");
-    }
+    PreloadWasmModules();
 
     vector<boost::filesystem::path> vImportFiles;
     if (SysCfg().IsArgCount("-loadblock")) {
@@ -50,11 +50,16 @@ using namespace boost;
 CCacheDBManager *pCdMan = nullptr;
 CCriticalSection cs_main;
 CTxMemPool mempool;
-map<uint256, CBlockIndex *> mapBlockIndex;
+BlockMap mapBlockIndex;
+CBlockIndexArena blockIndexArena;
 int32_t nSyncTipHeight = 0;
 string publicIp;
 map<uint256/* blockhash */, std::shared_ptr<CCacheWrapper>> mapForkCache;
 CSignatureCache signatureCache;
+CWorkerPool signatureCheckPool;
+CRecentBlockCache recentBlockCache;
+CBlockUndoCache blockUndoCache;
+CTxBodyCache txBodyCache;
 CChainActive chainActive;
 CChain chainMostWork;
 // may contain all CBlockIndex*'s that have validness >=BLOCK_VALID_TRANSACTIONS, and must contain those who aren't
@@ -233,6 +238,50 @@ bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signatu
     return true;
 }
 
+// Verify the tx signatures of the block on signatureCheckPool and seed signatureCache with the valid ones,
+// so that the serial CheckAndExecuteTx() loop of ConnectBlock() only hits the cache.
+// A signature which can not be pre-checked against the current state (e.g. the signer is registered by a
+// previous tx of the same block) is simply left to the serial path.
+static void PreVerifyBlockSignatures(CBlock &block, CCacheWrapper &cw, int32_t height) {
+    if (signatureCheckPool.GetThreadCount() == 0 || GetFeatureForkVersion(height) < MAJOR_VER_R2)
+        return;
+
+    struct CSignatureCheck {
+        uint256 sigHash;
+        const UnsignedCharArray *pSignature;
+        CPubKey pubKey;
+    };
+
+    auto bm = MAKE_BENCHMARK("pre-verify signatures in ConnectBlock");
+    vector<CSignatureCheck> checks;
+    checks.reserve(block.vptx.size());
+    for (int32_t index = 1; index < (int32_t)block.vptx.size(); ++index) {
+        std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
+        // same exemptions as CBaseTx::CheckBaseTx()
+        if (pBaseTx->IsBlockRewardTx() || pBaseTx->IsPriceMedianTx() || pBaseTx->IsCoinMintTx() ||
+            pBaseTx->nTxType == CDP_FORCE_SETTLE_INTEREST_TX)
+            continue;
+
+        CPubKey pubKey;
+        if (pBaseTx->txUid.is<CPubKey>()) {
+            pubKey = pBaseTx->txUid.get<CPubKey>();
+        } else {
+            CAccount account;
+            if (!cw.accountCache.GetAccount(pBaseTx->txUid, account) || !account.IsRegistered())
+                continue;
+
+            pubKey = account.owner_pubkey;
+        }
+
+        checks.push_back({pBaseTx->GetHash(), &pBaseTx->signature, pubKey});
+    }
+
+    signatureCheckPool.Run(checks.size(), [&checks](size_t index) {
+        const CSignatureCheck &check = checks[index];
+        VerifySignature(check.sigHash, *check.pSignature, check.pubKey);
+    });
+}
+
 bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBaseTx,
                         bool fLimitFree, bool fRejectInsaneFee) {
     AssertLockHeld(cs_main);
@@ -255,8 +304,6 @@ bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBas
         return state.DoS(0, ERRORMSG("AcceptToMemoryPool() : txid: %s is nonstandard transaction due to %s",
                         hash.GetHex(), reason), REJECT_NONSTANDARD, reason);
 
-    auto spCW = std::make_shared<CCacheWrapper>(mempool.cw.get());
-
     CBlockIndex *pTip =  chainActive.Tip();
     if (pTip == nullptr) throw runtime_error("AcceptToMemoryPool(), pChainTip is nullptr");
     HeightType newHeight = pTip->height + 1;
@@ -266,8 +313,10 @@ bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBas
 
     {
         auto bm = MAKE_BENCHMARK("check tx before add mempool");
+        // check the tx on the mempool cache in place, the changes of checking are rolled back on leaving the scope
+        CCacheSavepoint savepoint(*mempool.cw);
         const auto &bpRegid = GetBlockBpRegid(*chainActive.TipBlock());
-        CTxExecuteContext context(newHeight, 0, fuelRate, blockTime, prevBlockTime, bpRegid, spCW.get(), &state);
+        CTxExecuteContext context(newHeight, 0, fuelRate, blockTime, prevBlockTime, bpRegid, mempool.cw.get(), &state);
         if (!pBaseTx->CheckBaseTx(context) || !pBaseTx->CheckTx(context))
             return ERRORMSG("AcceptToMemoryPool() : CheckBaseTx/CheckTx failed, txid: %s", hash.GetHex());
     }
@@ -339,15 +388,11 @@ bool GetTransaction(std::shared_ptr<CBaseTx> &pBaseTx, const uint256 &hash, CBlo
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos diskTxPos;
             if (blockCache.ReadTxIndex(hash, diskTxPos)) {
-                CAutoFile file(OpenBlockFile(diskTxPos, true), SER_DISK, CLIENT_VERSION);
-                CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file, diskTxPos.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
-                } catch (std::exception &e) {
-                    return ERRORMSG("Deserialize or I/O error - %s", e.what());
-                }
+                CTxBodyCache::InfoPtr pInfo;
+                if (!txBodyCache.GetOrRead(hash, diskTxPos, pInfo))
+                    return false;
+
+                pBaseTx = pInfo->tx;
                 return true;
             }
         }
@@ -594,8 +639,8 @@ bool ReconsiderBlock(CValidationState &state, CBlockIndex *pIndex, bool children
     AssertLockHeld(cs_main);
 
     // Remove the invalidity flag from this block and all its descendants.
-    map<uint256, CBlockIndex *>::const_iterator it = mapBlockIndex.begin();
-    int32_t height                                    = pIndex->height;
+    auto it        = mapBlockIndex.begin();
+    int32_t height = pIndex->height;
     if (children) {
         while (it != mapBlockIndex.end()) {
             if (it->second->nStatus & BLOCK_FAILED_MASK && it->second->GetAncestor(height) == pIndex) {
@@ -633,14 +678,11 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
 
     bool fClean = true;
 
-    CBlockUndo blockUndo;
-    CDiskBlockPos pos = pIndex->GetUndoPos();
-    if (pos.IsNull())
-        return ERRORMSG("no undo data available");
-
-    if (!blockUndo.ReadFromDisk(pos, pIndex->pprev->GetBlockHash()))
-        return ERRORMSG("failure reading undo data");
+    std::shared_ptr<const CBlockUndo> pBlockUndo;
+    if (!blockUndoCache.ReadBlockUndo(pIndex, pBlockUndo))
+        return ERRORMSG("failure reading undo data of block[%d]: %s", pIndex->height, pIndex->GetBlockHash().ToString());
 
+    const CBlockUndo &blockUndo = *pBlockUndo;
     if ((blockUndo.vtxundo.size() != block.vptx.size()) && (blockUndo.vtxundo.size() != (block.vptx.size() + 1)))
         return ERRORMSG("block and undo data inconsistent");
     CBlockUndoExecutor undoExecutor(cw, blockUndo);
@@ -664,12 +706,12 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
             pReLoadBlockIndex = pReLoadBlockIndex->pprev;
         }
 
-        CBlock reLoadblock;
-        if (!ReadBlockFromDisk(pReLoadBlockIndex, reLoadblock)) {
+        CRecentBlockCache::InfoPtr pReLoadBlockInfo;
+        if (!recentBlockCache.GetOrRead(pReLoadBlockIndex, pReLoadBlockInfo)) {
             return state.Abort(_("DisconnectBlock() : failed to read block"));
         }
 
-        if (!cw.txCache.AddBlockTx(reLoadblock)) {
+        if (!cw.txCache.AddBlockTx(pReLoadBlockInfo->txids)) {
             return state.Abort(_("DisconnectBlock() : failed to add block into transaction memory cache"));
         }
     }
@@ -1041,6 +1083,11 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     CBlockUndo blockUndo;
     std::vector<pair<uint256, CDiskTxPos> > vPos;
     vPos.reserve(block.vptx.size());
+    // the txs as stored in the block file for the lookups by txid, put into cache once the block is connected
+    bool fCacheTxBodies =
+        !fJustCheck && SysCfg().IsTxIndex() && txBodyCache.IsEnabled() && !IsInitialBlockDownload();
+    std::vector<CTxBodyCache::InfoPtr> txBodies;
+    std::shared_ptr<const CBlockHeader> pBlockHeader = fCacheTxBodies ? std::make_shared<CBlockHeader>(block) : nullptr;
 
     CDiskTxPos pos(pIndex->GetBlockPos(), GetSizeOfCompactSize(block.vptx.size()), CTxCord(pIndex->height, 0));
     CDiskTxPos rewardPos = pos;
@@ -1058,6 +1105,8 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         uint32_t fuelRate     = block.GetFuelRate();
         uint64_t totalFuel    = 0;
 
+        PreVerifyBlockSignatures(block, cw, pIndex->height);
+
         for (int32_t index = 1; index < (int32_t)block.vptx.size(); ++index) {
             auto bmTx = MAKE_BENCHMARK("execute tx in ConnectBlock");
             std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
@@ -1099,7 +1148,25 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             assert(fees >= fuelFee);
             rewards[fees_symbol] += (fees - fuelFee);
 
-            pos.nTxOffset += ::GetSerializeSize(pBaseTx, SER_DISK, CLIENT_VERSION);
+            uint32_t txSize = ::GetSerializeSize(pBaseTx, SER_DISK, CLIENT_VERSION);
+            if (fCacheTxBodies) {
+                // a copy of the tx without the state of its execution, which is kept in memory only
+                auto pTx       = pBaseTx->GetNewInstance();
+                pTx->txCord    = CTxCord();
+                pTx->fuel      = 0;
+                pTx->nFuelRate = 0;
+                pTx->account_map.clear();
+                pTx->sp_tx_account = nullptr;
+                pTx->receipts.clear();
+
+                auto pInfo    = std::make_shared<CTxBodyInfo>();
+                pInfo->tx     = pTx;
+                pInfo->header = pBlockHeader;
+                pInfo->size   = txSize;
+                pInfo->pos    = pos;
+                txBodies.push_back(pInfo);
+            }
+            pos.nTxOffset += txSize;
         }
     }
 
@@ -1185,16 +1252,18 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         }
 
         if (nullptr != pMatureIndex) {
-            CBlock matureBlock;
-            if (!ReadBlockFromDisk(pMatureIndex, matureBlock)) {
+            CRecentBlockCache::InfoPtr pMatureBlockInfo;
+            if (!recentBlockCache.GetOrRead(pMatureIndex, pMatureBlockInfo) || !pMatureBlockInfo->reward_tx) {
                 return state.Abort(_("ConnectBlock() : read mature block error"));
             }
+            // execute a copy, the cached reward tx is shared
+            auto pMatureRewardTx = pMatureBlockInfo->reward_tx->GetNewInstance();
 
             uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
             CTxExecuteContext context(pIndex->height, -1, pIndex->nFuelRate, pIndex->nTime, prevBlockTime, bpRegid,  &cw, &state);
             CTxUndoOpLogger rewardOpLogger(cw, block.vptx[0]->GetHash(), blockUndo);
-            if (!matureBlock.vptx[0]->ExecuteFullTx(context)) {
-                pCdMan->pLogCache->SetExecuteFail(pIndex->height, matureBlock.vptx[0]->GetHash(), state.GetRejectCode(),
+            if (!pMatureRewardTx->ExecuteFullTx(context)) {
+                pCdMan->pLogCache->SetExecuteFail(pIndex->height, pMatureRewardTx->GetHash(), state.GetRejectCode(),
                                                   state.GetRejectReason());
                 return state.DoS(100, ERRORMSG("execute mature block reward tx error"));
             }
@@ -1243,6 +1312,11 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     if (!cw.txCache.AddBlockTx(block)) {
         return state.Abort(_("ConnectBlock() : failed add block into transaction memory cache"));
     }
+    // keep the data needed when the block becomes old, to avoid reading it from disk again
+    recentBlockCache.Put(pIndex, block);
+    blockUndoCache.Put(pIndex, block, blockUndo);
+    for (const auto &pInfo : txBodies)
+        txBodyCache.Put(pInfo->tx->GetHash(), pInfo);
 
     if (pIndex->height > SysCfg().GetTxCacheHeight()) {
         CBlockIndex *pDeleteBlockIndex = pIndex;
@@ -1251,12 +1325,12 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             pDeleteBlockIndex = pDeleteBlockIndex->pprev;
         }
 
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
+        CRecentBlockCache::InfoPtr pDeleteBlockInfo;
+        if (!recentBlockCache.GetOrRead(pDeleteBlockIndex, pDeleteBlockInfo)) {
             return state.Abort(_("ConnectBlock() : failed to read block"));
         }
 
-        if (!cw.txCache.RemoveBlockTx(deleteBlock)) {
+        if (!cw.txCache.RemoveBlockTx(pDeleteBlockInfo->txids)) {
             return state.Abort(_("ConnectBlock() : failed delete block from transaction memory cache"));
         }
     }
@@ -1305,6 +1379,41 @@ bool static WriteChainState(CValidationState &state) {
     return true;
 }
 
+// the copies of the top level caches grow with the blocks not flushed during the initial block download,
+// so the state view is refreshed at this interval at most
+static const int64_t STATE_VIEW_IBD_REFRESH_INTERVAL = 1000;  // in milliseconds
+
+static CCriticalSection cs_stateView;
+static std::shared_ptr<CStateView> pStateView;
+
+std::shared_ptr<CStateView> GetStateView() {
+    {
+        TRY_LOCK(cs_main, lockMain);
+        if (!lockMain) {
+            // do not wait for the block being connected, the view of the last block is still consistent
+            LOCK(cs_stateView);
+            if (pStateView != nullptr)
+                return pStateView;
+        }
+    }
+
+    LOCK2(cs_main, cs_stateView);
+    CBlockIndex *pTip = chainActive.Tip();
+    assert(pTip != nullptr);
+    if (pStateView != nullptr && (pStateView->GetBlockHash() == pTip->GetBlockHash() ||
+        (IsInitialBlockDownload() &&
+         GetTimeMillis() < pStateView->GetCreateTime() + STATE_VIEW_IBD_REFRESH_INTERVAL)))
+        return pStateView;
+
+    pStateView = std::make_shared<CStateView>(pCdMan, pTip->GetBlockHash(), pTip->height);
+    return pStateView;
+}
+
+void ReleaseStateView() {
+    LOCK(cs_stateView);
+    pStateView = nullptr;
+}
+
 // Update chainActive and related internal data structures.
 void static UpdateTip(CBlockIndex *pIndexNew, const CBlock &block) {
     chainActive.SetTip(pIndexNew, &block);
@@ -1347,7 +1456,7 @@ bool DisconnectTip(CValidationState &state) {
     assert(pBlockIndexToDelete);
     // Read block from disk.
     CBlock block;
-    if (!ReadBlockFromDisk(pBlockIndexToDelete, block))
+    if (!blockUndoCache.ReadBlock(pBlockIndexToDelete, block))
         return state.Abort(_("Failed to read blocks from disk."));
     // Apply the block atomically to the chain state.
     auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
@@ -1362,7 +1471,7 @@ bool DisconnectTip(CValidationState &state) {
     CBlockIndex *pPreBlockIndex = pBlockIndexToDelete->pprev;
     CBlock preBlock;
     if (pPreBlockIndex) {
-        if (!ReadBlockFromDisk(pPreBlockIndex, preBlock))
+        if (!blockUndoCache.ReadBlock(pPreBlockIndex, preBlock))
             return ERRORMSG("failed to read block [%d]: %s", pPreBlockIndex->height,
                             pPreBlockIndex->GetBlockHash().ToString());
     }
@@ -1394,7 +1503,7 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
     assert(pIndexNew->pprev == chainActive.Tip());
     // Read block from disk.
     CBlock block;
-    if (!ReadBlockFromDisk(pIndexNew, block))
+    if (!blockUndoCache.ReadBlock(pIndexNew, block))
         return state.Abort(strprintf("Failed to read block hash: %s", pIndexNew->GetBlockHash().GetHex()));
 
     // Apply the block automatically to the chain state.
@@ -1424,9 +1533,7 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
     // Update chainActive & related variables.
     UpdateTip(pIndexNew, block);
 
-    for (auto &pTxItem : block.vptx) {
-        mempool.memPoolTxs.erase(pTxItem->GetHash());
-    }
+    mempool.RemoveForBlock(block.vptx);
     return true;
 }
 
@@ -1594,17 +1701,16 @@ bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos
         return state.Invalid(ERRORMSG("AddToBlockIndex() : %s already exists", block.GetIdStr()), 0, "duplicate");
 
     // Construct new block index object
-    CBlockIndex *pIndexNew = new CBlockIndex(block);
-
-    assert(pIndexNew);
+    CBlockIndex *pIndexNew = blockIndexArena.Allocate();
+    *pIndexNew             = CBlockIndex(block);
     {
         LOCK(cs_nBlockSequenceId);
         pIndexNew->nSequenceId = nBlockSequenceId++;
     }
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
+    auto mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
     // LogPrint(BCLog::INFO, "in map hash:%s map size:%d\n", hash.GetHex(), mapBlockIndex.size());
-    pIndexNew->pBlockHash                        = &((*mi).first);
-    map<uint256, CBlockIndex *>::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
+    pIndexNew->pBlockHash = &((*mi).first);
+    auto miPrev           = mapBlockIndex.find(block.GetPrevBlockHash());
     if (miPrev != mapBlockIndex.end()) {
         pIndexNew->pprev  = (*miPrev).second;
         pIndexNew->height = pIndexNew->pprev->height + 1;
@@ -1715,7 +1821,7 @@ bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValid
                          pPreBlockIndex->height, forkChainTipBlockHash.GetHex());
             } else {
                 CBlock block;
-                if (!ReadBlockFromDisk(pPreBlockIndex, block))
+                if (!blockUndoCache.ReadBlock(pPreBlockIndex, block))
                     return state.Abort(_("Failed to read block"));
 
                 // Reserve the forked chain's blocks.
@@ -1756,7 +1862,7 @@ bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValid
                      pBlockIndex->GetBlockHash().GetHex());
 
             CBlock block;
-            if (!ReadBlockFromDisk(pBlockIndex, block))
+            if (!blockUndoCache.ReadBlock(pBlockIndex, block))
                 return state.Abort(_("Failed to read block"));
 
             bool bfClean = true;
@@ -1900,7 +2006,7 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex *pPrevBlockIndex = nullptr;
     int32_t height = 0;
     if (block.GetHeight() != 0 || blockHash != SysCfg().GetGenesisBlockHash()) {
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
+        BlockMap::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
         if (mi == mapBlockIndex.end())
             return state.DoS(10, ERRORMSG("[%d] prev block not found", blockHeight), 0, "bad-prevblk");
 
@@ -1960,17 +2066,28 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex* pTip = chainActive.Tip();
     if (pTip->GetBlockHash() == blockHash) {
         {
+            // the mined block is pushed to the peers at once, as a compact block to the peers rebuilding it from
+            // their mempools
+            std::unique_ptr<CCompactBlock> pCmpctBlock;
+            if (mining && SysCfg().GetBoolArg("-compactblocks", true))
+                pCmpctBlock.reset(new CCompactBlock(block));
+
             LOCK(cs_vNodes);
             for (auto pNode : vNodes) {
                 //p2p_xiaoyu_20191116
                 if (mining) {
-                    pNode->PushMessage(NetMsgType::BLOCK, block);
+                    if (pCmpctBlock && pNode->fCompactBlocks)
+                        pNode->PushMessage(NetMsgType::CMPCTBLOCK, *pCmpctBlock);
+                    else
+                        pNode->PushMessage(NetMsgType::BLOCK, block);
                     continue;
                 }
                 if (chainActive.Height() > (pNode->nStartingHeight != -1 ? pNode->nStartingHeight - 2000 : 0))
                     pNode->PushInventory(CInv(MSG_BLOCK, blockHash));
             }
         }
+        // send the inventory at once rather than on the next poll of the message handler
+        WakeMessageHandler();
 
         VoteDelegateVector delegates;
         if (pCdMan->pDelegateCache->GetActiveDelegates(delegates)) {
@@ -2056,54 +2173,43 @@ void CBlockIndex::BuildSkip() {
         pskip = pprev->GetAncestor(GetSkipHeight(height));
 }
 
-void PushGetBlocks(CNode *pNode, CBlockIndex *pIndexBegin, uint256 hashEnd) {
-    // Ask this guy to fill in what we're missing
-    AssertLockHeld(cs_main);
-    // Filter out duplicate requests
-    if (pIndexBegin == pNode->pIndexLastGetBlocksBegin && hashEnd == pNode->hashLastGetBlocksEnd) {
-        LogPrint(BCLog::NET, "filter the same GetLocator from peer %s\n", pNode->addr.ToString());
+void BuildSkipList(const vector<pair<int32_t, CBlockIndex *>> &sortedByHeight, CWorkerPool &workerPool) {
+    if (sortedByHeight.empty())
         return;
+
+    // the indexes on the branch of the highest one take their skip targets by height, which is done in parallel
+    CBlockIndex *pHighest = sortedByHeight.back().second;
+    vector<CBlockIndex *> branch(pHighest->height + 1, nullptr);
+    for (CBlockIndex *pIndex = pHighest; pIndex && pIndex->height >= 0 && pIndex->height < (int32_t)branch.size() &&
+                                         branch[pIndex->height] == nullptr;
+         pIndex = pIndex->pprev) {
+        branch[pIndex->height] = pIndex;
     }
-    pNode->pIndexLastGetBlocksBegin = pIndexBegin;
-    pNode->hashLastGetBlocksEnd     = hashEnd;
-    CBlockLocator blockLocator      = chainActive.GetLocator(pIndexBegin);
-    pNode->PushMessage(NetMsgType::GETBLOCKS, blockLocator, hashEnd);
-    LogPrint(BCLog::NET, "getblocks from peer %s, hashEnd:%s\n", pNode->addr.ToString(), hashEnd.GetHex());
-}
 
-void PushGetBlocksOnCondition(CNode *pNode, CBlockIndex *pIndexBegin, uint256 hashEnd) {
-    // Ask this guy to fill in what we're missing
-    AssertLockHeld(cs_main);
-    // Filter out duplicate requests
-    if (pIndexBegin == pNode->pIndexLastGetBlocksBegin && hashEnd == pNode->hashLastGetBlocksEnd) {
-        LogPrint(BCLog::NET, "filter the same GetLocator from peer %s\n", pNode->addr.ToString());
-        static CBloomFilter filter(5000, 0.0001, 0, BLOOM_UPDATE_NONE);
-        static uint32_t count = 0;
-        string key            = to_string(pNode->id) + ":" + to_string((GetTime() / 2));
-        if (!filter.contains(vector<uint8_t>(key.begin(), key.end()))) {
-            filter.insert(vector<uint8_t>(key.begin(), key.end()));
-            ++count;
-            pNode->pIndexLastGetBlocksBegin = pIndexBegin;
-            pNode->hashLastGetBlocksEnd     = hashEnd;
-            CBlockLocator blockLocator      = chainActive.GetLocator(pIndexBegin);
-            pNode->PushMessage(NetMsgType::GETBLOCKS, blockLocator, hashEnd);
-            LogPrint(BCLog::NET, "getblocks from peer %s, hashEnd:%s\n", pNode->addr.ToString(), hashEnd.GetHex());
-        } else {
-            if (count >= 5000) {
-                count = 0;
-                filter.Clear();
-            }
+    auto IsOnBranch = [&branch](const CBlockIndex *pIndex) {
+        return pIndex->height >= 0 && branch[pIndex->height] == pIndex &&
+               branch[GetSkipHeight(pIndex->height)] != nullptr;
+    };
+
+    static const size_t BATCH_SIZE = 10000;
+    size_t count                   = sortedByHeight.size();
+    workerPool.Run((count + BATCH_SIZE - 1) / BATCH_SIZE, [&](size_t batch) {
+        for (size_t i = batch * BATCH_SIZE; i < std::min(count, (batch + 1) * BATCH_SIZE); i++) {
+            CBlockIndex *pIndex = sortedByHeight[i].second;
+            if (pIndex->pprev && IsOnBranch(pIndex))
+                pIndex->pskip = branch[GetSkipHeight(pIndex->height)];
         }
-    } else {
-        pNode->pIndexLastGetBlocksBegin = pIndexBegin;
-        pNode->hashLastGetBlocksEnd     = hashEnd;
-        CBlockLocator blockLocator      = chainActive.GetLocator(pIndexBegin);
-        pNode->PushMessage(NetMsgType::GETBLOCKS, blockLocator, hashEnd);
-        LogPrint(BCLog::NET, "getblocks from peer %s, hashEnd:%s\n", pNode->addr.ToString(), hashEnd.GetHex());
+    });
+
+    // the forks in height order, whose ancestors have got their skip pointers already
+    for (const auto &item : sortedByHeight) {
+        CBlockIndex *pIndex = item.second;
+        if (pIndex->pprev && !IsOnBranch(pIndex))
+            pIndex->BuildSkip();
     }
 }
 
-bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBlockPos *dbp) {
+bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBlockPos *dbp, bool mining) {
     int64_t llBeginTime = GetTimeMillis();
     // LogPrint(BCLog::INFO, "ProcessBlock() enter:%lld\n", llBeginTime);
     AssertLockHeld(cs_main);
@@ -2152,19 +2258,18 @@ bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBl
 
             // Ask this guy to fill in what we're missing
             LogPrint(BCLog::NET,
-                     "receive an orphan block height=%d hash=%s, %s it, leading to getblocks (current block height=%d, "
+                     "receive an orphan block height=%d hash=%s, %s it, leading to getheaders (current block height=%d, "
                      "current block hash=%s, orphan blocks=%d)\n",
                      pBlock->GetHeight(), pBlock->GetHash().GetHex(), success ? "keep" : "abandon",
                      chainActive.Height(), chainActive.Tip()->GetBlockHash().GetHex(), mapOrphanBlocksByPrev.size());
 
-            PushGetBlocksOnCondition(pFrom, chainActive.Tip(), GetOrphanRoot(blockHash));
+            PushGetHeaders(pFrom);
         }
         return true;
     }
 
     int64_t llAcceptBlockTime = GetTimeMillis();
 
-    bool mining = (pFrom)?false:true;
     // Store to disk
     if (!AcceptBlock(*pBlock, state, dbp, mining)) {
         LogPrint(BCLog::DEBUG, "[%d] AcceptBlock() elapse time: %lld ms\n", blockHeight, GetTimeMillis() - llAcceptBlockTime);
@@ -2223,9 +2328,12 @@ bool CheckDiskSpace(uint64_t nAdditionalBytes) {
 }
 
 bool static LoadBlockIndexDB() {
-    if (!pCdMan->pBlockIndexDb->LoadBlockIndexes())
+    // the signature check workers are idle until the blocks are connected
+    int64_t beginTime = GetTimeMillis();
+    if (!pCdMan->pBlockIndexDb->LoadBlockIndexes(signatureCheckPool))
         return ERRORMSG("%s(), LoadBlockIndexes from db failed", __FUNCTION__);
 
+    int64_t loadedTime = GetTimeMillis();
     boost::this_thread::interruption_point();
 
     vector<pair<int32_t, CBlockIndex *> > vSortedByHeight;
@@ -2235,6 +2343,7 @@ bool static LoadBlockIndexDB() {
         vSortedByHeight.push_back(make_pair(pIndex->height, pIndex));
     }
     sort(vSortedByHeight.begin(), vSortedByHeight.end());
+    BuildSkipList(vSortedByHeight, signatureCheckPool);
     for (const auto &item : vSortedByHeight) {
         CBlockIndex *pIndex = item.second;
         if ((pIndex->nStatus & BLOCK_VALID_MASK) >= BLOCK_VALID_TRANSACTIONS && !(pIndex->nStatus & BLOCK_FAILED_MASK))
@@ -2242,9 +2351,10 @@ bool static LoadBlockIndexDB() {
         if (pIndex->nStatus & BLOCK_FAILED_MASK &&
             (pIndexBestInvalid == nullptr || pIndex->height > pIndexBestInvalid->height))
             pIndexBestInvalid = pIndex;
-        if (pIndex->pprev)
-            pIndex->BuildSkip();
     }
+    LogPrint(BCLog::INFO, "loaded %u block indexes in %lldms on %u threads, indexed them in %lldms\n",
+             mapBlockIndex.size(), loadedTime - beginTime, signatureCheckPool.GetThreadCount() + 1,
+             GetTimeMillis() - loadedTime);
 
     // Load block file info
     pCdMan->pBlockCache->ReadLastBlockFile(nLastBlockFile);
@@ -2379,9 +2489,13 @@ bool VerifyDB(int32_t nCheckLevel, int32_t nCheckDepth) {
 
 void UnloadBlockIndex() {
     mapBlockIndex.clear();
+    blockIndexArena.Clear();
     setBlockIndexValid.clear();
     chainActive.SetTip(nullptr, nullptr);
     pIndexBestInvalid = nullptr;
+    recentBlockCache.Clear();
+    blockUndoCache.Clear();
+    txBodyCache.Clear();
 }
 
 bool LoadBlockIndex() {
@@ -2432,7 +2546,7 @@ void PrintBlockTree() {
     AssertLockHeld(cs_main);
     // pre-compute tree structure
     map<CBlockIndex *, vector<CBlockIndex *> > mapNext;
-    for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+    for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
         CBlockIndex *pIndex = (*mi).second;
         mapNext[pIndex->pprev].push_back(pIndex);
     }
@@ -2613,10 +2727,8 @@ class CMainCleanup {
     CMainCleanup() {}
     ~CMainCleanup() {
         // block headers
-        map<uint256, CBlockIndex *>::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
         mapBlockIndex.clear();
+        blockIndexArena.Clear();
 
         // orphan blocks
         map<uint256, COrphanBlock *>::iterator it2 = mapOrphanBlocks.begin();
@@ -27,12 +27,14 @@
 #include "config/errorcode.h"
 #include "chain/chain.h"
 #include "chain/merkletree.h"
+#include "commons/workerpool.h"
 #include "persistence/cachewrapper.h"
 #include "sigcache.h"
 #include "tx/tx.h"
 #include "tx/txmempool.h"
 //#include "tx/txserializer.h"
 
+class CBlockUndoCache;
 class CBloomFilter;
 class CChain;
 class CInv;
@@ -41,9 +43,18 @@ extern CCriticalSection cs_main;
 /** The currently-connected chain of blocks. */
 extern CChainActive chainActive;
 extern CSignatureCache signatureCache;
+/** Worker threads to pre-verify block tx signatures in parallel, sized by -par */
+extern CWorkerPool signatureCheckPool;
+/** The recently connected blocks needed by the mature block reward and the tx memory cache window */
+extern CRecentBlockCache recentBlockCache;
+/** The blocks and the undo data of the recently connected blocks to disconnect and reconnect them in memory */
+extern CBlockUndoCache blockUndoCache;
+/** The confirmed txs looked up by txid, by the contracts and the rpc */
+extern CTxBodyCache txBodyCache;
 
 extern CTxMemPool mempool;
-extern map<uint256, CBlockIndex *> mapBlockIndex;
+extern BlockMap mapBlockIndex;
+extern CBlockIndexArena blockIndexArena;
 extern uint64_t nLastBlockTx;
 extern uint64_t nLastBlockSize;
 extern const string strMessageMagic;
@@ -240,12 +251,15 @@ bool InitBlockIndex();
 bool LoadBlockIndex();
 /** Unload database information */
 void UnloadBlockIndex();
-/** Push getblocks request */
-void PushGetBlocks(CNode *pNode, CBlockIndex *pindexBegin, uint256 hashEnd);
-/** Push getblocks request with different filtering strategies */
-void PushGetBlocksOnCondition(CNode *pNode, CBlockIndex *pindexBegin, uint256 hashEnd);
-/** Process an incoming block */
-bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBlockPos *dbp = nullptr);
+/** The read only state of the tip for the queries without cs_main, it is of the last block while a block is being connected */
+std::shared_ptr<CStateView> GetStateView();
+/** Release the state view before the state dbs are closed */
+void ReleaseStateView();
+/** Build the skip pointers of the block indexes sorted by height, mostly in parallel on the worker pool */
+void BuildSkipList(const vector<pair<int32_t, CBlockIndex *>> &sortedByHeight, CWorkerPool &workerPool);
+/** Process an incoming block, the block mined by this node is pushed to the peers instead of announced */
+bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBlockPos *dbp = nullptr,
+                  bool mining = false);
 /** Print the loaded block tree */
 void PrintBlockTree();
 
@@ -87,24 +87,16 @@ uint32_t GetElementForBurn(CBlockIndex *pIndex) {
     return newFuelRate;
 }
 
-// Sort transactions by priority and fee to decide priority orders to process transactions.
+// Collect transactions from the priority index of the memory pool, which already keeps them in the priority
+// orders to process transactions, so they are appended in order without sorting again.
 void GetPriorityTx(CCacheWrapper &cw, int32_t height, set<TxPriority> &txPriorities, const int32_t nFuelRate) {
-    static TokenSymbol feeSymbol;
-    static uint64_t fee    = 0;
-    static uint32_t txSize = 0;
-    static double feePerKb = 0;
-    static double priority = 0;
-
-    for (map<uint256, CTxMemPoolEntry>::iterator mi = mempool.memPoolTxs.begin(); mi != mempool.memPoolTxs.end(); ++mi) {
-        CBaseTx *pBaseTx = mi->second.GetTransaction().get();
-        if (!pBaseTx->IsBlockRewardTx() && !pCdMan->pTxCache->HasTx(pBaseTx->GetHash())) {
-            feeSymbol = std::get<0>(mi->second.GetFees());
-            fee       = std::get<1>(mi->second.GetFees());
-            txSize    = mi->second.GetTxSize();
-            feePerKb  = double(fee - pBaseTx->GetFuelFee(cw, height, nFuelRate)) / txSize * 1000.0;
-            priority  = mi->second.GetPriority();
-
-            txPriorities.emplace(TxPriority(priority, feePerKb, mi->second.GetTransaction()));
+    AssertLockHeld(mempool.cs);
+
+    for (const auto &key : mempool.priorityIndex) {
+        const CTxMemPoolEntry &entry = mempool.memPoolTxs.at(key.txid);
+        const auto &spBaseTx         = entry.GetTransaction();
+        if (!spBaseTx->IsBlockRewardTx() && !pCdMan->pTxCache->HasTx(key.txid)) {
+            txPriorities.emplace_hint(txPriorities.end(), entry.GetPriority(), key.feePerKb, spBaseTx);
         }
     }
 }
@@ -336,7 +328,8 @@ static bool CreateNewBlockForPreStableCoinRelease(Miner &miner, CCacheWrapper &c
                 continue;
             }
 
-            auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
+            // execute the tx in place, its changes are rolled back unless committed
+            CCacheSavepoint savepoint(cwIn);
 
             try {
                 auto bm = MAKE_BENCHMARK("execute tx in mining block");
@@ -344,7 +337,7 @@ static bool CreateNewBlockForPreStableCoinRelease(Miner &miner, CCacheWrapper &c
                 pBaseTx->nFuelRate = fuelRate;
                 uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
                 CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime,
-                                          miner.account.regid, spCW.get(), &state,
+                                          miner.account.regid, &cwIn, &state,
                                           TxExecuteContextType::PRODUCE_BLOCK);
 
                 if (!pBaseTx->CheckAndExecuteTx(context)) {
@@ -365,7 +358,7 @@ static bool CreateNewBlockForPreStableCoinRelease(Miner &miner, CCacheWrapper &c
                 continue;
             }
 
-            spCW->Flush();
+            savepoint.Commit();
 
             auto fuelFee     = pBaseTx->GetFuelFee(cwIn, height, fuelRate);
             auto fees_symbol = std::get<0>(pBaseTx->GetFees());
@@ -491,7 +484,8 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
                 continue;
             }
 
-            auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
+            // execute the tx in place, its changes are rolled back unless committed
+            CCacheSavepoint savepoint(cwIn);
 
             try {
                 auto bm = MAKE_BENCHMARK("execute tx in mining block");
@@ -502,19 +496,19 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
                 // Special case for price median tx,
                 if (pBaseTx->IsPriceMedianTx()) {
                     CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)itor->baseTx.get();
-                    if (!spCW->ppCache.CalcMedianPrices(*spCW, height, pPriceMedianTx->median_prices))
+                    if (!cwIn.ppCache.CalcMedianPrices(cwIn, height, pPriceMedianTx->median_prices))
                         return ERRORMSG("calculate block median prices error");
                 }
 
-                LogPrint(BCLog::MINER, "begin to pack trx: %s\n", pBaseTx->ToString(spCW->accountCache));
+                LogPrint(BCLog::MINER, "begin to pack trx: %s\n", pBaseTx->ToString(cwIn.accountCache));
 
                 uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
                 CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime,
-                                          miner.account.regid, spCW.get(), &state,
+                                          miner.account.regid, &cwIn, &state,
                                           TxExecuteContextType::PRODUCE_BLOCK);
 
                 if (!pBaseTx->CheckAndExecuteTx(context)) {
-                    LogPrint(BCLog::MINER, "failed to check/exec tx: %s\n", pBaseTx->ToString(spCW->accountCache));
+                    LogPrint(BCLog::MINER, "failed to check/exec tx: %s\n", pBaseTx->ToString(cwIn.accountCache));
 
                     pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(), state.GetRejectReason());
                     continue;
@@ -531,7 +525,7 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
                 continue;
             }
 
-            spCW->Flush();
+            savepoint.Commit();
 
             auto fuelFee        = pBaseTx->GetFuelFee(cwIn, height, fuelRate);
             auto fees_symbol = std::get<0>(pBaseTx->GetFees());
@@ -596,7 +590,7 @@ bool CheckWork(CBlock *pBlock) {
 
     // Process this block the same as if we received it from another node
     CValidationState state;
-    if (!ProcessBlock(state, nullptr, pBlock))
+    if (!ProcessBlock(state, nullptr, pBlock, nullptr, true))
         return ERRORMSG("failed to process block");
 
     return true;
@@ -16,6 +16,7 @@
 #include "entities/key.h"
 #include "commons/uint256.h"
 #include "tx/tx.h"
+#include "tx/txmempool.h"
 
 class CBlock;
 class CBlockIndex;
@@ -47,16 +48,15 @@ struct TxPriority {
     TxPriority(const double priorityIn, const double feePerKbIn, const std::shared_ptr<CBaseTx> &baseTxIn)
         : priority(priorityIn), feePerKb(feePerKbIn), baseTx(baseTxIn) {}
 
+    // the same orders as the mempool priority index
     bool operator<(const TxPriority &other) const {
-        if (fabs(this->priority - other.priority) <= 1000) {
-            if (fabs(this->feePerKb < other.feePerKb) <= 1e-8) {
-                return this->baseTx->GetHash() < other.baseTx->GetHash();
-            } else {
-                return this->feePerKb < other.feePerKb;
-            }
-        } else {
-            return this->priority < other.priority;
-        }
+        int32_t level      = CTxMemPoolPriorityKey::GetPriorityLevel(this->priority);
+        int32_t otherLevel = CTxMemPoolPriorityKey::GetPriorityLevel(other.priority);
+        if (level != otherLevel)
+            return level < otherLevel;
+        if (this->feePerKb != other.feePerKb)
+            return this->feePerKb < other.feePerKb;
+        return this->baseTx->GetHash() < other.baseTx->GetHash();
     }
 };
 
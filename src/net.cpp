@@ -15,6 +15,7 @@
 #include "tx/tx.h"
 #include "commons/util/time.h"
 #include "p2p/node.h"
+#include "p2p/socketevents.h"
 
 #ifdef WIN32
 #include <string.h>
@@ -35,8 +36,11 @@
 
 #include <fstream>
 #include <sstream>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_set>
 
 #include <boost/filesystem.hpp>
 
@@ -51,6 +55,8 @@ using namespace std;
 using namespace boost;
 
 static const int32_t MAX_OUTBOUND_CONNECTIONS = 8;
+/** The max time in milliseconds that the message handler waits for a wakeup before polling the nodes again */
+static const int32_t MESSAGE_HANDLER_POLL_INTERVAL = 100;
 
 bool OpenNetworkConnection(const CAddress& addrConnect, CSemaphoreGrant* grantOutbound = nullptr,
                            const char* strDest = nullptr, bool fOneShot = false);
@@ -68,10 +74,16 @@ static CNode* pnodeLocalHost     = nullptr;
 extern CNode* pnodeSync;
 
 static vector<SOCKET> vhListenSocket;
+static std::unique_ptr<CSocketEvents> pSocketEvents;  // waits for the sockets in the socket handler
 CAddrMan addrman;
 int32_t nMaxConnections = 125;
 string ipHost = "";
 
+// Wakeup of the message handler thread
+static std::mutex mutexMsgProc;
+static std::condition_variable condMsgProc;
+static bool fMsgProcWake = false;
+
 // Signals for message handling
 static CNodeSignals g_node_signals;
 CNodeSignals& GetNodeSignals() { return g_node_signals; }
@@ -541,24 +553,11 @@ void ThreadSocketHandler() {
         //
         // Find which sockets have data to receive
         //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000;  // frequency to poll pNode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds     = false;
-
-        for (auto hListenSocket : vhListenSocket) {
-            FD_SET(hListenSocket, &fdsetRecv);
-            hSocketMax = max(hSocketMax, hListenSocket);
-            have_fds   = true;
-        }
+        bool fEdgeTriggered = pSocketEvents->IsEdgeTriggered();
+        bool fHaveReadyNode = false;  // any node is known to be ready by the edge-triggered events
+        vector<SOCKET> vRecvWanted(vhListenSocket.begin(), vhListenSocket.end());
+        vector<SOCKET> vSendWanted;
+        unordered_set<SOCKET> setRecvWanted;
 
         {
             LOCK(cs_vNodes);
@@ -566,9 +565,16 @@ void ThreadSocketHandler() {
                 if (pNode->hSocket == INVALID_SOCKET)
                     continue;
 
-                FD_SET(pNode->hSocket, &fdsetError);
-                hSocketMax = max(hSocketMax, pNode->hSocket);
-                have_fds   = true;
+                // watch the new socket, it may already have data before being watched
+                if (fEdgeTriggered && pNode->hSocketEvents != pNode->hSocket) {
+                    if (!pSocketEvents->AddSocket(pNode->hSocket, false)) {
+                        pNode->CloseSocketDisconnect();
+                        continue;
+                    }
+                    pNode->hSocketEvents = pNode->hSocket;
+                    pNode->fHasRecvData  = true;
+                    pNode->fCanSendData  = true;
+                }
 
                 // Implement the following logic:
                 // * If there is data to send, select() for sending data. As this only
@@ -588,39 +594,39 @@ void ThreadSocketHandler() {
                 {
                     TRY_LOCK(pNode->cs_vSend, lockSend);
                     if (lockSend && !pNode->vSendMsg.empty()) {
-                        FD_SET(pNode->hSocket, &fdsetSend);
+                        vSendWanted.push_back(pNode->hSocket);
+                        fHaveReadyNode |= fEdgeTriggered && pNode->fCanSendData;
                         continue;
                     }
                 }
                 {
                     TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
                     if (lockRecv && (pNode->vRecvMsg.empty() || !pNode->vRecvMsg.front().complete() ||
-                                     pNode->GetTotalRecvSize() <= ReceiveFloodSize()))
-                        FD_SET(pNode->hSocket, &fdsetRecv);
+                                     pNode->GetTotalRecvSize() <= ReceiveFloodSize())) {
+                        vRecvWanted.push_back(pNode->hSocket);
+                        setRecvWanted.insert(pNode->hSocket);
+                        fHaveReadyNode |= fEdgeTriggered && pNode->fHasRecvData;
+                    }
                 }
             }
         }
 
-        int32_t nSelect = select(have_fds ? hSocketMax + 1 : 0, &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        boost::this_thread::interruption_point();
-
-        if (nSelect == SOCKET_ERROR) {
-            if (have_fds) {
-                int32_t nErr = WSAGetLastError();
-                LogPrint(BCLog::INFO, "socket select error %s\n", NetworkErrorString(nErr));
-                for (uint32_t i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            MilliSleep(timeout.tv_usec / 1000);
+        // frequency to poll pNode->vSend, do not wait if some node is ready already
+        int64_t nTimeout = fHaveReadyNode ? 0 : 50;
+        unordered_set<SOCKET> setRecvReady;
+        unordered_set<SOCKET> setSendReady;
+        if (!pSocketEvents->Wait(nTimeout, vRecvWanted, vSendWanted, setRecvReady, setSendReady)) {
+            setRecvReady.insert(vRecvWanted.begin(), vRecvWanted.end());
+            setSendReady.clear();
+            MilliSleep(nTimeout);
         }
+        boost::this_thread::interruption_point();
 
         //
         // Accept new connections
         //
         for (auto hListenSocket : vhListenSocket)
-            if (hListenSocket != INVALID_SOCKET && FD_ISSET(hListenSocket, &fdsetRecv)) {
+            if (hListenSocket != INVALID_SOCKET && setRecvReady.count(hListenSocket)) {
                 struct sockaddr_storage sockaddr;
                 socklen_t len  = sizeof(sockaddr);
                 SOCKET hSocket = accept(hListenSocket, (struct sockaddr*)&sockaddr, &len);
@@ -676,16 +682,32 @@ void ThreadSocketHandler() {
             //
             if (pNode->hSocket == INVALID_SOCKET)
                 continue;
-            if (FD_ISSET(pNode->hSocket, &fdsetRecv) || FD_ISSET(pNode->hSocket, &fdsetError)) {
+            // the level-triggered events tell the ready sockets of this round only
+            if (!fEdgeTriggered) {
+                pNode->fHasRecvData = false;
+                pNode->fCanSendData = false;
+            }
+            if (setRecvReady.count(pNode->hSocket))
+                pNode->fHasRecvData = true;
+            if (setSendReady.count(pNode->hSocket))
+                pNode->fCanSendData = true;
+
+            if (pNode->fHasRecvData && setRecvWanted.count(pNode->hSocket)) {
                 TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
                 if (lockRecv) {
                     {
                         // typical socket buffer is 8K-64K
                         char pchBuf[0x10000];
                         int32_t nBytes = recv(pNode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+                        // a short read drains the socket, the edge-triggered events report the data arriving later
+                        if (nBytes >= 0 && nBytes < (int32_t)sizeof(pchBuf))
+                            pNode->fHasRecvData = false;
                         if (nBytes > 0) {
-                            if (!pNode->ReceiveMsgBytes(pchBuf, nBytes))
+                            bool fComplete = false;
+                            if (!pNode->ReceiveMsgBytes(pchBuf, nBytes, fComplete))
                                 pNode->CloseSocketDisconnect();
+                            if (fComplete)
+                                WakeMessageHandler();
                             pNode->nLastRecv = GetTime();
                             pNode->nRecvBytes += nBytes;
                             pNode->RecordBytesRecv(nBytes);
@@ -697,6 +719,8 @@ void ThreadSocketHandler() {
                         } else if (nBytes < 0) {
                             // error
                             int32_t nErr = WSAGetLastError();
+                            if (nErr == WSAEWOULDBLOCK)
+                                pNode->fHasRecvData = false;
                             if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR &&
                                 nErr != WSAEINPROGRESS) {
                                 if (!pNode->fDisconnect)
@@ -713,10 +737,18 @@ void ThreadSocketHandler() {
             //
             if (pNode->hSocket == INVALID_SOCKET)
                 continue;
-            if (FD_ISSET(pNode->hSocket, &fdsetSend)) {
+            if (pNode->fCanSendData) {
                 TRY_LOCK(pNode->cs_vSend, lockSend);
-                if (lockSend)
+                if (lockSend && !pNode->vSendMsg.empty()) {
+                    // the message handler skips the node while its send buffer is full
+                    bool fSendBufferFull = pNode->nSendSize >= SendBufferSize();
                     pNode->SocketSendData();
+                    if (fSendBufferFull && pNode->nSendSize < SendBufferSize())
+                        WakeMessageHandler();
+                    // the socket buffer is full, the edge-triggered events report when it drains
+                    if (!pNode->vSendMsg.empty())
+                        pNode->fCanSendData = false;
+                }
             }
 
             //
@@ -1233,9 +1265,23 @@ void ThreadMessageHandler() {
                 pNode->Release();
         }
 
-        if (fSleep)
-            MilliSleep(100);
+        {
+            std::unique_lock<std::mutex> lock(mutexMsgProc);
+            if (fSleep)
+                condMsgProc.wait_for(lock, std::chrono::milliseconds(MESSAGE_HANDLER_POLL_INTERVAL),
+                                     [] { return fMsgProcWake; });
+            fMsgProcWake = false;
+        }
+        boost::this_thread::interruption_point();
+    }
+}
+
+void WakeMessageHandler() {
+    {
+        std::lock_guard<std::mutex> lock(mutexMsgProc);
+        fMsgProcWake = true;
     }
+    condMsgProc.notify_one();
 }
 
 bool BindListenPort(const CService& addrBind, string& strError) {
@@ -1379,7 +1425,23 @@ void static Discover(boost::thread_group& threadGroup) {
         threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "ext-ip", &ThreadGetMyPublicIP));
 }
 
+bool InitSocketEvents(const string& mode) {
+    pSocketEvents = MakeSocketEvents(mode);
+    if (!pSocketEvents)
+        return false;
+
+    LogPrint(BCLog::INFO, "Using %s socket events\n", pSocketEvents->GetName());
+    return true;
+}
+
 void StartNode(boost::thread_group& threadGroup) {
+    if (!pSocketEvents)
+        InitSocketEvents(DEFAULT_SOCKET_EVENTS);
+    for (auto hListenSocket : vhListenSocket) {
+        if (hListenSocket != INVALID_SOCKET)
+            pSocketEvents->AddSocket(hListenSocket, true);
+    }
+
     if (semOutbound == nullptr) {
         // initialize semaphore
         int32_t nMaxOutbound = min(MAX_OUTBOUND_CONNECTIONS, nMaxConnections);
@@ -50,8 +50,12 @@ CNode* ConnectNode(CAddress addrConnect, const char* strDest = nullptr);
 void MapPort(bool fUseUPnP);
 uint16_t GetListenPort();
 bool BindListenPort(const CService& bindAddr, string& strError = REF(string()));
+/** Initialize the socket events of the socket handler by -socketevents mode */
+bool InitSocketEvents(const string& mode);
 void StartNode(boost::thread_group& threadGroup);
 bool StopNode();
+/** Wake up the message handler thread at once instead of waiting for its next poll */
+void WakeMessageHandler();
 
 enum {
     LOCAL_NONE,    // unknown
@@ -0,0 +1,271 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockdownload.h"
+
+#include "commons/util/util.h"
+
+using namespace std;
+
+CBlockDownloadScheduler blockDownloadScheduler;
+
+static int32_t GetWindowStart(int32_t height) { return height - height % BLOCK_DOWNLOAD_WINDOW_SIZE; }
+
+void CBlockDownloadScheduler::Reset(int32_t tipHeight, const uint256 &tipHash) {
+    LOCK(cs);
+    entries.clear();
+    mapHashHeight.clear();
+    windows.clear();
+    mapInFlight.clear();
+    mapStallTimes.clear();
+    nextHeight        = tipHeight + 1;
+    lastHash          = tipHash;
+    hashesRequestNode = -1;
+    hashesRequestTime = 0;
+    fHashesExhausted  = false;
+}
+
+void CBlockDownloadScheduler::Clear() { Reset(-1, uint256()); }
+
+bool CBlockDownloadScheduler::IsActive() const {
+    LOCK(cs);
+    return !entries.empty() || hashesRequestNode != -1;
+}
+
+bool CBlockDownloadScheduler::IsScheduled(const uint256 &hash) const {
+    LOCK(cs);
+    return mapHashHeight.count(hash) > 0;
+}
+
+void CBlockDownloadScheduler::GetLastBlock(int32_t &height, uint256 &hash) const {
+    LOCK(cs);
+    height = GetEndHeight() - 1;
+    hash   = lastHash;
+}
+
+bool CBlockDownloadScheduler::NeedMoreHashes(int64_t nowMicros) {
+    LOCK(cs);
+    if (fHashesExhausted || entries.empty())
+        return false;
+
+    if (hashesRequestNode != -1) {
+        if (nowMicros - hashesRequestTime < SYNC_HASHES_REQUEST_TIMEOUT * 1000000)
+            return false;
+
+        // the sync peer does not answer when it has no more hashes
+        LogPrint(BCLog::NET, "getheaders request for the sync hashes to peer %d timeout\n", hashesRequestNode);
+        hashesRequestNode = -1;
+        fHashesExhausted  = true;
+        return false;
+    }
+    return (int32_t)entries.size() < SYNC_HASHES_LOW_WATER;
+}
+
+void CBlockDownloadScheduler::SetHashesRequested(NodeId nodeId, int64_t nowMicros) {
+    LOCK(cs);
+    hashesRequestNode = nodeId;
+    hashesRequestTime = nowMicros;
+}
+
+bool CBlockDownloadScheduler::IsHashesRequestedFrom(NodeId nodeId) const {
+    LOCK(cs);
+    return hashesRequestNode != -1 && hashesRequestNode == nodeId;
+}
+
+void CBlockDownloadScheduler::AddHashes(const vector<uint256> &hashes, bool fExhausted) {
+    LOCK(cs);
+    hashesRequestNode = -1;
+    fHashesExhausted  = fExhausted;
+
+    for (const auto &hash : hashes) {
+        if (mapHashHeight.count(hash))
+            continue;
+
+        CSyncEntry entry;
+        entry.hash = hash;
+        entries.push_back(entry);
+        mapHashHeight[hash] = GetEndHeight() - 1;
+        lastHash            = hash;
+    }
+}
+
+CBlockDownloadScheduler::CSyncEntry *CBlockDownloadScheduler::GetEntry(int32_t height) {
+    if (height < nextHeight || height >= GetEndHeight())
+        return nullptr;
+
+    return &entries[height - nextHeight];
+}
+
+bool CBlockDownloadScheduler::IsWindowDone(int32_t windowStart) const {
+    int32_t beginHeight = max(windowStart, nextHeight);
+    int32_t endHeight   = min(windowStart + BLOCK_DOWNLOAD_WINDOW_SIZE, GetEndHeight());
+    for (int32_t height = beginHeight; height < endHeight; height++) {
+        if (entries[height - nextHeight].status == REQUESTED)
+            return false;
+    }
+    return true;
+}
+
+// the blocks requested stay in flight from the peer, it may still deliver them
+void CBlockDownloadScheduler::UnassignWindow(int32_t windowStart, CWindow &window) {
+    int32_t endHeight = min(windowStart + BLOCK_DOWNLOAD_WINDOW_SIZE, GetEndHeight());
+    for (int32_t height = max(windowStart, nextHeight); height < endHeight; height++) {
+        CSyncEntry &entry = entries[height - nextHeight];
+        if (entry.status == REQUESTED)
+            entry.status = QUEUED;
+    }
+    window.nodeId = -1;
+}
+
+vector<uint256> CBlockDownloadScheduler::GetBlocksToRequest(NodeId nodeId, int32_t peerHeight, int32_t maxCount,
+                                                            int64_t nowMicros) {
+    LOCK(cs);
+    vector<uint256> hashes;
+    auto itInFlight = mapInFlight.find(nodeId);
+    maxCount = min(maxCount, MAX_SYNC_BLOCKS_IN_FLIGHT_PER_PEER -
+                                 (itInFlight != mapInFlight.end() ? (int32_t)itInFlight->second.size() : 0));
+    if (maxCount <= 0)
+        return hashes;
+
+    int32_t endHeight = min(GetEndHeight(), nextHeight + MAX_SYNC_BLOCKS_AHEAD);
+    for (int32_t start = GetWindowStart(nextHeight); start < endHeight; start += BLOCK_DOWNLOAD_WINDOW_SIZE) {
+        int32_t windowEnd = min(start + BLOCK_DOWNLOAD_WINDOW_SIZE, GetEndHeight());
+        // the rest hashes of a partial window are not announced yet
+        if (windowEnd - start < BLOCK_DOWNLOAD_WINDOW_SIZE && !fHashesExhausted)
+            break;
+        // the higher windows are beyond the peer too
+        if (peerHeight < windowEnd - 1)
+            break;
+
+        // the hashes queued after a partial window is done are assigned again
+        CWindow &window = windows[start];
+        if ((window.nodeId != -1 && !IsWindowDone(start)) || window.stalledNodes.count(nodeId))
+            continue;
+
+        vector<CSyncEntry *> queued;
+        for (int32_t height = max(start, nextHeight); height < windowEnd; height++) {
+            CSyncEntry *pEntry = GetEntry(height);
+            if (pEntry->status == QUEUED)
+                queued.push_back(pEntry);
+        }
+        if (queued.empty())
+            continue;
+        if ((int32_t)(hashes.size() + queued.size()) > maxCount)
+            break;
+
+        for (auto pEntry : queued) {
+            pEntry->status = REQUESTED;
+            hashes.push_back(pEntry->hash);
+        }
+        window.nodeId      = nodeId;
+        window.requestTime = nowMicros;
+    }
+
+    if (!hashes.empty())
+        mapInFlight[nodeId].insert(hashes.begin(), hashes.end());
+
+    return hashes;
+}
+
+bool CBlockDownloadScheduler::ReceivedBlock(const shared_ptr<CBlock> &pBlock, NodeId nodeId) {
+    LOCK(cs);
+    // the block is charged to the peer delivering it, which is not the one the window is reassigned to if it comes
+    // late from a stalling peer
+    auto itInFlight = mapInFlight.find(nodeId);
+    if (itInFlight != mapInFlight.end() && itInFlight->second.erase(pBlock->GetHash())) {
+        if (itInFlight->second.empty())
+            mapInFlight.erase(itInFlight);
+        mapStallTimes.erase(nodeId);
+    }
+
+    auto it = mapHashHeight.find(pBlock->GetHash());
+    if (it == mapHashHeight.end())
+        return false;
+
+    int32_t height      = it->second;
+    CSyncEntry *pEntry  = GetEntry(height);
+    CSyncEntry *pPrev   = GetEntry(height - 1);
+    if ((int32_t)pBlock->GetHeight() != height || (pPrev && pPrev->hash != pBlock->GetPrevBlockHash())) {
+        // the sync peer announced the blocks of another branch, fall back to the orphan blocks
+        LogPrint(BCLog::NET, "[%d] unexpected sync block %s at height %d, stop the parallel download\n",
+                 pBlock->GetHeight(), pBlock->GetHash().GetHex(), height);
+        Clear();
+        return false;
+    }
+    if (pEntry->status == RECEIVED)
+        return true;
+
+    pEntry->status = RECEIVED;
+    pEntry->pBlock = pBlock;
+    return true;
+}
+
+vector<shared_ptr<CBlock>> CBlockDownloadScheduler::PopReadyBlocks() {
+    LOCK(cs);
+    vector<shared_ptr<CBlock>> blocks;
+    while (!entries.empty() && entries.front().status == RECEIVED) {
+        blocks.push_back(entries.front().pBlock);
+        mapHashHeight.erase(entries.front().hash);
+        entries.pop_front();
+        nextHeight++;
+    }
+    windows.erase(windows.begin(), windows.lower_bound(GetWindowStart(nextHeight)));
+    return blocks;
+}
+
+vector<NodeId> CBlockDownloadScheduler::CheckStalledWindows(int64_t nowMicros, int64_t timeoutMicros) {
+    LOCK(cs);
+    vector<NodeId> stalledNodes;
+    for (auto &item : windows) {
+        CWindow &window = item.second;
+        if (window.nodeId == -1 || nowMicros - window.requestTime < timeoutMicros || IsWindowDone(item.first))
+            continue;
+
+        LogPrint(BCLog::NET, "[%d] peer %d is stalling the block download window, reassign it\n", item.first,
+                 window.nodeId);
+        METRIC_COUNTER("block_download_stalled_windows").Increase();
+        stalledNodes.push_back(window.nodeId);
+        // give all of the peers another chance if the window has stalled on several of them
+        if (window.stalledNodes.size() >= 3)
+            window.stalledNodes.clear();
+        window.stalledNodes.insert(window.nodeId);
+        mapStallTimes.emplace(window.nodeId, nowMicros);
+        UnassignWindow(item.first, window);
+    }
+    return stalledNodes;
+}
+
+bool CBlockDownloadScheduler::IsStallingNode(NodeId nodeId, int64_t nowMicros) const {
+    LOCK(cs);
+    auto it = mapStallTimes.find(nodeId);
+    return it != mapStallTimes.end() && nowMicros - it->second >= BLOCK_DOWNLOAD_STALL_GRACE * 1000000;
+}
+
+void CBlockDownloadScheduler::RemovePeer(NodeId nodeId) {
+    LOCK(cs);
+    mapStallTimes.erase(nodeId);
+    for (auto &item : windows) {
+        if (item.second.nodeId == nodeId)
+            UnassignWindow(item.first, item.second);
+    }
+    mapInFlight.erase(nodeId);
+    if (hashesRequestNode == nodeId)
+        hashesRequestNode = -1;
+}
+
+int32_t CBlockDownloadScheduler::GetInFlightCount(NodeId nodeId) const {
+    LOCK(cs);
+    auto it = mapInFlight.find(nodeId);
+    return it != mapInFlight.end() ? it->second.size() : 0;
+}
+
+int32_t CBlockDownloadScheduler::GetNextHeight() const {
+    LOCK(cs);
+    return nextHeight;
+}
+
+size_t CBlockDownloadScheduler::GetQueuedSize() const {
+    LOCK(cs);
+    return entries.size();
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_BLOCKDOWNLOAD_H
+#define P2P_BLOCKDOWNLOAD_H
+
+#include "commons/uint256.h"
+#include "p2p/headerchain.h"
+#include "p2p/node.h"
+#include "persistence/block.h"
+#include "sync.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/** The maximum number of block hashes in the inventory of a getblocks response */
+static const int32_t GETBLOCKS_RESPONSE_LIMIT = 500;
+/** Number of consecutive blocks requested from the same peer at once during the sync */
+static const int32_t BLOCK_DOWNLOAD_WINDOW_SIZE = 16;
+/** Number of sync blocks in flight per peer */
+static const int32_t MAX_SYNC_BLOCKS_IN_FLIGHT_PER_PEER = 64;
+/** The maximum distance in blocks from the next block to process to the blocks being downloaded */
+static const int32_t MAX_SYNC_BLOCKS_AHEAD = 1024;
+/** Ask the sync peer for more headers when the hashes not received yet are below this */
+static const int32_t SYNC_HASHES_LOW_WATER = MAX_HEADERS_RESULTS;
+/** Timeout in seconds before a download window is reassigned to another peer */
+static const int64_t BLOCK_DOWNLOAD_WINDOW_TIMEOUT = 10;
+/** Seconds a peer stalling a window has to deliver any of its requested blocks before it is disconnected */
+static const int64_t BLOCK_DOWNLOAD_STALL_GRACE = 20;
+/** Timeout in seconds of the getheaders request for the sync hashes */
+static const int64_t SYNC_HASHES_REQUEST_TIMEOUT = 30;
+/** Start the parallel download when the sync peer is ahead of us by more than this */
+static const int32_t MIN_PARALLEL_SYNC_BLOCKS = 2 * BLOCK_DOWNLOAD_WINDOW_SIZE;
+
+/**
+ * Schedules the block downloads of the initial sync across all the eligible peers.
+ *
+ * The hashes of the missing blocks are queued in height order from the best header chain received by the getheaders
+ * requests. The missing range is split into windows of BLOCK_DOWNLOAD_WINDOW_SIZE blocks, each window is requested
+ * from one peer and a window in flight for too long is reassigned to another peer. The received blocks are buffered until all of the
+ * blocks below them arrive, so they are processed in height order instead of going through the orphan blocks.
+ * The blocks in flight are counted by the peers they are requested from until these peers deliver them, and a peer
+ * stalling a window is only disconnected if it delivers none of its blocks in the grace period.
+ */
+class CBlockDownloadScheduler {
+public:
+    enum EntryStatus : uint8_t { QUEUED, REQUESTED, RECEIVED };
+
+    struct CSyncEntry {
+        uint256 hash;
+        EntryStatus status = QUEUED;
+        std::shared_ptr<CBlock> pBlock;
+    };
+
+    struct CWindow {
+        NodeId nodeId       = -1;  // the peer downloading the window, -1 if unassigned
+        int64_t requestTime = 0;   // time of the request in microseconds
+        std::set<NodeId> stalledNodes;
+    };
+
+public:
+    /** Start a new sync from the tip, the previous sync is discarded */
+    void Reset(int32_t tipHeight, const uint256 &tipHash);
+    void Clear();
+
+    /** Whether a sync is going on, the hashes are queued or requested */
+    bool IsActive() const;
+    bool IsScheduled(const uint256 &hash) const;
+
+    /** Get the last queued block to continue the getheaders request from */
+    void GetLastBlock(int32_t &height, uint256 &hash) const;
+    /** Whether the hashes queued are running low and more should be requested from the sync peer */
+    bool NeedMoreHashes(int64_t nowMicros);
+    void SetHashesRequested(NodeId nodeId, int64_t nowMicros);
+    bool IsHashesRequestedFrom(NodeId nodeId) const;
+    /**
+     * Queue the hashes of the headers following the last queued block, fExhausted tells the sync peer has no more
+     * headers to send for now
+     */
+    void AddHashes(const std::vector<uint256> &hashes, bool fExhausted);
+
+    /**
+     * Assign the windows nearest to the next block to process to the peer, up to maxCount blocks in total.
+     * A window is assigned only if the peer has its blocks and has not stalled on it before.
+     */
+    std::vector<uint256> GetBlocksToRequest(NodeId nodeId, int32_t peerHeight, int32_t maxCount, int64_t nowMicros);
+    /**
+     * Buffer the block received from the peer, return false if it is not scheduled or does not match the expected
+     * height
+     */
+    bool ReceivedBlock(const std::shared_ptr<CBlock> &pBlock, NodeId nodeId);
+    /** Take the buffered blocks next to the processed ones in height order */
+    std::vector<std::shared_ptr<CBlock>> PopReadyBlocks();
+
+    /** Unassign the windows in flight for over timeout, return the peers stalling them */
+    std::vector<NodeId> CheckStalledWindows(int64_t nowMicros, int64_t timeoutMicros);
+    /** Whether the peer has stalled a window and delivered none of its blocks since in the grace period */
+    bool IsStallingNode(NodeId nodeId, int64_t nowMicros) const;
+    /** Unassign the windows of a disconnected peer */
+    void RemovePeer(NodeId nodeId);
+
+    int32_t GetInFlightCount(NodeId nodeId) const;
+    int32_t GetNextHeight() const;
+    size_t GetQueuedSize() const;
+
+private:
+    CSyncEntry *GetEntry(int32_t height);
+    int32_t GetEndHeight() const { return nextHeight + (int32_t)entries.size(); }
+    /** Whether none of the blocks of the window is in flight */
+    bool IsWindowDone(int32_t windowStart) const;
+    void UnassignWindow(int32_t windowStart, CWindow &window);
+
+private:
+    mutable CCriticalSection cs;
+    int32_t nextHeight = 0;           // height of entries.front(), the next block to process
+    uint256 lastHash;                 // hash of the last queued block, or of the tip if none is queued
+    std::deque<CSyncEntry> entries;   // the blocks from nextHeight in height order
+    std::unordered_map<uint256, int32_t, CUint256Hasher> mapHashHeight;
+    std::map<int32_t, CWindow> windows;  // the assigned windows by their start height
+    std::map<NodeId, std::set<uint256>> mapInFlight;  // the blocks requested from the peers and not delivered yet
+    std::map<NodeId, int64_t> mapStallTimes;          // the peers stalling a window since the time of the stall
+    NodeId hashesRequestNode = -1;
+    int64_t hashesRequestTime = 0;
+    bool fHashesExhausted     = false;  // the sync peer has no more headers to send
+};
+
+extern CBlockDownloadScheduler blockDownloadScheduler;
+
+#endif  // P2P_BLOCKDOWNLOAD_H
@@ -9,9 +9,11 @@
 #include "main.h"
 #include "net.h"
 #include "node.h"
+#include "miner/miner.h"
 #include "miner/pbftcontext.h"
 #include "miner/pbftmanager.h"
 
+#include <algorithm>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -71,13 +73,56 @@ void MarkBlockAsInFlight(const uint256 &hash, NodeId nodeId) {
     mapBlocksInFlight[hash] = std::make_tuple(nodeId, it, GetTimeMicros());
 }
 
+// Requires cs_main.
+static void PushContinueInv(CNode *pFrom, const uint256 &blockHash) {
+    // Trigger them to send a getblocks request for the next batch of inventory
+    if (blockHash == pFrom->hashContinue) {
+        // Bypass PushInventory, this must send even if redundant,
+        // and we want it right after the last block so they don't
+        // wait for other stuff first.
+        vector<CInv> vInv;
+        vInv.push_back(CInv(MSG_BLOCK, chainActive.Tip()->GetBlockHash()));
+        pFrom->PushMessage(NetMsgType::INV, vInv);
+        pFrom->hashContinue.SetNull();
+        LogPrint(BCLog::NET, "reset node hashcontinue\n");
+    }
+}
+
+// Send the block as it is stored, the bytes on disk are the same as on the network. Only the lookup of the block
+// position takes cs_main, the block is neither read nor serialized under it.
+static void PushRawBlock(CNode *pFrom, const uint256 &blockHash) {
+    CDiskBlockPos blockPos;
+    {
+        LOCK(cs_main);
+        auto mi = mapBlockIndex.find(blockHash);
+        if (mi == mapBlockIndex.end()) {
+            LogPrint(BCLog::NET, "block %s not found\n", blockHash.GetHex());
+            return;
+        }
+        blockPos = mi->second->GetBlockPos();
+    }
+
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+    if (!ReadRawBlockFromDisk(blockPos, ssBlock)) {
+        LogPrint(BCLog::ERROR, "read raw block %s failed\n", blockHash.GetHex());
+        return;
+    }
+
+    LogPrint(BCLog::NET, "send block %s (%u bytes) to peer %s\n", blockHash.GetHex(), ssBlock.size(),
+             pFrom->addr.ToString());
+    pFrom->PushMessage(NetMsgType::BLOCK, ssBlock);
+    METRIC_COUNTER("blocks_served").Increase();
+    METRIC_COUNTER("blocks_served_bytes").Increase(ssBlock.size());
+
+    LOCK(cs_main);
+    PushContinueInv(pFrom, blockHash);
+}
+
 void ProcessGetData(CNode *pFrom) {
     deque<CInv>::iterator it = pFrom->vRecvGetData.begin();
 
     vector<CInv> vNotFound;
 
-    LOCK(cs_main);
-
     while (it != pFrom->vRecvGetData.end()) {
         // Don't bother if send buffer is too full to respond anyway
         if (pFrom->nSendSize >= SendBufferSize()) {
@@ -90,7 +135,11 @@ void ProcessGetData(CNode *pFrom) {
             boost::this_thread::interruption_point();
             it++;
 
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK) {
+            if (inv.type == MSG_BLOCK) {
+                PushRawBlock(pFrom, inv.hash);
+
+            } else if (inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK) {
+                LOCK(cs_main);
                 auto mi = mapBlockIndex.find(inv.hash);
                 if (mi == mapBlockIndex.end()) {
                     LogPrint(BCLog::NET, "block %s not found\n", inv.hash.GetHex());
@@ -98,11 +147,11 @@ void ProcessGetData(CNode *pFrom) {
                 } else { // Load block from disk and send it
                     CBlock block;
                     ReadBlockFromDisk((*mi).second, block);
-                    if (inv.type == MSG_BLOCK) {
-                        LogPrint(BCLog::NET, "send block[%u]: %s to peer %s\n", block.GetHeight(), block.GetHash().GetHex(),
-                                 pFrom->addr.ToString());
+                    if (inv.type == MSG_CMPCT_BLOCK) {
+                        LogPrint(BCLog::NET, "send compact block[%u]: %s to peer %s\n", block.GetHeight(),
+                                 block.GetHash().GetHex(), pFrom->addr.ToString());
 
-                        pFrom->PushMessage(NetMsgType::BLOCK, block);
+                        pFrom->PushMessage(NetMsgType::CMPCTBLOCK, CCompactBlock(block));
 
                     } else  {// MSG_FILTERED_BLOCK)
                         LOCK(pFrom->cs_filter);
@@ -123,17 +172,7 @@ void ProcessGetData(CNode *pFrom) {
                         // no response
                     }
 
-                    // Trigger them to send a getblocks request for the next batch of inventory
-                    if (inv.hash == pFrom->hashContinue) {
-                        // Bypass PushInventory, this must send even if redundant,
-                        // and we want it right after the last block so they don't
-                        // wait for other stuff first.
-                        vector<CInv> vInv;
-                        vInv.push_back(CInv(MSG_BLOCK, chainActive.Tip()->GetBlockHash()));
-                        pFrom->PushMessage(NetMsgType::INV, vInv);
-                        pFrom->hashContinue.SetNull();
-                        LogPrint(BCLog::NET, "reset node hashcontinue\n");
-                    }
+                    PushContinueInv(pFrom, inv.hash);
                 }
             } else if (inv.IsKnownType()) {
                 // Send stream from relay memory
@@ -238,6 +277,67 @@ bool AddBlockToQueue(const uint256 &hash, NodeId nodeId) {
     return true;
 }
 
+// Requires cs_main.
+static void SendGetHeaders(CNode *pNode, const uint256 &beginHash) {
+    // the locator of the tip follows in case the peer does not have the begin block
+    CBlockLocator locator = chainActive.GetLocator();
+    if (beginHash != chainActive.Tip()->GetBlockHash())
+        locator.vHave.insert(locator.vHave.begin(), beginHash);
+
+    pNode->hashLastGetHeadersBegin = beginHash;
+    pNode->nLastGetHeadersTime     = GetTime();
+    pNode->PushMessage(NetMsgType::GETHEADERS, locator, uint256());
+    LogPrint(BCLog::NET, "getheaders from block %s, peer %s\n", beginHash.GetHex(), pNode->addrName);
+}
+
+// Requires cs_main.
+void PushGetHeaders(CNode *pNode) {
+    AssertLockHeld(cs_main);
+    // continue from the best header ahead of the tip
+    const CHeaderIndex *pBest = headerChain.GetBest();
+    uint256 beginHash = (pBest != nullptr && pBest->height > chainActive.Height()) ? pBest->hash
+                                                                                   : chainActive.Tip()->GetBlockHash();
+    // Filter out duplicate requests
+    if (beginHash == pNode->hashLastGetHeadersBegin && GetTime() - pNode->nLastGetHeadersTime < GETHEADERS_INTERVAL) {
+        LogPrint(BCLog::NET, "filter the same getheaders to peer %s\n", pNode->addrName);
+        return;
+    }
+
+    SendGetHeaders(pNode, beginHash);
+}
+
+// Requires cs_main.
+void PushGetSyncHeaders(CNode *pNode) {
+    AssertLockHeld(cs_main);
+    int32_t lastHeight;
+    uint256 lastHash;
+    blockDownloadScheduler.GetLastBlock(lastHeight, lastHash);
+
+    blockDownloadScheduler.SetHashesRequested(pNode->GetId(), GetTimeMicros());
+    SendGetHeaders(pNode, lastHash);
+    LogPrint(BCLog::NET, "getheaders for the sync blocks from height %d, peer %s\n", lastHeight + 1, pNode->addrName);
+}
+
+// Requires cs_main.
+bool StartParallelSync(CNode *pNode) {
+    AssertLockHeld(cs_main);
+    // a new sync peer continues the parallel download going on
+    if (!blockDownloadScheduler.IsActive()) {
+        static int64_t nLastStartTime = 0;
+        int64_t now = GetTimeMicros();
+        if (nSyncTipHeight - chainActive.Height() <= MIN_PARALLEL_SYNC_BLOCKS ||
+            now - nLastStartTime < SYNC_HASHES_REQUEST_TIMEOUT * 1000000)
+            return false;
+
+        nLastStartTime = now;
+        blockDownloadScheduler.Reset(chainActive.Height(), chainActive.Tip()->GetBlockHash());
+        LogPrint(BCLog::NET, "[%d] start parallel block sync to height %d\n", chainActive.Height(), nSyncTipHeight);
+    }
+
+    PushGetSyncHeaders(pNode);
+    return true;
+}
+
 int32_t ProcessVersionMessage(CNode *pFrom, string strCommand, CDataStream &vRecv) {
     // Each connection can only send one version message
     if (pFrom->nVersion != 0) {
@@ -302,6 +402,10 @@ int32_t ProcessVersionMessage(CNode *pFrom, string strCommand, CDataStream &vRec
     pFrom->PushMessage(NetMsgType::VERACK);
     pFrom->ssSend.SetVersion(min(pFrom->nVersion, PROTOCOL_VERSION));
 
+    // the peers ignoring the unknown command keep relaying the full blocks
+    if (SysCfg().GetBoolArg("-compactblocks", true))
+        pFrom->PushMessage(NetMsgType::SENDCMPCT, false, COMPACT_BLOCKS_VERSION);
+
     if (!pFrom->fInbound) {
         // Advertise our address
         if (!fNoListen && !IsInitialBlockDownload()) {
@@ -519,7 +623,7 @@ bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
     CBlockIndex *pIndex = nullptr;
     if (locator.IsNull()) {
         // If locator is null, return the hashStop block
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hashStop);
+        BlockMap::iterator mi = mapBlockIndex.find(hashStop);
         if (mi == mapBlockIndex.end())
             return true;
 
@@ -533,7 +637,7 @@ bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
 
     // We must use CBlocks, as CBlockHeaders won't include the 0x00 nTx count at the end
     vector<CBlock> vHeaders;
-    int32_t nLimit = 2000;
+    int32_t nLimit = MAX_HEADERS_RESULTS;
     LogPrint(BCLog::NET, "getheaders %d to %s from peer %s\n", (pIndex ? pIndex->height : -1), hashStop.ToString(),
              pFrom->addr.ToString());
 
@@ -546,11 +650,178 @@ bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
         if (--nLimit <= 0 || pIndex->GetBlockHash() == hashStop)
             break;
     }
-    pFrom->PushMessage("headers", vHeaders);
+    pFrom->PushMessage(NetMsgType::HEADERS, vHeaders);
 
     return false;
 }
 
+// Requires cs_main. The delegates active at the tip sign the blocks following it until the votes change them, so the
+// headers signed by the delegates elected later can not be verified before the blocks catch up.
+static bool CheckBlockHeaderSignature(const CBlockHeader &header) {
+    static uint256 delegatesTipHash;
+    static VoteDelegateVector activeDelegates;
+    if (delegatesTipHash != chainActive.Tip()->GetBlockHash()) {
+        activeDelegates.clear();
+        if (!pCdMan->pDelegateCache->GetActiveDelegates(activeDelegates))
+            return ERRORMSG("get active delegates failed");
+
+        delegatesTipHash = chainActive.Tip()->GetBlockHash();
+    }
+
+    VoteDelegateVector delegates = activeDelegates;
+    ShuffleDelegates(header.GetHeight(), header.GetTime(), delegates);
+
+    VoteDelegate delegate;
+    if (!GetCurrentDelegate(header.GetTime(), header.GetHeight(), delegates, delegate))
+        return ERRORMSG("[%d] failed to get current delegate", header.GetHeight());
+
+    CAccount account;
+    if (!pCdMan->pAccountCache->GetAccount(delegate.regid, account))
+        return ERRORMSG("[%d] failed to get current delegate's account, regId=%s", header.GetHeight(),
+                        delegate.regid.ToString());
+
+    uint256 hash = header.GetHash();
+    return VerifySignature(hash, header.GetSignature(), account.owner_pubkey) ||
+           VerifySignature(hash, header.GetSignature(), account.miner_pubkey);
+}
+
+// Requires cs_main.
+static bool AcceptBlockHeader(const CBlockHeader &header, CValidationState &state, CHeaderIndex *&pIndexOut) {
+    uint256 hash = header.GetHash();
+    pIndexOut    = headerChain.Find(hash);
+    if (pIndexOut != nullptr || mapBlockIndex.count(hash))
+        return true;
+
+    int32_t prevHeight  = -1;
+    CHeaderIndex *pPrev = headerChain.Find(header.GetPrevBlockHash());
+    if (pPrev != nullptr) {
+        prevHeight = pPrev->height;
+    } else {
+        auto it = mapBlockIndex.find(header.GetPrevBlockHash());
+        if (it == mapBlockIndex.end())
+            return state.DoS(10, ERRORMSG("[%d] header %s does not connect", header.GetHeight(), hash.GetHex()),
+                             REJECT_INVALID, "prev-header-missing");
+
+        prevHeight = it->second->height;
+    }
+
+    if ((int32_t)header.GetHeight() != prevHeight + 1)
+        return state.DoS(100, ERRORMSG("[%d] header %s height mismatch, prev height=%d", header.GetHeight(),
+                         hash.GetHex(), prevHeight), REJECT_INVALID, "bad-header-height");
+
+    if (header.GetVersion() != CBlockHeader::CURRENT_VERSION)
+        return state.Invalid(ERRORMSG("[%d] header version error", header.GetHeight()), REJECT_INVALID,
+                             "block-version-error");
+
+    if (header.GetBlockTime() > GetAdjustedTime() + ::GetBlockInterval(header.GetHeight()) + 2)
+        return state.Invalid(ERRORMSG("[%d] header timestamp too far in the future", header.GetHeight()),
+                             REJECT_INVALID, "time-too-new");
+
+    if (header.GetSignature().empty() || header.GetSignature().size() > MAX_SIGNATURE_SIZE)
+        return state.DoS(100, ERRORMSG("[%d] invalid header signature size, hash=%s", header.GetHeight(),
+                         hash.GetHex()), REJECT_INVALID, "bad-header-signature-size");
+
+    if (!CheckBlockHeaderSignature(header))
+        return state.Invalid(ERRORMSG("[%d] verify header signature error, hash=%s", header.GetHeight(),
+                             hash.GetHex()), REJECT_INVALID, "bad-header-signature");
+
+    pIndexOut = headerChain.Add(header, pPrev);
+    return true;
+}
+
+// Requires cs_main. Queue the blocks of the best header chain to the parallel download.
+static void ScheduleBestHeaders(CNode *pFrom, bool fExhausted) {
+    int32_t lastHeight;
+    uint256 lastHash;
+    blockDownloadScheduler.GetLastBlock(lastHeight, lastHash);
+
+    vector<uint256> hashes;
+    const CHeaderIndex *pBest = headerChain.GetBest();
+    if (pBest != nullptr && pBest->height > lastHeight && !headerChain.GetPath(pBest, lastHash, hashes)) {
+        // the best header chain forks below the blocks being downloaded, download its branch instead
+        uint256 rootHash = headerChain.GetBranchRoot(pBest);
+        auto it          = mapBlockIndex.find(rootHash);
+        if (it == mapBlockIndex.end())
+            return;
+
+        LogPrint(BCLog::NET, "[%d] best header %s forks from block %s, restart the parallel download\n",
+                 pBest->height, pBest->hash.GetHex(), it->second->GetIdString());
+        blockDownloadScheduler.Reset(it->second->height, rootHash);
+        headerChain.GetPath(pBest, rootHash, hashes);
+    }
+
+    if (!hashes.empty() || blockDownloadScheduler.IsHashesRequestedFrom(pFrom->GetId()))
+        blockDownloadScheduler.AddHashes(hashes, fExhausted);
+}
+
+bool ProcessHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
+    // the headers are sent as the blocks without transactions
+    vector<CBlock> vHeaders;
+    vRecv >> vHeaders;
+    if (vHeaders.size() > (size_t)MAX_HEADERS_RESULTS) {
+        Misbehaving(pFrom->GetId(), 20);
+        return ERRORMSG("message headers size() = %u from peer %s", vHeaders.size(), pFrom->addrName);
+    }
+
+    LOCK(cs_main);
+    headerChain.Prune(chainActive.Height());
+
+    CHeaderIndex *pLast = nullptr;
+    bool fAcceptedAll   = true;
+    for (const auto &header : vHeaders) {
+        // the headers too far ahead are requested again as the blocks catch up
+        if ((int32_t)header.GetHeight() > chainActive.Height() + MAX_HEADERS_AHEAD) {
+            fAcceptedAll = false;
+            break;
+        }
+
+        CValidationState state;
+        CHeaderIndex *pIndex = nullptr;
+        if (!AcceptBlockHeader(header, state, pIndex)) {
+            int32_t nDoS = 0;
+            if (state.IsInvalid(nDoS) && nDoS > 0) {
+                LogPrint(BCLog::INFO, "Misbehaving: invalid header from peer %s, nMisbehavior add %d\n",
+                         pFrom->addrName, nDoS);
+                Misbehaving(pFrom->GetId(), nDoS);
+            }
+            fAcceptedAll = false;
+            break;
+        }
+        if (pIndex != nullptr)
+            pLast = pIndex;
+    }
+
+    const CHeaderIndex *pBest = headerChain.GetBest();
+    if (pBest != nullptr && pBest->height > nSyncTipHeight)
+        nSyncTipHeight = pBest->height;
+
+    LogPrint(BCLog::NET, "recv %u headers, last height=%d, best header height=%d, peer %s\n", vHeaders.size(),
+             pLast ? pLast->height : -1, pBest ? pBest->height : -1, pFrom->addrName);
+
+    if (!blockDownloadScheduler.IsActive() && pLast != nullptr && pLast->height > chainActive.Height()) {
+        vector<uint256> hashes;
+        headerChain.GetPath(pLast, headerChain.GetBranchRoot(pLast), hashes);
+        if ((int32_t)hashes.size() <= MIN_PARALLEL_SYNC_BLOCKS) {
+            // a few blocks behind, download them from the peer instead of getting the orphan blocks
+            for (const auto &hash : hashes) {
+                if (!mapBlockIndex.count(hash) && !mapOrphanBlocks.count(hash))
+                    AddBlockToQueue(hash, pFrom->GetId());
+            }
+            return true;
+        }
+
+        blockDownloadScheduler.Reset(chainActive.Height(), chainActive.Tip()->GetBlockHash());
+        LogPrint(BCLog::NET, "[%d] start parallel block sync to header height %d\n", chainActive.Height(),
+                 pLast->height);
+    }
+
+    // a short response has the last headers of the peer
+    if (blockDownloadScheduler.IsActive())
+        ScheduleBestHeaders(pFrom, !fAcceptedAll || vHeaders.size() < (size_t)MAX_HEADERS_RESULTS);
+
+    return true;
+}
+
 void ProcessGetBlocksMessage(CNode *pFrom, CDataStream &vRecv) {
     CBlockLocator locator;
     uint256 hashStop;
@@ -565,7 +836,7 @@ void ProcessGetBlocksMessage(CNode *pFrom, CDataStream &vRecv) {
     if (pStartIndex)
         pStartIndex = chainActive.Next(pStartIndex);
 
-    int32_t nLimit = 500;
+    int32_t nLimit = GETBLOCKS_RESPONSE_LIMIT;
     LogPrint(BCLog::NET, "recv getblocks msg! start_block=%s, end_block=%s, tip_block=%s, limit=%d, peer=%s\n",
         (pStartIndex ? pStartIndex->GetIdString() : ""), hashStop.ToString(),
         chainActive.Tip()->GetIdString(), nLimit, pFrom->addrName);
@@ -592,7 +863,7 @@ void ProcessGetBlocksMessage(CNode *pFrom, CDataStream &vRecv) {
             // When this block is requested, we'll send an inv that'll make them
             // getblocks the next batch of inventory.
             LogPrint(BCLog::NET, "processing getblocks stopped by limit! end_block=%s, limit=%d, peer=%s\n",
-                    pIndex->GetIdString(), 500, pFrom->addrName);
+                    pIndex->GetIdString(), GETBLOCKS_RESPONSE_LIMIT, pFrom->addrName);
 
             pFrom->hashContinue = pIndex->GetBlockHash();
             break;
@@ -610,6 +881,9 @@ bool ProcessInvMessage(CNode *pFrom, CDataStream &vRecv) {
 
     LOCK(cs_main);
 
+    // the announced blocks are caught up by the parallel download
+    bool fSyncing = blockDownloadScheduler.IsActive();
+
     int i = 0;
     for (CInv &inv : vInv) {
         boost::this_thread::interruption_point();
@@ -643,12 +917,11 @@ bool ProcessInvMessage(CNode *pFrom, CDataStream &vRecv) {
                         GetTimeMillis(), i, msgName, inv.ToString(), pFrom->addrName, "OrphanBlock", orphanBlockIt->second->height);
                     fAlreadyHave = true;
 
-                    LogPrint(BCLog::NET, "recv orphan block and lead to getblocks! height=%d, hash=%s, "
+                    LogPrint(BCLog::NET, "recv orphan block and lead to getheaders! height=%d, hash=%s, "
                              "tip_height=%d, tip_hash=%s, peer=%s\n",
                              orphanBlockIt->second->height, inv.hash.GetHex(), chainActive.Height(),
                              chainActive.Tip()->GetBlockHash().GetHex(), pFrom->addrName);
-                    PushGetBlocksOnCondition(pFrom, chainActive.Tip(), GetOrphanRoot(inv.hash));
-                    // TODO: should get the headmost block of this fork from current peer
+                    PushGetHeaders(pFrom);
                 }
             }
         }
@@ -658,9 +931,10 @@ bool ProcessInvMessage(CNode *pFrom, CDataStream &vRecv) {
                                  GetTimeMillis(), i, pFrom->addrName);
 
             if (!SysCfg().IsImporting() && !SysCfg().IsReindex()) {
-                if (inv.type == MSG_BLOCK)
-                    AddBlockToQueue(inv.hash, pFrom->GetId());
-                else
+                if (inv.type == MSG_BLOCK) {
+                    if (!fSyncing)
+                        AddBlockToQueue(inv.hash, pFrom->GetId());
+                } else
                     pFrom->AskFor(inv);  // MSG_TX
             }
         }
@@ -671,6 +945,7 @@ bool ProcessInvMessage(CNode *pFrom, CDataStream &vRecv) {
         }
         i++;
     }
+
     return true;
 }
 
@@ -694,14 +969,28 @@ bool ProcessGetDataMessage(CNode *pFrom, CDataStream &vRecv) {
     return true;
 }
 
-void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
-    CBlock block;
-    vRecv >> block;
+// The connected peer that sent the block, nullptr if it has gone. Requires cs_main, the returned node must be released.
+static CNode *FindBlockSource(const uint256 &blockHash) {
+    NodeId nodeId;
+    {
+        LOCK(cs_mapNodeState);
+        auto it = mapBlockSource.find(blockHash);
+        if (it == mapBlockSource.end())
+            return nullptr;
+        nodeId = it->second;
+    }
 
-    LogPrint(BCLog::NET, "recv block! time_ms=%lld, hash=%s, peer=%s\n", GetTimeMillis(),
-        block.GetHash().ToString(), pFrom->addr.ToString());
-    // block.Print();
+    LOCK(cs_vNodes);
+    for (auto pNode : vNodes) {
+        if (pNode->GetId() == nodeId && !pNode->fDisconnect)
+            return pNode->AddRef();
+    }
+    return nullptr;
+}
 
+// Requires cs_main.
+static void ProcessReceivedBlock(CNode *pFrom, const std::shared_ptr<CBlock> &pBlock) {
+    CBlock &block = *pBlock;
     CInv inv(MSG_BLOCK, block.GetHash());
     pFrom->AddInventoryKnown(inv);
 
@@ -712,9 +1001,35 @@ void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
         MarkBlockAsReceived(inv.hash, pFrom->GetId());
     }
 
-    LOCK(cs_main);
     CValidationState state;
 
+    if (blockDownloadScheduler.ReceivedBlock(pBlock, pFrom->GetId())) {
+        // process the buffered sync blocks in height order
+        // each block is processed on behalf of the peer that sent it, which may not be the sender of the last block
+        for (const auto &pReadyBlock : blockDownloadScheduler.PopReadyBlocks()) {
+            CValidationState blockState;
+            CNode *pSource = FindBlockSource(pReadyBlock->GetHash());
+            bool fProcessed = ProcessBlock(blockState, pSource, pReadyBlock.get());
+
+            int32_t nDoS = 0;
+            if (pSource != nullptr && blockState.IsInvalid(nDoS) && nDoS > 0) {
+                LogPrint(BCLog::INFO, "Misbehaving: invalid sync block from peer %s, nMisbehavior add %d\n",
+                         pSource->addrName, nDoS);
+                Misbehaving(pSource->GetId(), nDoS);
+            }
+            if (pSource != nullptr)
+                pSource->Release();
+
+            if (!fProcessed && blockState.GetRejectReason() != "duplicate") {
+                LogPrint(BCLog::NET, "[%d] process sync block %s failed, stop the parallel download\n",
+                         pReadyBlock->GetHeight(), pReadyBlock->GetHash().GetHex());
+                blockDownloadScheduler.Clear();
+                break;
+            }
+        }
+        return;
+    }
+
     std::pair<int32_t ,uint256> globalfinblock = std::make_pair(0,uint256());
     pCdMan->pBlockCache->ReadGlobalFinBlock(globalfinblock);
     if (block.GetHeight() < (uint32_t)globalfinblock.first) {
@@ -726,6 +1041,172 @@ void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
 
 }
 
+void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
+    auto pBlock = std::make_shared<CBlock>();
+    vRecv >> *pBlock;
+
+    LogPrint(BCLog::NET, "recv block! time_ms=%lld, hash=%s, peer=%s\n", GetTimeMillis(),
+        pBlock->GetHash().ToString(), pFrom->addr.ToString());
+    // block.Print();
+
+    LOCK(cs_main);
+    ProcessReceivedBlock(pFrom, pBlock);
+}
+
+// A compact block waiting for its missing txs from the peer it is received from
+struct CPendingPartialBlock {
+    NodeId nodeId;
+    int64_t receivedTime;  // the oldest pending block is evicted first
+    std::shared_ptr<CPartialBlock> pPartialBlock;
+};
+
+// The compact blocks waiting for their missing txs, by the block hash. Protected by cs_main.
+static map<uint256, CPendingPartialBlock> mapPartialBlocks;
+
+// Requires cs_main. The compact block can not be rebuilt, get the full block from the peer instead.
+static void RequestFullBlock(CNode *pFrom, const uint256 &blockHash) {
+    METRIC_COUNTER("compact_block_fallbacks").Increase();
+    LogPrint(BCLog::NET, "rebuild compact block %s failed, request the full block from peer %s\n", blockHash.GetHex(),
+             pFrom->addrName);
+
+    vector<CInv> vGetData = {CInv(MSG_BLOCK, blockHash)};
+    pFrom->PushMessage(NetMsgType::GETDATA, vGetData);
+}
+
+// Requires cs_main.
+static bool FillCompactBlock(CNode *pFrom, const CPartialBlock &partialBlock,
+                             const vector<std::shared_ptr<CBaseTx>> &missingTxs) {
+    auto pBlock = std::make_shared<CBlock>();
+    CPartialBlock::ReadStatus status = partialBlock.FillBlock(*pBlock, missingTxs);
+    if (status == CPartialBlock::READ_INVALID) {
+        Misbehaving(pFrom->GetId(), 100);
+        return ERRORMSG("invalid txs of compact block %s from peer %s", partialBlock.GetHeader().GetHash().GetHex(),
+                        pFrom->addrName);
+    }
+    if (status == CPartialBlock::READ_FAILED) {
+        RequestFullBlock(pFrom, partialBlock.GetHeader().GetHash());
+        return true;
+    }
+
+    ProcessReceivedBlock(pFrom, pBlock);
+    return true;
+}
+
+void ProcessSendCompactMessage(CNode *pFrom, CDataStream &vRecv) {
+    bool fAnnounce;
+    uint64_t version;
+    vRecv >> fAnnounce >> version;
+
+    pFrom->fCompactBlocks = (version == COMPACT_BLOCKS_VERSION);
+    LogPrint(BCLog::NET, "recv sendcmpct version %llu from peer %s\n", version, pFrom->addrName);
+}
+
+bool ProcessCompactBlockMessage(CNode *pFrom, CDataStream &vRecv) {
+    CCompactBlock cmpctBlock;
+    vRecv >> cmpctBlock;
+
+    uint256 blockHash = cmpctBlock.header.GetHash();
+    METRIC_COUNTER("compact_blocks_received").Increase();
+    pFrom->AddInventoryKnown(CInv(MSG_BLOCK, blockHash));
+
+    LOCK(cs_main);
+    if (mapBlockIndex.count(blockHash) || mapOrphanBlocks.count(blockHash)) {
+        LOCK(cs_mapNodeState);
+        MarkBlockAsReceived(blockHash, pFrom->GetId());
+        return true;
+    }
+
+    auto pPartialBlock = std::make_shared<CPartialBlock>();
+    CPartialBlock::ReadStatus status;
+    {
+        LOCK(mempool.cs);
+        status = pPartialBlock->Init(cmpctBlock, mempool.memPoolTxs);
+    }
+    if (status == CPartialBlock::READ_INVALID) {
+        Misbehaving(pFrom->GetId(), 100);
+        return ERRORMSG("invalid compact block %s from peer %s", blockHash.GetHex(), pFrom->addrName);
+    }
+    if (status == CPartialBlock::READ_FAILED) {
+        RequestFullBlock(pFrom, blockHash);
+        return true;
+    }
+
+    vector<uint32_t> missingIndexes = pPartialBlock->GetMissingIndexes();
+    METRIC_COUNTER("compact_block_mempool_txs").Increase(pPartialBlock->GetMempoolTxCount());
+    METRIC_COUNTER("compact_block_missing_txs").Increase(missingIndexes.size());
+    LogPrint(BCLog::NET, "[%d] recv compact block %s, txs=%u, from_mempool=%u, missing=%u, peer=%s\n",
+             cmpctBlock.header.GetHeight(), blockHash.GetHex(), cmpctBlock.GetTxCount(),
+             pPartialBlock->GetMempoolTxCount(), missingIndexes.size(), pFrom->addrName);
+
+    if (missingIndexes.empty())
+        return FillCompactBlock(pFrom, *pPartialBlock, {});
+
+    if (!mapPartialBlocks.count(blockHash) && mapPartialBlocks.size() >= MAX_PARTIAL_BLOCKS) {
+        auto itOldest = std::min_element(mapPartialBlocks.begin(), mapPartialBlocks.end(),
+                                         [](const pair<const uint256, CPendingPartialBlock> &a,
+                                            const pair<const uint256, CPendingPartialBlock> &b) {
+                                             return a.second.receivedTime < b.second.receivedTime;
+                                         });
+        mapPartialBlocks.erase(itOldest);
+    }
+    mapPartialBlocks[blockHash] = {pFrom->GetId(), GetTimeMicros(), pPartialBlock};
+
+    CBlockTxRequest request;
+    request.blockHash = blockHash;
+    request.indexes   = missingIndexes;
+    pFrom->PushMessage(NetMsgType::GETBLOCKTXN, request);
+    return true;
+}
+
+bool ProcessGetBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxRequest request;
+    vRecv >> request;
+
+    LOCK(cs_main);
+    auto it = mapBlockIndex.find(request.blockHash);
+    if (it == mapBlockIndex.end()) {
+        LogPrint(BCLog::NET, "getblocktxn of unknown block %s from peer %s\n", request.blockHash.GetHex(),
+                 pFrom->addrName);
+        return true;
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(it->second, block))
+        return ERRORMSG("read block %s failed", it->second->GetIdString());
+
+    CBlockTxResponse response;
+    response.blockHash = request.blockHash;
+    response.txs.reserve(request.indexes.size());
+    for (auto index : request.indexes) {
+        if (index >= block.vptx.size()) {
+            Misbehaving(pFrom->GetId(), 100);
+            return ERRORMSG("getblocktxn index %u out of block %s from peer %s", index, it->second->GetIdString(),
+                            pFrom->addrName);
+        }
+        response.txs.push_back(block.vptx[index]);
+    }
+
+    pFrom->PushMessage(NetMsgType::BLOCKTXN, response);
+    return true;
+}
+
+bool ProcessBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxResponse response;
+    vRecv >> response;
+
+    LOCK(cs_main);
+    auto it = mapPartialBlocks.find(response.blockHash);
+    if (it == mapPartialBlocks.end() || it->second.nodeId != pFrom->GetId()) {
+        LogPrint(BCLog::NET, "recv unrequested blocktxn of block %s from peer %s\n", response.blockHash.GetHex(),
+                 pFrom->addrName);
+        return true;
+    }
+
+    auto pPartialBlock = it->second.pPartialBlock;
+    mapPartialBlocks.erase(it);
+    return FillCompactBlock(pFrom, *pPartialBlock, response.txs);
+}
+
 void ProcessMempoolMessage(CNode *pFrom, CDataStream &vRecv) {
     LOCK2(cs_main, pFrom->cs_filter);
 
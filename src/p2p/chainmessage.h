@@ -12,6 +12,8 @@
 #include "main.h"
 #include "addrman.h"
 #include "net.h"
+#include "p2p/blockdownload.h"
+#include "p2p/compactblock.h"
 #include "miner/pbftcontext.h"
 #include "miner/pbftmanager.h"
 
@@ -59,6 +61,15 @@ bool AlreadyHave(const CInv &inv);
 // Requires cs_main.
 bool AddBlockToQueue(const uint256 &hash, NodeId nodeId);
 
+// Requires cs_main.
+void PushGetHeaders(CNode *pNode);
+
+// Requires cs_main.
+void PushGetSyncHeaders(CNode *pNode);
+
+// Requires cs_main.
+bool StartParallelSync(CNode *pNode);
+
 int32_t ProcessVersionMessage(CNode *pFrom, string strCommand, CDataStream &vRecv);
 
 void ProcessPongMessage(CNode *pFrom, CDataStream &vRecv);
@@ -69,6 +80,8 @@ bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv);
 
 bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv);
 
+bool ProcessHeadersMessage(CNode *pFrom, CDataStream &vRecv);
+
 void ProcessGetBlocksMessage(CNode *pFrom, CDataStream &vRecv);
 
 bool ProcessInvMessage(CNode *pFrom, CDataStream &vRecv);
@@ -77,6 +90,14 @@ bool ProcessGetDataMessage(CNode *pFrom, CDataStream &vRecv);
 
 void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv);
 
+void ProcessSendCompactMessage(CNode *pFrom, CDataStream &vRecv);
+
+bool ProcessCompactBlockMessage(CNode *pFrom, CDataStream &vRecv);
+
+bool ProcessGetBlockTxnMessage(CNode *pFrom, CDataStream &vRecv);
+
+bool ProcessBlockTxnMessage(CNode *pFrom, CDataStream &vRecv);
+
 void ProcessMempoolMessage(CNode *pFrom, CDataStream &vRecv);
 
 void ProcessAlertMessage(CNode *pFrom, CDataStream &vRecv);
@@ -0,0 +1,131 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "compactblock.h"
+
+#include "commons/util/util.h"
+#include "config/version.h"
+#include "crypto/hash.h"
+#include "crypto/siphash.h"
+
+#include <unordered_map>
+
+using namespace std;
+
+CCompactBlock::CCompactBlock(const CBlock &block) : header(block), nonce(GetRand(std::numeric_limits<uint64_t>::max())) {
+    shortTxIds.reserve(block.vptx.size());
+    for (uint32_t index = 0; index < block.vptx.size(); index++) {
+        const auto &pBaseTx = block.vptx[index];
+        if (pBaseTx->IsRelayForbidden()) {
+            CPrefilledTx prefilledTx;
+            prefilledTx.index = index;
+            prefilledTx.tx    = pBaseTx;
+            prefilledTxs.push_back(prefilledTx);
+        } else {
+            shortTxIds.push_back(GetShortTxId(pBaseTx->GetHash()));
+        }
+    }
+}
+
+void CCompactBlock::InitShortTxIdKeys() const {
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << header << nonce;
+    uint256 hash = ss.GetHash();
+
+    shortTxIdK0    = hash.GetUint64(0);
+    shortTxIdK1    = hash.GetUint64(1);
+    fShortTxIdKeys = true;
+}
+
+uint64_t CCompactBlock::GetShortTxId(const uint256 &txid) const {
+    if (!fShortTxIdKeys)
+        InitShortTxIdKeys();
+
+    return SipHashUint256(shortTxIdK0, shortTxIdK1, txid);
+}
+
+CPartialBlock::ReadStatus CPartialBlock::Init(const CCompactBlock &cmpctBlock,
+                                              const map<uint256, CTxMemPoolEntry> &memPoolTxs) {
+    size_t txCount = cmpctBlock.GetTxCount();
+    if (txCount == 0 || txCount > MAX_COMPACT_BLOCK_TXS)
+        return READ_INVALID;
+
+    header = cmpctBlock.header;
+    txs.assign(txCount, nullptr);
+    mempoolTxCount = 0;
+
+    for (const auto &prefilledTx : cmpctBlock.prefilledTxs) {
+        if (prefilledTx.index >= txCount || txs[prefilledTx.index] != nullptr || prefilledTx.tx == nullptr)
+            return READ_INVALID;
+
+        txs[prefilledTx.index] = prefilledTx.tx;
+    }
+
+    // the short ids fill the rest indexes in order
+    unordered_map<uint64_t, uint32_t> shortTxIdIndexes;
+    shortTxIdIndexes.reserve(cmpctBlock.shortTxIds.size());
+    uint32_t index = 0;
+    for (auto shortTxId : cmpctBlock.shortTxIds) {
+        while (txs[index] != nullptr)
+            index++;
+
+        if (!shortTxIdIndexes.emplace(shortTxId, index++).second)
+            return READ_FAILED;
+    }
+
+    // a short id matched by two mempool txs is requested from the peer
+    vector<bool> collided(txCount, false);
+    for (const auto &item : memPoolTxs) {
+        auto it = shortTxIdIndexes.find(cmpctBlock.GetShortTxId(item.first));
+        if (it == shortTxIdIndexes.end() || collided[it->second])
+            continue;
+
+        auto &pBaseTx = txs[it->second];
+        if (pBaseTx != nullptr) {
+            pBaseTx = nullptr;
+            collided[it->second] = true;
+            mempoolTxCount--;
+            continue;
+        }
+
+        // the block owns a copy as the txs are executed again when it is connected
+        pBaseTx = item.second.GetTransaction()->GetNewInstance();
+        if (++mempoolTxCount == shortTxIdIndexes.size())
+            break;
+    }
+
+    return READ_OK;
+}
+
+vector<uint32_t> CPartialBlock::GetMissingIndexes() const {
+    vector<uint32_t> indexes;
+    for (uint32_t index = 0; index < txs.size(); index++) {
+        if (txs[index] == nullptr)
+            indexes.push_back(index);
+    }
+    return indexes;
+}
+
+CPartialBlock::ReadStatus CPartialBlock::FillBlock(CBlock &block, const vector<shared_ptr<CBaseTx>> &missingTxs) const {
+    block = CBlock(header);
+    block.vptx = txs;
+
+    size_t missingIndex = 0;
+    for (auto &pBaseTx : block.vptx) {
+        if (pBaseTx != nullptr)
+            continue;
+        if (missingIndex >= missingTxs.size() || missingTxs[missingIndex] == nullptr)
+            return READ_INVALID;
+
+        pBaseTx = missingTxs[missingIndex++];
+    }
+    if (missingIndex != missingTxs.size())
+        return READ_INVALID;
+
+    // a wrong tx from the mempool with the same short id breaks the merkle root
+    if (block.BuildMerkleTree() != header.GetMerkleRootHash())
+        return READ_FAILED;
+
+    return READ_OK;
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_COMPACTBLOCK_H
+#define P2P_COMPACTBLOCK_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "config/const.h"
+#include "persistence/block.h"
+#include "tx/tx.h"
+#include "tx/txmempool.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/** Version of the compact block relay announced by the sendcmpct message */
+static const uint64_t COMPACT_BLOCKS_VERSION = 1;
+/** Maximum number of the compact blocks waiting for their missing txs */
+static const size_t MAX_PARTIAL_BLOCKS = 16;
+/** Maximum number of txs in a compact block, a signed tx takes 64 bytes at least */
+static const size_t MAX_COMPACT_BLOCK_TXS = MAX_BLOCK_SIZE / 64;
+
+/** A tx sent along with the compact block */
+struct CPrefilledTx {
+    uint32_t index = 0;  // index of the tx in the block
+    std::shared_ptr<CBaseTx> tx;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(VARINT(index));
+        READWRITE(tx);
+    )
+};
+
+/**
+ * A block relayed by its header and the short ids of its txs, which the peer rebuilds from the txs in its mempool.
+ * The txs never relayed (e.g. the reward tx and the price median tx) are prefilled as the peer can not have them.
+ */
+class CCompactBlock {
+public:
+    CBlockHeader header;
+    uint64_t nonce = 0;
+    vector<uint64_t> shortTxIds;
+    vector<CPrefilledTx> prefilledTxs;
+
+public:
+    CCompactBlock() {}
+    explicit CCompactBlock(const CBlock &block);
+
+    /** The SipHash of the txid keyed by the header and the nonce, so the collisions differ from block to block */
+    uint64_t GetShortTxId(const uint256 &txid) const;
+    size_t GetTxCount() const { return shortTxIds.size() + prefilledTxs.size(); }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(header);
+        READWRITE(nonce);
+        READWRITE(shortTxIds);
+        READWRITE(prefilledTxs);
+    )
+
+private:
+    void InitShortTxIdKeys() const;
+
+private:
+    mutable bool fShortTxIdKeys = false;
+    mutable uint64_t shortTxIdK0 = 0;
+    mutable uint64_t shortTxIdK1 = 0;
+};
+
+/** The indexes of the txs missing to rebuild a compact block */
+struct CBlockTxRequest {
+    uint256 blockHash;
+    vector<uint32_t> indexes;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(indexes);
+    )
+};
+
+/** The txs requested by a getblocktxn message in the order of their indexes */
+struct CBlockTxResponse {
+    uint256 blockHash;
+    vector<std::shared_ptr<CBaseTx>> txs;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(txs);
+    )
+};
+
+/** A compact block being rebuilt from the mempool */
+class CPartialBlock {
+public:
+    enum ReadStatus {
+        READ_OK,
+        READ_INVALID,  // the peer sent a malformed message
+        READ_FAILED,   // the short ids collide, the full block should be requested
+    };
+
+public:
+    /** Place the prefilled txs and the mempool txs matching the short ids, requires the lock of the mempool */
+    ReadStatus Init(const CCompactBlock &cmpctBlock, const map<uint256, CTxMemPoolEntry> &memPoolTxs);
+    vector<uint32_t> GetMissingIndexes() const;
+    /** Rebuild the block with the missing txs in the order of GetMissingIndexes() */
+    ReadStatus FillBlock(CBlock &block, const vector<std::shared_ptr<CBaseTx>> &missingTxs) const;
+
+    const CBlockHeader &GetHeader() const { return header; }
+    size_t GetMempoolTxCount() const { return mempoolTxCount; }
+
+private:
+    CBlockHeader header;
+    vector<std::shared_ptr<CBaseTx>> txs;
+    size_t mempoolTxCount = 0;
+};
+
+#endif  // P2P_COMPACTBLOCK_H
@@ -0,0 +1,86 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "headerchain.h"
+
+#include <algorithm>
+
+using namespace std;
+
+CHeaderChain headerChain;
+
+CHeaderIndex *CHeaderChain::Find(const uint256 &hash) const {
+    auto it = mapHeaders.find(hash);
+    return it != mapHeaders.end() ? it->second.get() : nullptr;
+}
+
+CHeaderIndex *CHeaderChain::Add(const CBlockHeader &header, CHeaderIndex *pPrev) {
+    uint256 hash = header.GetHash();
+    auto it      = mapHeaders.find(hash);
+    if (it != mapHeaders.end())
+        return it->second.get();
+
+    auto pIndex    = std::make_unique<CHeaderIndex>();
+    pIndex->header = header;
+    pIndex->hash   = hash;
+    pIndex->height = header.GetHeight();
+    pIndex->pprev  = pPrev;
+
+    CHeaderIndex *pNew = pIndex.get();
+    mapHeaders.emplace(hash, std::move(pIndex));
+    // the first header received at a height wins
+    if (pBest == nullptr || pNew->height > pBest->height)
+        pBest = pNew;
+
+    return pNew;
+}
+
+uint256 CHeaderChain::GetBranchRoot(const CHeaderIndex *pIndex) const {
+    while (pIndex->pprev != nullptr)
+        pIndex = pIndex->pprev;
+
+    return pIndex->header.GetPrevBlockHash();
+}
+
+bool CHeaderChain::GetPath(const CHeaderIndex *pIndex, const uint256 &fromHash, vector<uint256> &hashes) const {
+    hashes.clear();
+    for (; pIndex != nullptr && pIndex->hash != fromHash; pIndex = pIndex->pprev) {
+        hashes.push_back(pIndex->hash);
+        if (pIndex->pprev == nullptr && pIndex->header.GetPrevBlockHash() != fromHash)
+            return false;
+    }
+    std::reverse(hashes.begin(), hashes.end());
+    return true;
+}
+
+void CHeaderChain::Prune(int32_t height) {
+    for (auto &item : mapHeaders) {
+        CHeaderIndex *pIndex = item.second.get();
+        if (pIndex->pprev != nullptr && pIndex->pprev->height <= height)
+            pIndex->pprev = nullptr;
+    }
+
+    bool fBestPruned = false;
+    for (auto it = mapHeaders.begin(); it != mapHeaders.end();) {
+        if (it->second->height <= height) {
+            fBestPruned |= (it->second.get() == pBest);
+            it = mapHeaders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (fBestPruned) {
+        pBest = nullptr;
+        for (auto &item : mapHeaders) {
+            if (pBest == nullptr || item.second->height > pBest->height)
+                pBest = item.second.get();
+        }
+    }
+}
+
+void CHeaderChain::Clear() {
+    mapHeaders.clear();
+    pBest = nullptr;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_HEADERCHAIN_H
+#define P2P_HEADERCHAIN_H
+
+#include "commons/uint256.h"
+#include "persistence/block.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/** The maximum number of headers in a headers message */
+static const int32_t MAX_HEADERS_RESULTS = 2000;
+/** The maximum distance in blocks from the tip to the headers kept ahead of the blocks */
+static const int32_t MAX_HEADERS_AHEAD = 10 * MAX_HEADERS_RESULTS;
+/** Interval in seconds before the same getheaders request is sent to a peer again */
+static const int64_t GETHEADERS_INTERVAL = 2;
+
+/** A block header received ahead of the block */
+struct CHeaderIndex {
+    CBlockHeader header;
+    uint256 hash;
+    int32_t height      = 0;
+    CHeaderIndex *pprev = nullptr;  // the parent header, nullptr if the parent block is stored already
+};
+
+/**
+ * The tree of the block headers received by the getheaders requests, whose blocks are not stored yet.
+ *
+ * Every branch starts from a block in mapBlockIndex, which is kept for the stored blocks only since an entry there
+ * is taken as the block being on disk. The highest header is the best one, the blocks of the branch leading to it are
+ * downloaded in parallel. Protected by cs_main.
+ */
+class CHeaderChain {
+public:
+    CHeaderIndex *Find(const uint256 &hash) const;
+    /** Add a validated header, pPrev is its parent header or nullptr if the parent block is stored */
+    CHeaderIndex *Add(const CBlockHeader &header, CHeaderIndex *pPrev);
+    const CHeaderIndex *GetBest() const { return pBest; }
+
+    /** Get the hash of the stored block the branch of the header starts from */
+    uint256 GetBranchRoot(const CHeaderIndex *pIndex) const;
+    /**
+     * Get the hashes of the headers after fromHash up to pIndex in height order, fromHash is a header on the branch or
+     * the stored block the branch starts from. Return false if fromHash is not on the branch.
+     */
+    bool GetPath(const CHeaderIndex *pIndex, const uint256 &fromHash, std::vector<uint256> &hashes) const;
+
+    /** Forget the headers not above the height, their blocks are stored or they are of the stale branches */
+    void Prune(int32_t height);
+    void Clear();
+    size_t Size() const { return mapHeaders.size(); }
+
+private:
+    std::unordered_map<uint256, std::unique_ptr<CHeaderIndex>, CUint256Hasher> mapHeaders;
+    CHeaderIndex *pBest = nullptr;
+};
+
+extern CHeaderChain headerChain;
+
+#endif  // P2P_HEADERCHAIN_H
@@ -5,6 +5,7 @@
 
 
 #include "node.h"
+#include "blockdownload.h"
 #include "netmessage.h"
 #include <openssl/rand.h>
 
@@ -44,6 +45,8 @@ void FinalizeNode(NodeId nodeid) {
     for (const auto &hash : state->vBlocksToDownload)
         mapBlocksToDownload.erase(hash);
 
+    blockDownloadScheduler.RemovePeer(nodeid);
+
     mapNodeState.erase(nodeid);
 }
 
@@ -207,7 +210,8 @@ bool CNode::Ban(const CNetAddr& addr) {
 }
 
 // requires LOCK(cs_vRecvMsg)
-bool CNode::ReceiveMsgBytes(const char* pch, uint32_t nBytes) {
+bool CNode::ReceiveMsgBytes(const char* pch, uint32_t nBytes, bool& fComplete) {
+    fComplete = false;
     while (nBytes > 0) {
         // get current incomplete message, or create a new one
         if (vRecvMsg.empty() || vRecvMsg.back().complete()) vRecvMsg.push_back(CNetMessage(SER_NETWORK, nRecvVersion));
@@ -226,6 +230,11 @@ bool CNode::ReceiveMsgBytes(const char* pch, uint32_t nBytes) {
 
         pch += handled;
         nBytes -= handled;
+
+        if (msg.complete()) {
+            msg.nTime = GetTimeMicros();
+            fComplete = true;
+        }
     }
 
     return true;
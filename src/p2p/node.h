@@ -120,6 +120,9 @@ public:
     // socket
     uint64_t nServices;
     SOCKET hSocket;
+    SOCKET hSocketEvents;  // socket watched by the edge-triggered socket events, only used by the socket handler
+    bool fHasRecvData;     // socket may have data to receive, only used by the socket handler
+    bool fCanSendData;     // socket may accept data to send, only used by the socket handler
     CDataStream ssSend;
     size_t nSendSize;    // total size of all vSendMsg entries
     size_t nSendOffset;  // offset inside the first vSendMsg already sent
@@ -157,6 +160,7 @@ public:
     // b) the peer may tell us in their version message that we should not relay tx invs
     //    until they have initialized their bloom filter.
     bool fRelayTxes;
+    bool fCompactBlocks;  // the peer sends and receives the blocks by the cmpctblock messages
     CSemaphoreGrant grantOutbound;
     CCriticalSection cs_filter;
     CBloomFilter* pFilter;
@@ -176,6 +180,8 @@ public:
     uint256 hashContinue;                   // getblocks the next batch of inventory下一次 盘点的块
     CBlockIndex* pIndexLastGetBlocksBegin;  //上次开始的块  本地节点有的块chainActive.Tip()
     uint256 hashLastGetBlocksEnd;           // 本地节点保存的孤儿块的根块 hash GetOrphanRoot(hash)
+    uint256 hashLastGetHeadersBegin;        // the block the last getheaders request continues from
+    int64_t nLastGetHeadersTime;
     int32_t nStartingHeight;                // Start block sync, current height
     bool fStartSync;
 
@@ -210,6 +216,9 @@ public:
             : ssSend(SER_NETWORK, INIT_PROTO_VERSION), setAddrKnown(5000) {
         nServices                = 0;
         hSocket                  = hSocketIn;
+        hSocketEvents            = INVALID_SOCKET;
+        fHasRecvData             = false;
+        fCanSendData             = false;
         nRecvVersion             = INIT_PROTO_VERSION;
         nLastSend                = 0;
         nLastRecv                = 0;
@@ -233,10 +242,13 @@ public:
         hashContinue             = uint256();
         pIndexLastGetBlocksBegin = 0;
         hashLastGetBlocksEnd     = uint256();
+        hashLastGetHeadersBegin  = uint256();
+        nLastGetHeadersTime      = 0;
         nStartingHeight          = -1;
         fStartSync               = false;
         fGetAddr                 = false;
         fRelayTxes               = false;
+        fCompactBlocks           = false;
         setInventoryKnown.max_size(SendBufferSize() / 1000);
         auto maxPbftMsgSize = MaxPbftMsgSize();
         setBlockConfirmMsgKnown.max_size(maxPbftMsgSize);
@@ -303,7 +315,7 @@ public:
     }
 
     // requires LOCK(cs_vRecvMsg)
-    bool ReceiveMsgBytes(const char* pch, uint32_t nBytes);
+    bool ReceiveMsgBytes(const char* pch, uint32_t nBytes, bool& fComplete);
 
     // requires LOCK(cs_vRecvMsg)
     void SetRecvVersion(int32_t nVersionIn) {
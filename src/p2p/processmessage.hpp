@@ -58,6 +58,12 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
             return true;
     }
 
+    else if (strCommand == NetMsgType::HEADERS &&
+            !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessHeadersMessage(pFrom, vRecv))
+            return false;
+    }
+
     else if (strCommand == NetMsgType::TX) {
         if (!ProcessTxMessage(pFrom, strCommand, vRecv))
             return false;
@@ -69,6 +75,27 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
         ProcessBlockMessage(pFrom, vRecv);
     }
 
+    else if (strCommand == NetMsgType::SENDCMPCT) {
+        ProcessSendCompactMessage(pFrom, vRecv);
+    }
+
+    else if (strCommand == NetMsgType::CMPCTBLOCK &&
+            !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessCompactBlockMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == NetMsgType::GETBLOCKTXN) {
+        if (!ProcessGetBlockTxnMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == NetMsgType::BLOCKTXN &&
+            !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessBlockTxnMessage(pFrom, vRecv))
+            return false;
+    }
+
     else if (strCommand == NetMsgType::GETADDR) {
         pFrom->vAddrToSend.clear();
         vector<CAddress> vAddr = addrman.GetAddr();
@@ -208,6 +235,14 @@ bool ProcessMessages(CNode *pFrom) {
         }
         string strCommand = hdr.GetCommand();
 
+        // time the message waits from being received to being processed, which is one part of the relay latency
+        // of each hop
+        int64_t waitTime = std::max<int64_t>(0, GetTimeMicros() - msg.nTime);
+        METRIC_HISTOGRAM("p2p message wait to process").Record(waitTime);
+        if (strCommand == NetMsgType::BLOCK || strCommand == NetMsgType::CONFIRMBLOCK ||
+            strCommand == NetMsgType::FINALITYBLOCK)
+            METRIC_HISTOGRAM("p2p block message wait to process").Record(waitTime);
+
         // Message size
         uint32_t nMessageSize = hdr.nMessageSize;
 
@@ -131,7 +131,7 @@ extern const char *TX;
  * @since protocol version 31800.
  * @see https://bitcoin.org/en/developer-reference#headers
  */
-// extern const char *HEADERS;
+extern const char *HEADERS;
 /**
  * The block message transmits a single serialized block.
  * @see https://bitcoin.org/en/developer-reference#block
@@ -388,6 +388,8 @@ enum
     // Nodes may always request a MSG_FILTERED_BLOCK in a getdata, however,
     // MSG_FILTERED_BLOCK should not appear in any invs except as a part of getdata.
     MSG_FILTERED_BLOCK,
+    // Requests a cmpctblock message, sent only to the peers announcing the compact blocks by sendcmpct.
+    MSG_CMPCT_BLOCK,
 };
 
 #endif // __INCLUDED_PROTOCOL_H__
@@ -9,6 +9,8 @@
 #include "main.h"
 #include "chainmessage.h"
 
+extern CNode *pnodeSync;
+
 namespace {
 struct CMainSignals {
     // Notifies listeners of updated transaction data (passing hash, transaction, and optionally the block it is found
@@ -67,11 +69,16 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
             //LogPrint(BCLog::NET, "send ping: %s\n", DateTimeStrFormat("YYYY-MM-DDTHH-MM-SS", pTo->nPingUsecStart).c_str());
         }
 
+        // the new blocks are requested as compact blocks, the initial sync ones are not in the mempool
+        bool fCompactBlocks = false;
         {
             TRY_LOCK(cs_main, lockMain);  // Acquire cs_main for IsInitialBlockDownload() and CNodeState()
             if (!lockMain)
                 return true;
 
+            fCompactBlocks = pTo->fCompactBlocks && !IsInitialBlockDownload() &&
+                             SysCfg().GetBoolArg("-compactblocks", true);
+
             // Address refresh broadcast
             static int64_t nLastRebroadcast;
             if (!IsInitialBlockDownload() && (GetTime() - nLastRebroadcast > 24 * 60 * 60)) {
@@ -119,8 +126,16 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
             if (pTo->fStartSync && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
                 pTo->fStartSync = false;
                 nSyncTipHeight  = pTo->nStartingHeight;
-                LogPrint(BCLog::NET, "start block sync lead to getblocks\n");
-                PushGetBlocks(pTo, chainActive.Tip(), uint256());
+                if (!StartParallelSync(pTo)) {
+                    LogPrint(BCLog::NET, "start block sync lead to getheaders\n");
+                    PushGetHeaders(pTo);
+                }
+            } else if (pTo == pnodeSync && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+                // ask the sync peer for more headers, or restart the parallel download stopped by an unexpected block
+                if (!blockDownloadScheduler.IsActive())
+                    StartParallelSync(pTo);
+                else if (blockDownloadScheduler.NeedMoreHashes(GetTimeMicros()))
+                    PushGetSyncHeaders(pTo);
             }
 
             // Resend wallet transactions that haven't gotten in a block yet
@@ -211,15 +226,30 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
             LogPrint(BCLog::INFO, "Peer %s is stalling block download, disconnecting\n", state.name.c_str());
             pTo->fDisconnect = true;
         }
+        if (!pTo->fDisconnect && blockDownloadScheduler.IsStallingNode(pTo->GetId(), nNow)) {
+            LogPrint(BCLog::INFO, "Peer %s is stalling the parallel block download, disconnecting\n", state.name.c_str());
+            pTo->fDisconnect = true;
+        }
 
         //
         // Message: getdata (blocks)
         //
         vector<CInv> vGetData;
+        if (!pTo->fDisconnect && !pTo->fClient && blockDownloadScheduler.IsActive()) {
+            blockDownloadScheduler.CheckStalledWindows(nNow, BLOCK_DOWNLOAD_WINDOW_TIMEOUT * 1000000);
+            // the sync peer has all of the blocks it announced
+            int32_t peerHeight = (pTo == pnodeSync) ? std::numeric_limits<int32_t>::max() : pTo->nStartingHeight;
+            for (const auto &hash : blockDownloadScheduler.GetBlocksToRequest(
+                     pTo->GetId(), peerHeight, MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, nNow)) {
+                vGetData.push_back(CInv(MSG_BLOCK, hash));
+                MarkBlockAsInFlight(hash, pTo->GetId());
+            }
+        }
+
         int32_t index = 0;
         while (!pTo->fDisconnect && state.nBlocksToDownload && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
             uint256 hash = state.vBlocksToDownload.front();
-            vGetData.push_back(CInv(MSG_BLOCK, hash));
+            vGetData.push_back(CInv(fCompactBlocks ? MSG_CMPCT_BLOCK : MSG_BLOCK, hash));
             MarkBlockAsInFlight(hash, pTo->GetId());
             LogPrint(BCLog::NET, "send MSG_BLOCK msg! time_ms=%lld, hash=%s, peer=%s, FlightBlocks=%d, index=%d\n",
                 GetTimeMillis(), hash.ToString(), state.name, state.nBlocksInFlight, index++);
@@ -0,0 +1,148 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "socketevents.h"
+
+#include "logging.h"
+#include "netbase.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+using namespace std;
+
+class CSelectSocketEvents : public CSocketEvents {
+public:
+    const char *GetName() const override { return "select"; }
+    bool IsEdgeTriggered() const override { return false; }
+
+    bool AddSocket(SOCKET hSocket, bool fListen) override { return true; }
+
+    bool Wait(int64_t timeoutMs, const vector<SOCKET> &recvWanted, const vector<SOCKET> &sendWanted,
+              unordered_set<SOCKET> &recvReady, unordered_set<SOCKET> &sendReady) override {
+        struct timeval timeout;
+        timeout.tv_sec  = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+        fd_set fdsetRecv;
+        fd_set fdsetSend;
+        fd_set fdsetError;
+        FD_ZERO(&fdsetRecv);
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        SOCKET hSocketMax = 0;
+        bool have_fds     = false;
+
+        // select() can not watch the sockets beyond FD_SETSIZE
+        for (auto hSocket : recvWanted) {
+            if (hSocket >= FD_SETSIZE)
+                continue;
+            FD_SET(hSocket, &fdsetRecv);
+            FD_SET(hSocket, &fdsetError);
+            hSocketMax = max(hSocketMax, hSocket);
+            have_fds   = true;
+        }
+        for (auto hSocket : sendWanted) {
+            if (hSocket >= FD_SETSIZE)
+                continue;
+            FD_SET(hSocket, &fdsetSend);
+            FD_SET(hSocket, &fdsetError);
+            hSocketMax = max(hSocketMax, hSocket);
+            have_fds   = true;
+        }
+
+        int32_t nSelect = select(have_fds ? hSocketMax + 1 : 0, &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+        if (nSelect == SOCKET_ERROR) {
+            if (have_fds)
+                LogPrint(BCLog::INFO, "socket select error %s\n", NetworkErrorString(WSAGetLastError()));
+            return false;
+        }
+
+        for (auto hSocket : recvWanted) {
+            if (hSocket < FD_SETSIZE && (FD_ISSET(hSocket, &fdsetRecv) || FD_ISSET(hSocket, &fdsetError)))
+                recvReady.insert(hSocket);
+        }
+        for (auto hSocket : sendWanted) {
+            if (hSocket >= FD_SETSIZE)
+                continue;
+            if (FD_ISSET(hSocket, &fdsetSend))
+                sendReady.insert(hSocket);
+            if (FD_ISSET(hSocket, &fdsetError))
+                recvReady.insert(hSocket);
+        }
+        return true;
+    }
+};
+
+#ifdef HAVE_SYS_EPOLL_H
+class CEpollSocketEvents : public CSocketEvents {
+public:
+    static const int32_t MAX_EVENTS = 256;
+
+public:
+    explicit CEpollSocketEvents(int32_t fdIn) : fd(fdIn) {}
+    ~CEpollSocketEvents() { close(fd); }
+
+    const char *GetName() const override { return "epoll"; }
+    bool IsEdgeTriggered() const override { return true; }
+
+    bool AddSocket(SOCKET hSocket, bool fListen) override {
+        struct epoll_event event = {};
+        event.events  = fListen ? EPOLLIN : (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+        event.data.fd = hSocket;
+        if (epoll_ctl(fd, EPOLL_CTL_ADD, hSocket, &event) == 0)
+            return true;
+        // the number of a closed socket is reused by the new one
+        if (errno == EEXIST && epoll_ctl(fd, EPOLL_CTL_MOD, hSocket, &event) == 0)
+            return true;
+
+        LogPrint(BCLog::INFO, "epoll_ctl add socket %u error %s\n", hSocket, NetworkErrorString(errno));
+        return false;
+    }
+
+    // the wanted sockets are ignored, all of the added sockets are watched
+    bool Wait(int64_t timeoutMs, const vector<SOCKET> &recvWanted, const vector<SOCKET> &sendWanted,
+              unordered_set<SOCKET> &recvReady, unordered_set<SOCKET> &sendReady) override {
+        struct epoll_event events[MAX_EVENTS];
+        int32_t count = epoll_wait(fd, events, MAX_EVENTS, timeoutMs);
+        if (count < 0) {
+            if (errno == EINTR)
+                return true;
+            LogPrint(BCLog::INFO, "socket epoll_wait error %s\n", NetworkErrorString(errno));
+            return false;
+        }
+
+        for (int32_t i = 0; i < count; i++) {
+            SOCKET hSocket = events[i].data.fd;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+                recvReady.insert(hSocket);
+            if (events[i].events & EPOLLOUT)
+                sendReady.insert(hSocket);
+        }
+        return true;
+    }
+
+private:
+    int32_t fd;
+};
+#endif
+
+unique_ptr<CSocketEvents> MakeSocketEvents(const string &mode) {
+    if (mode == "select")
+        return unique_ptr<CSocketEvents>(new CSelectSocketEvents());
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (mode == "epoll") {
+        int32_t fd = epoll_create1(EPOLL_CLOEXEC);
+        if (fd < 0) {
+            LogPrint(BCLog::INFO, "epoll_create1 error %s\n", NetworkErrorString(errno));
+            return nullptr;
+        }
+        return unique_ptr<CSocketEvents>(new CEpollSocketEvents(fd));
+    }
+#endif
+
+    return nullptr;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_SOCKETEVENTS_H
+#define P2P_SOCKETEVENTS_H
+
+#if defined(HAVE_CONFIG_H)
+#include "config/coin-config.h"
+#endif
+
+#include "commons/compat/compat.h"
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/** Default for -socketevents */
+#ifdef HAVE_SYS_EPOLL_H
+static const char *const DEFAULT_SOCKET_EVENTS = "epoll";
+#else
+static const char *const DEFAULT_SOCKET_EVENTS = "select";
+#endif
+
+/**
+ * Waits for the sockets of the socket handler to be ready.
+ *
+ * The level-triggered implementations (select) report the sockets in the wanted lists which are ready now, so they
+ * are asked again in each round. The edge-triggered implementations (epoll) watch the added sockets all along and
+ * report a socket only when it becomes ready, so the caller keeps a socket ready until it would block.
+ */
+class CSocketEvents {
+public:
+    virtual ~CSocketEvents() {}
+
+    virtual const char *GetName() const = 0;
+    virtual bool IsEdgeTriggered() const = 0;
+
+    /** Watch the socket until it is closed, the listen sockets are always reported while they are ready */
+    virtual bool AddSocket(SOCKET hSocket, bool fListen) = 0;
+
+    /**
+     * Wait up to timeoutMs for the sockets to be ready. The sockets with errors are reported as ready to receive,
+     * the following recv() tells the error. Return false if the wait itself failed.
+     */
+    virtual bool Wait(int64_t timeoutMs, const std::vector<SOCKET> &recvWanted, const std::vector<SOCKET> &sendWanted,
+                      std::unordered_set<SOCKET> &recvReady, std::unordered_set<SOCKET> &sendReady) = 0;
+};
+
+/** Create the implementation by -socketevents mode, return nullptr if it is not supported */
+std::unique_ptr<CSocketEvents> MakeSocketEvents(const std::string &mode);
+
+#endif  // P2P_SOCKETEVENTS_H
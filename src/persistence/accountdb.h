@@ -33,6 +33,10 @@ public:
         regId2KeyIdCache(pBase->regId2KeyIdCache),
         accountCache(pBase->accountCache) {}
 
+    CAccountDBCache(const CAccountDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : regId2KeyIdCache(topCache.regId2KeyIdCache, pSnapshotDbAccess),
+          accountCache(topCache.accountCache, pSnapshotDbAccess) {}
+
     ~CAccountDBCache() {}
 
 public:
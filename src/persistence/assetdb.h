@@ -89,6 +89,11 @@ public:
                                             axc_swap_coin_ps_cache(pBaseIn->axc_swap_coin_ps_cache),
                                             axc_swap_coin_sp_cache(pBaseIn->axc_swap_coin_sp_cache) {};
 
+    CAssetDbCache(const CAssetDbCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : asset_cache(topCache.asset_cache, pSnapshotDbAccess),
+          axc_swap_coin_ps_cache(topCache.axc_swap_coin_ps_cache, pSnapshotDbAccess),
+          axc_swap_coin_sp_cache(topCache.axc_swap_coin_sp_cache, pSnapshotDbAccess) {}
+
     ~CAssetDbCache() {}
 
 public:
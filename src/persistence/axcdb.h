@@ -25,6 +25,9 @@ public:
     CAxcDBCache(CDBAccess *pDbAccess) : axc_swapin_cache(pDbAccess) {}
     CAxcDBCache(CAxcDBCache *pBaseIn) : axc_swapin_cache(pBaseIn->axc_swapin_cache){};
 
+    CAxcDBCache(const CAxcDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : axc_swapin_cache(topCache.axc_swapin_cache, pSnapshotDbAccess) {}
+
     bool Flush() {
         axc_swapin_cache.Flush();
         return true;
@@ -5,6 +5,7 @@
 
 #include "block.h"
 
+#include "crypto/sha256.h"
 #include "entities/account.h"
 #include "tx/blockpricemediantx.h"
 #include "main.h"
@@ -25,16 +26,23 @@ uint256 CBlockHeader::ComputeSignatureHash() const {
 }
 
 uint256 CBlock::BuildMerkleTree() const {
+    static_assert(sizeof(uint256) == 32, "uint256 must be packed for batched hashing");
+
     vMerkleTree.clear();
+    vMerkleTree.reserve(vptx.size() * 2 + 32);
     for (const auto& ptx : vptx) {
         vMerkleTree.push_back(ptx->GetHash());
     }
     int32_t j = 0;
     for (int32_t nSize = vptx.size(); nSize > 1; nSize = (nSize + 1) / 2) {
-        for (int32_t i = 0; i < nSize; i += 2) {
-            int32_t i2 = min(i + 1, nSize - 1);
-            vMerkleTree.push_back(Hash(BEGIN(vMerkleTree[j + i]), END(vMerkleTree[j + i]),
-                                       BEGIN(vMerkleTree[j + i2]), END(vMerkleTree[j + i2])));
+        // the sibling pairs of a level are adjacent in memory, so hash them in one batch of 64-byte blobs,
+        // and the last node of an odd sized level is paired with itself
+        int32_t pairCount = nSize / 2;
+        vMerkleTree.resize(j + nSize + (nSize + 1) / 2);
+        SHA256D64(vMerkleTree[j + nSize].begin(), vMerkleTree[j].begin(), pairCount);
+        if (nSize & 1) {
+            const uint256 &last = vMerkleTree[j + nSize - 1];
+            vMerkleTree[j + nSize + pairCount] = Hash(BEGIN(last), END(last), BEGIN(last), END(last));
         }
         j += nSize;
     }
@@ -186,19 +194,106 @@ bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) {
     return true;
 }
 
+uint64_t GetBlockMapMemoryUsage(const BlockMap &blockMap) {
+    // a node holds the next pointer and the cached hash code besides the item
+    return blockMap.bucket_count() * sizeof(void *) +
+           blockMap.size() * (sizeof(BlockMap::value_type) + sizeof(void *) + sizeof(size_t));
+}
+
+CBlockIndex *CBlockIndexArena::Allocate() {
+    if (lastChunkUsed == CHUNK_SIZE) {
+        chunks.emplace_back(new CBlockIndex[CHUNK_SIZE]);
+        lastChunkUsed = 0;
+    }
+
+    count++;
+    return &chunks.back()[lastChunkUsed++];
+}
+
+void CBlockIndexArena::Merge(CBlockIndexArena &other) {
+    if (chunks.empty()) {
+        std::swap(chunks, other.chunks);
+        std::swap(count, other.count);
+        std::swap(lastChunkUsed, other.lastChunkUsed);
+        return;
+    }
+
+    // keep allocating from the own last chunk, the rest of the last chunk of the other arena is left unused
+    chunks.insert(chunks.end() - 1, std::make_move_iterator(other.chunks.begin()),
+                  std::make_move_iterator(other.chunks.end()));
+    count += other.count;
+    other.Clear();
+}
+
+void CBlockIndexArena::Clear() {
+    chunks.clear();
+    count         = 0;
+    lastChunkUsed = CHUNK_SIZE;
+}
+
+bool ReadRawBlockFromDisk(const CDiskBlockPos &pos, CDataStream &ssBlock) {
+    // the block is stored after the message start and its size
+    char header[MESSAGE_START_SIZE + sizeof(uint32_t)];
+    if (pos.nPos < sizeof(header))
+        return ERRORMSG("ReadRawBlockFromDisk : invalid block position %u", pos.nPos);
+
+    if (!ReadBlockFileData(CDiskBlockPos(pos.nFile, pos.nPos - sizeof(header)), header, sizeof(header)))
+        return ERRORMSG("ReadRawBlockFromDisk : read the block header failed");
+
+    if (memcmp(header, SysCfg().MessageStart(), MESSAGE_START_SIZE))
+        return ERRORMSG("ReadRawBlockFromDisk : message start mismatch at position %u", pos.nPos);
+
+    uint32_t nSize = 0;
+    memcpy(&nSize, header + MESSAGE_START_SIZE, sizeof(nSize));
+    if (nSize == 0 || nSize > MAX_BLOCK_SIZE)
+        return ERRORMSG("ReadRawBlockFromDisk : invalid block size %u", nSize);
+
+    ssBlock.resize(nSize);
+    if (!ReadBlockFileData(pos, (char *)&ssBlock[0], nSize))
+        return ERRORMSG("ReadRawBlockFromDisk : read the block failed");
+
+    return true;
+}
+
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx) {
-    auto pBlock = std::make_shared<CBlock>();
     const CBlockIndex* pBlockIndex = chainActive[ txCord.GetHeight() ];
     if (pBlockIndex == nullptr) {
         return ERRORMSG("ReadBaseTxFromDisk error, the height(%d) is exceed current best block height", txCord.GetHeight());
     }
-    if (!ReadBlockFromDisk(pBlockIndex, *pBlock)) {
-        return ERRORMSG("ReadBaseTxFromDisk error, read the block at height(%d) failed!", txCord.GetHeight());
+
+    // the txs have no size prefix, so the txs before it are read but not the rest of the block
+    CAutoFile filein = CAutoFile(OpenBlockFile(pBlockIndex->GetBlockPos(), true), SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("ReadBaseTxFromDisk error, open the block at height(%d) failed!", txCord.GetHeight());
+
+    try {
+        CBlockHeader header;
+        filein >> header;
+        uint64_t txCount = ReadCompactSize(filein);
+        if (txCord.GetIndex() >= txCount) {
+            return ERRORMSG("ReadBaseTxFromDisk error, the tx(%s) index exceed the tx count of block", txCord.ToString());
+        }
+        for (uint32_t index = 0; index <= txCord.GetIndex(); index++)
+            filein >> pTx;
+    } catch (std::exception &e) {
+        return ERRORMSG("ReadBaseTxFromDisk error, read the block at height(%d) failed: %s", txCord.GetHeight(), e.what());
     }
-    if (txCord.GetIndex() >= pBlock->vptx.size()) {
-        return ERRORMSG("ReadBaseTxFromDisk error, the tx(%s) index exceed the tx count of block", txCord.ToString());
+    return true;
+}
+
+bool ReadBaseTxFromDisk(const CDiskTxPos &pos, CBlockHeader &header, std::shared_ptr<CBaseTx> &pTx) {
+    CAutoFile filein = CAutoFile(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("ReadBaseTxFromDisk : OpenBlockFile failed, %s", pos.ToString());
+
+    try {
+        filein >> header;
+        if (fseek(filein, pos.nTxOffset, SEEK_CUR))
+            return ERRORMSG("ReadBaseTxFromDisk : fseek failed, %s", pos.ToString());
+        filein >> pTx;
+    } catch (std::exception &e) {
+        return ERRORMSG("ReadBaseTxFromDisk : Deserialize or I/O error - %s", e.what());
     }
-    pTx = pBlock->vptx.at(txCord.GetIndex())->GetNewInstance();
     return true;
 }
 
@@ -210,4 +305,130 @@ bool GetBlockHeader(CBlockIndex *pBlockIndex, CBlockHeader &header) {
     }
     diskBlockIndex.GetBlockHeader(header);
     return true;
-}
\ No newline at end of file
+}
+
+void CRecentBlockCache::SetMaxCount(uint32_t maxCount) {
+    LOCK(cs_cache);
+    cache.SetMaxSize(maxCount);
+}
+
+CRecentBlockCache::InfoPtr CRecentBlockCache::Put(const CBlockIndex *pIndex, const CBlock &block) {
+    auto pInfo = std::make_shared<CRecentBlockInfo>();
+    pInfo->block_hash = pIndex->GetBlockHash();
+    if (!block.vptx.empty())
+        pInfo->reward_tx = block.vptx[0]->GetNewInstance();
+    pInfo->txids.reserve(block.vptx.size());
+    for (const auto &pTx : block.vptx) {
+        pInfo->txids.push_back(pTx->GetHash());
+    }
+
+    LOCK(cs_cache);
+    cache.Insert(pIndex, pInfo);
+    return pInfo;
+}
+
+CRecentBlockCache::InfoPtr CRecentBlockCache::Get(const CBlockIndex *pIndex) {
+    LOCK(cs_cache);
+    auto ppInfo = cache.Get(pIndex);
+    // the block index may be a temporary one of the block being checked, so verify the hash too
+    if (ppInfo != nullptr && (*ppInfo)->block_hash == pIndex->GetBlockHash()) {
+        hit_count++;
+        return *ppInfo;
+    }
+    miss_count++;
+    return nullptr;
+}
+
+bool CRecentBlockCache::GetOrRead(const CBlockIndex *pIndex, InfoPtr &pInfo) {
+    pInfo = Get(pIndex);
+    if (pInfo)
+        return true;
+
+    CBlock block;
+    if (!ReadBlockFromDisk(pIndex, block))
+        return false;
+
+    pInfo = Put(pIndex, block);
+    return true;
+}
+
+void CRecentBlockCache::Clear() {
+    LOCK(cs_cache);
+    cache.Clear();
+}
+
+CTxBodyCache::CTxBodyCache() : cache(0, [](const decltype(cache)::Item &item) { return item.second->size; }) {}
+
+void CTxBodyCache::SetMaxSize(uint32_t maxBytes) {
+    LOCK(cs_cache);
+    max_size = maxBytes;
+    uint64_t evictedCount = cache.GetEvictedCount();
+    cache.SetMaxSize(maxBytes);
+    UpdateMetrics(evictedCount);
+}
+
+void CTxBodyCache::Put(const uint256 &txid, const InfoPtr &pInfo) {
+    Insert(txid, pInfo, true);
+}
+
+CTxBodyCache::InfoPtr CTxBodyCache::Get(const uint256 &txid, const CDiskTxPos &pos) {
+    LOCK(cs_cache);
+    // the tx of a disconnected block is at another position, it is not used and left to be evicted
+    auto ppInfo = cache.Get(txid, false);
+    if (ppInfo != nullptr && (*ppInfo)->IsAt(pos)) {
+        cache.Touch(txid);
+        hit_count++;
+        METRIC_COUNTER("tx_body_cache_hits").Increase();
+        return *ppInfo;
+    }
+    miss_count++;
+    METRIC_COUNTER("tx_body_cache_misses").Increase();
+    return nullptr;
+}
+
+bool CTxBodyCache::GetOrRead(const uint256 &txid, const CDiskTxPos &pos, InfoPtr &pInfo) {
+    pInfo = Get(txid, pos);
+    if (pInfo)
+        return true;
+
+    auto pHeader = std::make_shared<CBlockHeader>();
+    auto pNewInfo = std::make_shared<CTxBodyInfo>();
+    if (!ReadBaseTxFromDisk(pos, *pHeader, pNewInfo->tx) || !pNewInfo->tx)
+        return false;
+
+    pNewInfo->header = pHeader;
+    pNewInfo->size   = ::GetSerializeSize(pNewInfo->tx, SER_DISK, CLIENT_VERSION);
+    pNewInfo->pos    = pos;
+    pInfo            = pNewInfo;
+    // the position may be read from the tx index before a reorg, so the tx put by a newer block is not replaced
+    Insert(txid, pInfo, false);
+    return true;
+}
+
+void CTxBodyCache::Clear() {
+    LOCK(cs_cache);
+    cache.Clear();
+    UpdateMetrics(cache.GetEvictedCount());
+}
+
+void CTxBodyCache::Insert(const uint256 &txid, const InfoPtr &pInfo, bool replace) {
+    if (!IsEnabled())
+        return;
+
+    // the hash is cached by the tx on first use, so the readers sharing the tx never write it
+    pInfo->tx->GetHash();
+
+    LOCK(cs_cache);
+    if (!replace && cache.Exists(txid))
+        return;
+
+    uint64_t evictedCount = cache.GetEvictedCount();
+    cache.Insert(txid, pInfo);
+    UpdateMetrics(evictedCount);
+}
+
+void CTxBodyCache::UpdateMetrics(uint64_t prevEvictedCount) {
+    METRIC_COUNTER("tx_body_cache_evictions").Increase(cache.GetEvictedCount() - prevEvictedCount);
+    METRIC_GAUGE("tx_body_cache_count").Set(cache.GetCount());
+    METRIC_GAUGE("tx_body_cache_bytes").Set(cache.GetSize());
+}
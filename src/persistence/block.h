@@ -7,6 +7,7 @@
 #define PERSIST_BLOCK_H
 
 #include "commons/base58.h"
+#include "commons/lrucache.hpp"
 #include "commons/serialize.h"
 #include "commons/uint256.h"
 #include "config/configuration.h"
@@ -23,6 +24,7 @@
 
 #include <stdint.h>
 #include <memory>
+#include <unordered_map>
 
 class CBlockDBCache;
 class CDiskBlockPos;
@@ -305,6 +307,37 @@ public:
     const CBlockIndex *GetAncestor(int32_t heightIn) const;
 };
 
+/**
+ * The block indexes by the block hash. The nodes of the map never move, so pBlockHash of an index points to its key.
+ */
+typedef std::unordered_map<uint256, CBlockIndex *, CUint256Hasher> BlockMap;
+
+/** Estimated heap usage of the buckets and nodes of a block map */
+uint64_t GetBlockMapMemoryUsage(const BlockMap &blockMap);
+
+/**
+ * The storage of the block indexes, which are allocated in contiguous chunks instead of one heap object each and
+ * freed all together, so the pointers to them keep valid until Clear(). Protected by cs_main.
+ */
+class CBlockIndexArena {
+public:
+    static const size_t CHUNK_SIZE = 4096;
+
+public:
+    CBlockIndex *Allocate();
+    /** Take over the indexes of another arena, e.g. the one filled by a loading thread, and leave it empty */
+    void Merge(CBlockIndexArena &other);
+    void Clear();
+
+    size_t GetCount() const { return count; }
+    uint64_t GetMemoryUsage() const { return chunks.size() * CHUNK_SIZE * sizeof(CBlockIndex); }
+
+private:
+    std::vector<std::unique_ptr<CBlockIndex[]>> chunks;
+    size_t count         = 0;
+    size_t lastChunkUsed = CHUNK_SIZE;  // the indexes allocated in the last chunk
+};
+
 struct CBlockIndexWorkComparator {
     bool operator()(CBlockIndex *pa, CBlockIndex *pb) const {
 
@@ -451,9 +484,13 @@ struct CBlockLocator {
 bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos);
 bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block);
 bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block);
+/** Read the serialized block as stored, which is the same as it is sent on the network */
+bool ReadRawBlockFromDisk(const CDiskBlockPos &pos, CDataStream &ssBlock);
 
 
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx);
+/** Read the tx at the position of the tx index, seeking to the tx without reading the rest of the block */
+bool ReadBaseTxFromDisk(const CDiskTxPos &pos, CBlockHeader &header, std::shared_ptr<CBaseTx> &pTx);
 
 template<typename TxType>
 bool ReadTxFromDisk(const CTxCord txCord, std::shared_ptr<TxType> &pTx) {
@@ -472,4 +509,92 @@ bool ReadTxFromDisk(const CTxCord txCord, std::shared_ptr<TxType> &pTx) {
 
 bool GetBlockHeader(CBlockIndex *pBlockIndex, CBlockHeader &header);
 
+/** The data of a connected block needed again after it becomes old */
+struct CRecentBlockInfo {
+    uint256 block_hash;
+    std::shared_ptr<CBaseTx> reward_tx;  // copy of the block reward tx, the first tx of block
+    vector<uint256> txids;
+};
+
+/**
+ * Bounded LRU cache of the recently connected blocks keyed by block index, the mature block reward and the
+ * tx memory cache window need the old blocks and would read them from disk otherwise.
+ */
+class CRecentBlockCache {
+public:
+    typedef std::shared_ptr<const CRecentBlockInfo> InfoPtr;
+
+public:
+    CRecentBlockCache() : cache(0) {}
+
+    void SetMaxCount(uint32_t maxCount);
+
+    InfoPtr Put(const CBlockIndex *pIndex, const CBlock &block);
+    InfoPtr Get(const CBlockIndex *pIndex);
+    // get from cache, or read the block from disk and put it into cache
+    bool GetOrRead(const CBlockIndex *pIndex, InfoPtr &pInfo);
+
+    void Clear();
+
+    uint64_t GetHitCount() const { return hit_count; }
+    uint64_t GetMissCount() const { return miss_count; }
+
+private:
+    CCriticalSection cs_cache;
+    CLruCache<const CBlockIndex *, InfoPtr> cache;
+    uint64_t hit_count  = 0;
+    uint64_t miss_count = 0;
+};
+
+/** A confirmed tx as stored in the block file with the header of its block */
+struct CTxBodyInfo {
+    std::shared_ptr<CBaseTx> tx;  // shared by the readers, must not be changed
+    std::shared_ptr<const CBlockHeader> header;
+    uint32_t size = 0;            // serialized size of the tx
+    CDiskTxPos pos;               // position of the tx in the block file
+
+    bool IsAt(const CDiskTxPos &posIn) const {
+        return (CDiskBlockPos)pos == (CDiskBlockPos)posIn && pos.nTxOffset == posIn.nTxOffset;
+    }
+};
+
+/**
+ * Bounded LRU cache of the confirmed txs keyed by txid, bounded by the serialized size of the txs. The txs are put by
+ * ConnectBlock and by the reads from the block file. The readers look up the tx index first and only take the tx at
+ * the indexed position, so the txs of the disconnected blocks are not found.
+ */
+class CTxBodyCache {
+public:
+    typedef std::shared_ptr<const CTxBodyInfo> InfoPtr;
+
+public:
+    CTxBodyCache();
+
+    void SetMaxSize(uint32_t maxBytes);
+    bool IsEnabled() const { return max_size > 0; }
+
+    // put the tx of a connected block, replacing the tx of the same txid
+    void Put(const uint256 &txid, const InfoPtr &pInfo);
+    // get the tx at the position of the tx index
+    InfoPtr Get(const uint256 &txid, const CDiskTxPos &pos);
+    // get from cache, or read the tx at the position of the tx index and put it into cache if absent
+    bool GetOrRead(const uint256 &txid, const CDiskTxPos &pos, InfoPtr &pInfo);
+
+    void Clear();
+
+    uint64_t GetHitCount() const { return hit_count; }
+    uint64_t GetMissCount() const { return miss_count; }
+
+private:
+    void Insert(const uint256 &txid, const InfoPtr &pInfo, bool replace);
+    void UpdateMetrics(uint64_t prevEvictedCount);
+
+private:
+    CCriticalSection cs_cache;
+    CLruCache<uint256, InfoPtr, CUint256Hasher> cache;
+    uint32_t max_size   = 0;
+    uint64_t hit_count  = 0;
+    uint64_t miss_count = 0;
+};
+
 #endif  // PERSIST_BLOCK_H
\ No newline at end of file
@@ -28,48 +28,108 @@ bool CBlockIndexDB::EraseBlockIndex(const uint256 &blockHash) {
     return Erase(dbk::GenDbKey(dbk::BLOCK_INDEX, blockHash));
 }
 
-bool CBlockIndexDB::LoadBlockIndexes() {
-    leveldb::Iterator *pCursor = NewIterator();
+namespace {
+
+// a block index decoded by a loading thread, waiting to be linked into mapBlockIndex
+struct CLoadedBlockIndex {
+    CBlockIndex *pIndex;
+    uint256 hash;
+    uint256 hashPrev;
+};
+
+}  // namespace
+
+bool CBlockIndexDB::LoadBlockIndexes(CWorkerPool &workerPool) {
     const std::string &prefix = dbk::GetKeyPrefix(dbk::BLOCK_INDEX);
 
-    pCursor->Seek(prefix);
+    // The keys are the prefix followed by the block hash, whose first byte splits them into even ranges. Each range
+    // is decoded by one job into its own arena, as hashing the headers takes most of the time.
+    size_t rangeCount = std::min<size_t>(256, (workerPool.GetThreadCount() + 1) * 4);
+    vector<CBlockIndexArena> arenas(rangeCount);
+    vector<vector<CLoadedBlockIndex>> loadedIndexes(rangeCount);
+    vector<string> errors(rangeCount);
 
-    // Load mapBlockIndex
-    while (pCursor->Valid()) {
-        boost::this_thread::interruption_point();
-        try {
+    workerPool.Run(rangeCount, [&](size_t range) {
+        const string beginKey = prefix + char(range * 256 / rangeCount);
+        const string endKey   = prefix + char((range + 1) * 256 / rangeCount);
+        const bool fLastRange = (range + 1 == rangeCount);
+
+        std::unique_ptr<leveldb::Iterator> pCursor(NewIterator());
+        for (pCursor->Seek(beginKey); pCursor->Valid(); pCursor->Next()) {
             leveldb::Slice slKey = pCursor->key();
-            if (slKey.starts_with(prefix)) {
+            if (!slKey.starts_with(prefix) || (!fLastRange && slKey.compare(endKey) >= 0))
+                break;
+
+            try {
                 leveldb::Slice slValue = pCursor->value();
                 CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
                 CDiskBlockIndex diskIndex;
                 ssValue >> diskIndex;
 
                 // Construct block index object
-                CBlockIndex *pIndexNew    = InsertBlockIndex(diskIndex.GetBlockHash());
-                pIndexNew->pprev          = InsertBlockIndex(diskIndex.hashPrev);
-                pIndexNew->height         = diskIndex.height;
-                pIndexNew->nFile          = diskIndex.nFile;
-                pIndexNew->nDataPos       = diskIndex.nDataPos;
-                pIndexNew->nUndoPos       = diskIndex.nUndoPos;
-                pIndexNew->nVersion       = diskIndex.nVersion;
-                pIndexNew->nTime          = diskIndex.nTime;
-                pIndexNew->nStatus        = diskIndex.nStatus;
-                pIndexNew->nFuelFee       = diskIndex.nFuelFee;
-                pIndexNew->nFuelRate      = diskIndex.nFuelRate;
-
-                if (!pIndexNew->CheckIndex())
-                    return ERRORMSG("LoadBlockIndex() : CheckIndex failed: %s", pIndexNew->ToString());
-
-                pCursor->Next();
-            } else {
-                break;  // if shutdown requested or finished loading block index
+                CBlockIndex *pIndexNew = arenas[range].Allocate();
+                pIndexNew->height      = diskIndex.height;
+                pIndexNew->nFile       = diskIndex.nFile;
+                pIndexNew->nDataPos    = diskIndex.nDataPos;
+                pIndexNew->nUndoPos    = diskIndex.nUndoPos;
+                pIndexNew->nVersion    = diskIndex.nVersion;
+                pIndexNew->nTime       = diskIndex.nTime;
+                pIndexNew->nStatus     = diskIndex.nStatus;
+                pIndexNew->nFuelFee    = diskIndex.nFuelFee;
+                pIndexNew->nFuelRate   = diskIndex.nFuelRate;
+
+                if (!pIndexNew->CheckIndex()) {
+                    errors[range] = strprintf("CheckIndex failed: %s", pIndexNew->ToString());
+                    return;
+                }
+
+                loadedIndexes[range].push_back({pIndexNew, diskIndex.GetBlockHash(), diskIndex.hashPrev});
+            } catch (std::exception &e) {
+                errors[range] = strprintf("Deserialize or I/O error - %s", e.what());
+                return;
             }
-        } catch (std::exception &e) {
-            return ERRORMSG("Deserialize or I/O error - %s", e.what());
+        }
+    });
+
+    size_t totalCount = 0;
+    for (size_t range = 0; range < rangeCount; range++) {
+        if (!errors[range].empty())
+            return ERRORMSG("LoadBlockIndex() : %s", errors[range]);
+
+        totalCount += loadedIndexes[range].size();
+    }
+
+    boost::this_thread::interruption_point();
+
+    // the map is sized once, so the insertions never rehash it
+    mapBlockIndex.reserve(mapBlockIndex.size() + totalCount);
+    for (size_t range = 0; range < rangeCount; range++) {
+        blockIndexArena.Merge(arenas[range]);
+        for (const auto &loaded : loadedIndexes[range]) {
+            auto ret = mapBlockIndex.emplace(loaded.hash, loaded.pIndex);
+            if (!ret.second)
+                return ERRORMSG("LoadBlockIndex() : duplicated block index %s", loaded.hash.GetHex());
+
+            loaded.pIndex->pBlockHash = &ret.first->first;
+        }
+    }
+
+    // the map is read only while the parents are linked in parallel
+    workerPool.Run(rangeCount, [&](size_t range) {
+        for (const auto &loaded : loadedIndexes[range]) {
+            auto it = mapBlockIndex.find(loaded.hashPrev);
+            if (it != mapBlockIndex.end())
+                loaded.pIndex->pprev = it->second;
+        }
+    });
+
+    // a parent never stored gets an empty index
+    for (const auto &indexes : loadedIndexes) {
+        for (const auto &loaded : indexes) {
+            if (loaded.pIndex->pprev == nullptr && !loaded.hashPrev.IsNull())
+                loaded.pIndex->pprev = InsertBlockIndex(loaded.hashPrev);
         }
     }
-    delete pCursor;
 
     return true;
 }
@@ -86,15 +146,13 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
         return nullptr;
 
     // Return existing
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hash);
+    auto mi = mapBlockIndex.find(hash);
     if (mi != mapBlockIndex.end())
         return (*mi).second;
 
     // Create new
-    CBlockIndex *pIndexNew = new CBlockIndex();
-    if (!pIndexNew)
-        throw runtime_error("new CBlockIndex failed");
-    mi                    = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
+    CBlockIndex *pIndexNew = blockIndexArena.Allocate();
+    mi                     = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
     pIndexNew->pBlockHash = &((*mi).first);
 
     return pIndexNew;
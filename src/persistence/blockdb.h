@@ -13,6 +13,7 @@
 #include "leveldbwrapper.h"
 #include "dbaccess.h"
 #include "persistence/block.h"
+#include "commons/workerpool.h"
 
 #include <map>
 
@@ -67,7 +68,8 @@ public:
     bool GetBlockIndex(const uint256 &hash, CDiskBlockIndex &blockIndex);
     bool WriteBlockIndex(const CDiskBlockIndex &blockIndex);
     bool EraseBlockIndex(const uint256 &blockHash);
-    bool LoadBlockIndexes();
+    /** Load the block indexes into mapBlockIndex, decoding the ranges of the keys on the worker pool */
+    bool LoadBlockIndexes(CWorkerPool &workerPool);
 
     bool ReadBlockFileInfo(int32_t nFile, CBlockFileInfo &fileinfo);
     bool WriteBlockFileInfo(int32_t nFile, const CBlockFileInfo &fileinfo);
@@ -99,6 +101,15 @@ public:
             finality_block_cache(pBaseIn->finality_block_cache),
             block_inflated_reward_cache(pBaseIn->block_inflated_reward_cache){};
 
+    CBlockDBCache(const CBlockDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : tx_diskpos_cache(topCache.tx_diskpos_cache, pSnapshotDbAccess),
+          flag_cache(topCache.flag_cache, pSnapshotDbAccess),
+          best_block_hash_cache(topCache.best_block_hash_cache, pSnapshotDbAccess),
+          last_block_file_cache(topCache.last_block_file_cache, pSnapshotDbAccess),
+          reindex_cache(topCache.reindex_cache, pSnapshotDbAccess),
+          finality_block_cache(topCache.finality_block_cache, pSnapshotDbAccess),
+          block_inflated_reward_cache(topCache.block_inflated_reward_cache, pSnapshotDbAccess) {}
+
 public:
     bool Flush();
     uint32_t GetCacheSize() const;
@@ -129,4 +129,75 @@ bool CBlockUndoExecutor::Execute() {
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CBlockUndoCache
+
+// the txs of block are executed when it is connected again, so the cache and the callers own their copies
+static void CopyBlockTxs(CBlock &block) {
+    for (auto &pTx : block.vptx)
+        pTx = pTx->GetNewInstance();
+}
+
+void CBlockUndoCache::SetMaxCount(uint32_t maxCount) {
+    LOCK(cs_cache);
+    cache.SetMaxSize(maxCount);
+}
+
+void CBlockUndoCache::Put(const CBlockIndex *pIndex, const CBlock &block, const CBlockUndo &blockUndo) {
+    auto pInfo = std::make_shared<CRecentUndoInfo>();
+    pInfo->block_hash = pIndex->GetBlockHash();
+    pInfo->block      = block;
+    CopyBlockTxs(pInfo->block);
+    pInfo->block_undo = std::make_shared<CBlockUndo>(blockUndo);
+
+    LOCK(cs_cache);
+    cache.Insert(pIndex, pInfo);
+}
+
+CBlockUndoCache::InfoPtr CBlockUndoCache::Get(const CBlockIndex *pIndex) {
+    LOCK(cs_cache);
+    auto ppInfo = cache.Get(pIndex);
+    // the block index may be a temporary one of the block being checked, so verify the hash too
+    if (ppInfo != nullptr && (*ppInfo)->block_hash == pIndex->GetBlockHash()) {
+        hit_count++;
+        return *ppInfo;
+    }
+    miss_count++;
+    return nullptr;
+}
+
+bool CBlockUndoCache::ReadBlock(const CBlockIndex *pIndex, CBlock &block) {
+    auto pInfo = Get(pIndex);
+    if (pInfo == nullptr)
+        return ReadBlockFromDisk(pIndex, block);
+
+    block = pInfo->block;
+    CopyBlockTxs(block);
+    return true;
+}
+
+bool CBlockUndoCache::ReadBlockUndo(const CBlockIndex *pIndex, std::shared_ptr<const CBlockUndo> &pBlockUndo) {
+    auto pInfo = Get(pIndex);
+    if (pInfo != nullptr) {
+        pBlockUndo = pInfo->block_undo;
+        return true;
+    }
+
+    CDiskBlockPos pos = pIndex->GetUndoPos();
+    if (pos.IsNull())
+        return ERRORMSG("no undo data available");
+
+    auto pDiskBlockUndo = std::make_shared<CBlockUndo>();
+    if (!pDiskBlockUndo->ReadFromDisk(pos, pIndex->pprev->GetBlockHash()))
+        return ERRORMSG("failure reading undo data");
+
+    pBlockUndo = pDiskBlockUndo;
+    return true;
+}
+
+void CBlockUndoCache::Clear() {
+    LOCK(cs_cache);
+    cache.Clear();
+}
@@ -8,9 +8,11 @@
 
 #include "commons/serialize.h"
 #include "commons/uint256.h"
+#include "block.h"
 #include "cachewrapper.h"
 #include "leveldbwrapper.h"
 #include "disk.h"
+#include "sync.h"
 
 #include <stdint.h>
 #include <memory>
@@ -79,13 +81,52 @@ public:
 class CBlockUndoExecutor {
 public:
     CCacheWrapper &cw;
-    CBlockUndo &block_undo;
+    const CBlockUndo &block_undo;
 
-    CBlockUndoExecutor(CCacheWrapper &cwIn, CBlockUndo &blockUndoIn)
+    CBlockUndoExecutor(CCacheWrapper &cwIn, const CBlockUndo &blockUndoIn)
         : cw(cwIn), block_undo(blockUndoIn) {}
     bool Execute();
 };
 
+/** The block and the undo data of a recently connected block */
+struct CRecentUndoInfo {
+    uint256 block_hash;
+    CBlock block;  // the txs are copies, never executed again
+    std::shared_ptr<const CBlockUndo> block_undo;
+};
+
+/**
+ * Bounded LRU cache of the undo data and the blocks of the recently connected blocks keyed by block index, so
+ * the short reorgs between the competing block producers disconnect and reconnect the blocks without disk.
+ */
+class CBlockUndoCache {
+public:
+    typedef std::shared_ptr<const CRecentUndoInfo> InfoPtr;
+
+public:
+    CBlockUndoCache() : cache(0) {}
+
+    void SetMaxCount(uint32_t maxCount);
+
+    void Put(const CBlockIndex *pIndex, const CBlock &block, const CBlockUndo &blockUndo);
+    InfoPtr Get(const CBlockIndex *pIndex);
+    // get a copy of the block from cache to execute it again, or read it from disk
+    bool ReadBlock(const CBlockIndex *pIndex, CBlock &block);
+    // get the undo data from cache, or read it from disk
+    bool ReadBlockUndo(const CBlockIndex *pIndex, std::shared_ptr<const CBlockUndo> &pBlockUndo);
+
+    void Clear();
+
+    uint64_t GetHitCount() const { return hit_count; }
+    uint64_t GetMissCount() const { return miss_count; }
+
+private:
+    CCriticalSection cs_cache;
+    CLruCache<const CBlockIndex *, InfoPtr> cache;
+    uint64_t hit_count  = 0;
+    uint64_t miss_count = 0;
+};
+
 /** Open an undo file (rev?????.dat) */
 FILE *OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
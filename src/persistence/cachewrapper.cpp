@@ -7,6 +7,8 @@
 #include "main.h"
 #include "logging.h"
 
+#include <boost/filesystem.hpp>
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CCacheWrapper
 
@@ -126,6 +128,12 @@ void CCacheWrapper::Flush() {
 }
 
 void CCacheWrapper::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap) {
+    assert(savepoints.empty() && "can not change the op log map with open savepoints");
+    p_db_op_log_map = pDbOpLogMap;
+    SetCachesDbOpLogMap(pDbOpLogMap);
+}
+
+void CCacheWrapper::SetCachesDbOpLogMap(CDBOpLogMap *pDbOpLogMap) {
     sysParamCache.SetDbOpLogMap(pDbOpLogMap);
     blockCache.SetDbOpLogMap(pDbOpLogMap);
     accountCache.SetDbOpLogMap(pDbOpLogMap);
@@ -161,11 +169,135 @@ UndoDataFuncMap CCacheWrapper::GetUndoDataFuncMap() {
     return undoDataFuncMap;
 }
 
+void CCacheWrapper::Savepoint() {
+    if (savepoints.empty()) {
+        // journal the changes only while any savepoint is open
+        if (p_db_op_log_map == nullptr)
+            SetCachesDbOpLogMap(&savepoint_logs);
+        ppCache.EnableJournal(true);
+    }
+
+    SavepointMark mark;
+    for (const auto &item : GetActiveDbOpLogMap()->GetMap())
+        mark.op_log_sizes[item.first] = item.second.size();
+    mark.price_journal_size = ppCache.GetJournalSize();
+    savepoints.push_back(std::move(mark));
+}
+
+void CCacheWrapper::RollbackToSavepoint() {
+    assert(!savepoints.empty());
+    if (undo_func_map.empty())
+        undo_func_map = GetUndoDataFuncMap();
+
+    const SavepointMark &mark = savepoints.back();
+    for (auto &item : GetActiveDbOpLogMap()->GetMap()) {
+        auto sizeIt = mark.op_log_sizes.find(item.first);
+        size_t logSize = sizeIt != mark.op_log_sizes.end() ? sizeIt->second : 0;
+        CDbOpLogs &dbOpLogs = item.second;
+        if (dbOpLogs.size() <= logSize)
+            continue;
+
+        dbk::PrefixType prefixType = dbk::ParseKeyPrefixType(item.first);
+        auto funcIt = undo_func_map.find(prefixType);
+        if (funcIt == undo_func_map.end())
+            throw runtime_error(strprintf("%s(), unfound undo func of prefix=%s", __func__, item.first));
+
+        // undo the op logs after the savepoint in reverse order, and drop them from the journal
+        CDbOpLogs undoLogs(std::make_move_iterator(dbOpLogs.begin() + logSize),
+                           std::make_move_iterator(dbOpLogs.end()));
+        dbOpLogs.resize(logSize);
+        funcIt->second(undoLogs);
+    }
+    ppCache.RollbackJournal(mark.price_journal_size);
+
+    ReleaseSavepoint();
+}
+
+void CCacheWrapper::ReleaseSavepoint() {
+    assert(!savepoints.empty());
+    savepoints.pop_back();
+    if (savepoints.empty()) {
+        ppCache.EnableJournal(false);
+        if (p_db_op_log_map == nullptr) {
+            SetCachesDbOpLogMap(nullptr);
+            savepoint_logs.Clear();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CStateView
+
+CStateView::CStateView(CCacheDBManager *pCdMan, const uint256 &blockHashIn, int32_t heightIn)
+    : block_hash(blockHashIn), height(heightIn), create_time(GetTimeMillis()) {
+    AssertLockHeld(cs_main);
+    int64_t beginTime = GetTimeMicros();
+
+    caches.sysParamCache  = CSysParamDBCache(*pCdMan->pSysParamCache, NewSnapshotDbAccess(pCdMan->pSysParamDb));
+    caches.blockCache     = CBlockDBCache(*pCdMan->pBlockCache, NewSnapshotDbAccess(pCdMan->pBlockDb));
+    caches.accountCache   = CAccountDBCache(*pCdMan->pAccountCache, NewSnapshotDbAccess(pCdMan->pAccountDb));
+    caches.assetCache     = CAssetDbCache(*pCdMan->pAssetCache, NewSnapshotDbAccess(pCdMan->pAssetDb));
+    caches.contractCache  = CContractDBCache(*pCdMan->pContractCache, NewSnapshotDbAccess(pCdMan->pContractDb));
+    caches.delegateCache  = CDelegateDBCache(*pCdMan->pDelegateCache, NewSnapshotDbAccess(pCdMan->pDelegateDb));
+    caches.cdpCache       = CCdpDBCache(*pCdMan->pCdpCache, NewSnapshotDbAccess(pCdMan->pCdpDb));
+    caches.closedCdpCache = CClosedCdpDBCache(*pCdMan->pClosedCdpCache, NewSnapshotDbAccess(pCdMan->pClosedCdpDb));
+    caches.dexCache       = CDexDBCache(*pCdMan->pDexCache, NewSnapshotDbAccess(pCdMan->pDexDb));
+    caches.txReceiptCache = CTxReceiptDBCache(*pCdMan->pReceiptCache, NewSnapshotDbAccess(pCdMan->pReceiptDb));
+    caches.txUtxoCache    = CTxUTXODBCache(*pCdMan->pUtxoCache, NewSnapshotDbAccess(pCdMan->pUtxoDb));
+    caches.sysGovernCache = CSysGovernDBCache(*pCdMan->pSysGovernCache, NewSnapshotDbAccess(pCdMan->pSysGovernDb));
+    caches.axcCache       = CAxcDBCache(*pCdMan->pAxcCache, NewSnapshotDbAccess(pCdMan->pAxcDb));
+    caches.priceFeedCache = CPriceFeedCache(*pCdMan->pPriceFeedCache, NewSnapshotDbAccess(pCdMan->pPriceFeedDb));
+
+    LogPrint(BCLog::BENCHMARK, "create state view of block[%d]:%s, snapshots=%u, elapsed=%.2fms\n", height,
+             block_hash.ToString(), snapshots.size(), (GetTimeMicros() - beginTime) * 0.001);
+}
+
+CDBAccess* CStateView::NewSnapshotDbAccess(CDBAccess *pDbAccess) {
+    auto pDb = pDbAccess->GetDb();
+    auto &pSnapshot = snapshots[pDb.get()];
+    if (pSnapshot == nullptr)
+        pSnapshot = make_shared<CLevelDBSnapshot>(pDb);
+
+    db_accesses.emplace_back(new CDBAccess(*pDbAccess, pSnapshot));
+    return db_accesses.back().get();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CCacheDBManager
 
+// the dir name of the single db storing all of the state dbs
+static const string STATE_DB_NAME = "state";
+// the key of migrated flag in the single state db, it is not started with any of the db key prefixes
+static const string STATE_DB_MIGRATED_KEY = "#migrated";
+// max bytes of a batch for copying the items of old dbs to the single state db
+static const uint32_t STATE_DB_MIGRATE_BATCH_SIZE = 32 << 20; // 32MB
+
+namespace {
+    // collect the writes of the db accesses to one commit batch in scope
+    class CCommitBatchScope {
+    public:
+        CCommitBatchScope(const vector<CDBAccess*> &dbAccessListIn, CLevelDBBatch &commitBatch)
+            : dbAccessList(dbAccessListIn) {
+            for (auto pDbAccess : dbAccessList)
+                pDbAccess->SetCommitBatch(&commitBatch);
+        }
+        ~CCommitBatchScope() {
+            for (auto pDbAccess : dbAccessList)
+                pDbAccess->SetCommitBatch(nullptr);
+        }
+    private:
+        vector<CDBAccess*> dbAccessList;
+    };
+}
+
 CCacheDBManager::CCacheDBManager(bool isReindex, bool isMemory): is_reindex(isReindex), is_memory(isMemory) {
 
+    if (SysCfg().GetBoolArg("-singlestatedb", false)) {
+        OpenStateDb();
+    } else {
+        CheckStateDbUnused();
+    }
+
     pSysParamDb     = CreateDbAccess(DBNameType::SYSPARAM);
     pSysParamCache  = new CSysParamDBCache(pSysParamDb);
 
@@ -259,6 +391,42 @@ CCacheDBManager::~CCacheDBManager() {
 }
 
 bool CCacheDBManager::Flush() {
+    int64_t beginTime = GetTimeMicros();
+    if (p_state_db != nullptr) {
+        // commit the changes of all state dbs with only one sync write, they are kept consistent on crash
+        CLevelDBBatch commitBatch;
+        {
+            CCommitBatchScope scope(GetDbAccessList(), commitBatch);
+            FlushCaches();
+        }
+        p_state_db->WriteBatch(commitBatch, true);
+    } else {
+        FlushCaches();
+    }
+
+    int64_t elapsed = GetTimeMicros() - beginTime;
+    flush_count++;
+    flush_total_time += elapsed;
+    flush_max_time = std::max(flush_max_time, elapsed);
+    LogPrint(BCLog::BENCHMARK, "flush state dbs (%s) elapsed=%.2fms, avg=%.2fms, max=%.2fms, count=%llu\n",
+             IsSingleStateDb() ? "single" : "multiple", elapsed * 0.001,
+             flush_total_time * 0.001 / flush_count, flush_max_time * 0.001, flush_count);
+
+    if (LogAcceptCategory(BCLog::LDB)) {
+        for (auto pDbAccess : GetDbAccessList()) {
+            const auto &readCache = pDbAccess->GetReadCache();
+            LogPrint(BCLog::LDB, "%s db flush stats: written=%llu, clean skipped=%llu, read cache: hit=%llu, "
+                     "miss=%llu, evicted=%llu, count=%u, size=%u\n",
+                     ::GetDbName(pDbAccess->GetDbNameType()), pDbAccess->GetFlushWrittenCount(),
+                     pDbAccess->GetFlushCleanCount(), readCache.GetHitCount(), readCache.GetMissCount(),
+                     readCache.GetEvictedCount(), readCache.GetCount(), readCache.GetSize());
+        }
+    }
+
+    return true;
+}
+
+void CCacheDBManager::FlushCaches() {
     if (pSysParamCache) pSysParamCache->Flush();
 
     if (pAccountCache) pAccountCache->Flush();
@@ -296,16 +464,21 @@ bool CCacheDBManager::Flush() {
     //     pTxCache->Flush();
     // if (pPpCache)
     //     pPpCache->Flush();
-
-    return true;
 }
 
-CDBAccess* CCacheDBManager::CreateDbAccess(DBNameType dbNameTypeIn) {
+vector<CDBAccess*> CCacheDBManager::GetDbAccessList() const {
+    vector<CDBAccess*> ret;
+    for (auto pDbAccess : {pSysParamDb, pAccountDb, pAssetDb, pContractDb, pDelegateDb, pCdpDb, pClosedCdpDb,
+                           pDexDb, pBlockDb, pLogDb, pReceiptDb, pUtxoDb, pAxcDb, pSysGovernDb, pPriceFeedDb}) {
+        if (pDbAccess != nullptr)
+            ret.push_back(pDbAccess);
+    }
+    return ret;
+}
 
-    const boost::filesystem::path& path = GetDataDir() / "blocks" / ::GetDbName(dbNameTypeIn);
-    uint32_t defaultCacheSize = kDBCacheSizeMap.at(dbNameTypeIn);
-    // db cache config
-    string configName = "-cache_size_" + ::GetDbName(dbNameTypeIn);
+int64_t CCacheDBManager::GetDbCacheSize(DBNameType dbNameTypeIn, const string &configPrefix,
+                                        int64_t defaultCacheSize) {
+    string configName = configPrefix + ::GetDbName(dbNameTypeIn);
     int64_t cacheSize = SysCfg().GetArg(configName, defaultCacheSize);
     if (cacheSize < 0 || cacheSize > MAX_DB_CACHE_SIZE) {
         LogPrint(BCLog::ERROR, "%s=%u is out or range [0, %u], use default value=%u instead\n",
@@ -316,8 +489,107 @@ CDBAccess* CCacheDBManager::CreateDbAccess(DBNameType dbNameTypeIn) {
             configName, cacheSize);
 
     }
+    return cacheSize;
+}
+
+CDBAccess* CCacheDBManager::CreateDbAccess(DBNameType dbNameTypeIn) {
+
+    // db cache config
+    int64_t cacheSize = GetDbCacheSize(dbNameTypeIn, "-cache_size_", kDBCacheSizeMap.at(dbNameTypeIn));
+    // read cache of the deserialized db values, use the same size as db cache by default
+    int64_t readCacheSize = GetDbCacheSize(dbNameTypeIn, "-read_cache_size_", cacheSize);
 
-    return new CDBAccess(dbNameTypeIn, path, cacheSize, is_memory, is_reindex);
+    if (p_state_db != nullptr)
+        return new CDBAccess(dbNameTypeIn, p_state_db, readCacheSize);
+
+    const boost::filesystem::path& path = GetDataDir() / "blocks" / ::GetDbName(dbNameTypeIn);
+    return new CDBAccess(dbNameTypeIn, path, cacheSize, is_memory, is_reindex, readCacheSize);
+}
+
+void CCacheDBManager::OpenStateDb() {
+    // the single db shares the sum of cache sizes of all state dbs
+    int64_t cacheSize = 0;
+    for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++) {
+        DBNameType dbNameType = (DBNameType)i;
+        cacheSize += GetDbCacheSize(dbNameType, "-cache_size_", kDBCacheSizeMap.at(dbNameType));
+    }
+    cacheSize = std::min<int64_t>(cacheSize, MAX_DB_CACHE_SIZE);
+
+    const boost::filesystem::path& path = GetDataDir() / "blocks" / STATE_DB_NAME;
+    p_state_db = make_shared<CLevelDBWrapper>(path, cacheSize, is_memory, is_reindex);
+    LogPrint(BCLog::INFO, "use single state db %s, cache_size=%lld\n", path.string(), cacheSize);
+
+    if (!is_memory)
+        MigrateToStateDb();
+}
+
+/**
+ * Copy the items of the old separated state dbs to the single state db on the first startup with
+ * -singlestatedb, the old dbs are kept untouched and can be removed after the migration.
+ */
+void CCacheDBManager::MigrateToStateDb() {
+    int32_t migrated = 0;
+    if (p_state_db->Read(STATE_DB_MIGRATED_KEY, migrated) && migrated)
+        return;
+
+    int64_t beginTime = GetTimeMillis();
+    uint64_t totalCount = 0;
+    if (!is_reindex) {
+        for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++) {
+            const string &dbName = ::GetDbName((DBNameType)i);
+            const boost::filesystem::path& oldPath = GetDataDir() / "blocks" / dbName;
+            if (!boost::filesystem::exists(oldPath))
+                continue;
+
+            LogPrint(BCLog::INFO, "migrating %s db to single state db ...\n", dbName);
+            CLevelDBWrapper oldDb(oldPath, kDBCacheSizeMap.at((DBNameType)i), false, false);
+            std::shared_ptr<leveldb::Iterator> pCursor(oldDb.NewIterator());
+            CLevelDBBatch batch;
+            uint64_t batchSize = 0;
+            uint64_t count = 0;
+            for (pCursor->SeekToFirst(); pCursor->Valid(); pCursor->Next()) {
+                batch.WriteRaw(pCursor->key(), pCursor->value());
+                batchSize += pCursor->key().size() + pCursor->value().size();
+                count++;
+                if (batchSize >= STATE_DB_MIGRATE_BATCH_SIZE) {
+                    p_state_db->WriteBatch(batch, false);
+                    batch.Clear();
+                    batchSize = 0;
+                }
+            }
+            ThrowError(pCursor->status());
+            p_state_db->WriteBatch(batch, false);
+            totalCount += count;
+            LogPrint(BCLog::INFO, "migrated %s db to single state db, count=%llu\n", dbName, count);
+        }
+    }
+
+    // the migrated flag is written by the last sync batch, the migration will be redone if it is interrupted
+    p_state_db->Write(STATE_DB_MIGRATED_KEY, (int32_t)1, true);
+    LogPrint(BCLog::INFO, "migrated to single state db, count=%llu, elapsed=%lldms\n", totalCount,
+             GetTimeMillis() - beginTime);
+}
+
+/**
+ * The separated state dbs are stale once they have been migrated to the single state db, refuse to use
+ * them unless the chain is reindexed.
+ */
+void CCacheDBManager::CheckStateDbUnused() {
+    if (is_memory)
+        return;
+
+    const boost::filesystem::path& path = GetDataDir() / "blocks" / STATE_DB_NAME;
+    if (!boost::filesystem::exists(path))
+        return;
+
+    if (is_reindex) {
+        LogPrint(BCLog::INFO, "remove the single state db %s for reindexing with separated state dbs\n",
+                 path.string());
+        boost::filesystem::remove_all(path);
+        return;
+    }
+    throw runtime_error(strprintf("the state dbs have been migrated to %s, must use -singlestatedb=1 or -reindex",
+                                  path.string()));
 }
 
 const CRegID&  GetBlockBpRegid(const CBlock &block) {
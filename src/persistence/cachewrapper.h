@@ -64,10 +64,95 @@ public:
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap);
 
+    /**
+     * Savepoints for discarding the changes of a failed tx in place instead of executing it in a new
+     * wrapper. The changes are journaled by the db op logs, in the op log map set by the owner if any,
+     * otherwise in an internal journal. Savepoints can be nested, and each Savepoint() must be paired
+     * with one RollbackToSavepoint() or ReleaseSavepoint().
+     */
+    void Savepoint();
+    // undo the changes since the latest savepoint and release it
+    void RollbackToSavepoint();
+    // keep the changes since the latest savepoint and release it
+    void ReleaseSavepoint();
+
+    uint32_t GetSavepointCount() const { return savepoints.size(); }
+
+private:
+    struct SavepointMark {
+        map<string, size_t> op_log_sizes;  // db prefix -> size of op logs at the savepoint
+        size_t price_journal_size = 0;
+    };
+
+    void SetCachesDbOpLogMap(CDBOpLogMap *pDbOpLogMap);
+    CDBOpLogMap *GetActiveDbOpLogMap() { return p_db_op_log_map != nullptr ? p_db_op_log_map : &savepoint_logs; }
+
 private:
     CCacheWrapper(const CCacheWrapper&) = delete;
     CCacheWrapper& operator=(const CCacheWrapper&) = delete;
 
+    CDBOpLogMap *p_db_op_log_map = nullptr;  // op log map set by the owner
+    CDBOpLogMap savepoint_logs;              // journal of the savepoints if no op log map is set by the owner
+    vector<SavepointMark> savepoints;
+    UndoDataFuncMap undo_func_map;           // built on the first rollback
+};
+
+/**
+ * Savepoint of the cache wrapper in scope, the changes are rolled back on leaving the scope unless committed.
+ */
+class CCacheSavepoint {
+public:
+    explicit CCacheSavepoint(CCacheWrapper &cwIn) : cw(cwIn) { cw.Savepoint(); }
+    ~CCacheSavepoint() {
+        if (!is_released)
+            cw.RollbackToSavepoint();
+    }
+
+    void Commit() {
+        assert(!is_released);
+        cw.ReleaseSavepoint();
+        is_released = true;
+    }
+
+private:
+    CCacheSavepoint(const CCacheSavepoint&) = delete;
+    CCacheSavepoint& operator=(const CCacheSavepoint&) = delete;
+
+    CCacheWrapper &cw;
+    bool is_released = false;
+};
+
+/**
+ * Read only state of a block, the queries read it concurrently without cs_main while the next blocks are
+ * connected. It is made of the snapshots of the state dbs and the read only copies of the top level caches
+ * holding the changes not flushed yet, which are taken together under cs_main.
+ * The readers read it through their own cache wrapper based on it, e.g. CCacheWrapper cw(&view.GetCaches()).
+ * The memory only tx and price point caches are not copied, they are empty in the view.
+ */
+class CStateView {
+public:
+    // requires cs_main, the top level caches must be at the block
+    CStateView(CCacheDBManager *pCdMan, const uint256 &blockHashIn, int32_t heightIn);
+
+    const uint256& GetBlockHash() const { return block_hash; }
+    int32_t GetHeight() const { return height; }
+    int64_t GetCreateTime() const { return create_time; }
+
+    CCacheWrapper& GetCaches() { return caches; }
+
+private:
+    CDBAccess* NewSnapshotDbAccess(CDBAccess *pDbAccess);
+
+    CStateView(const CStateView&) = delete;
+    CStateView& operator=(const CStateView&) = delete;
+
+    uint256 block_hash;
+    int32_t height;
+    int64_t create_time;
+    // the state dbs may share one db, the snapshot is taken once for each db
+    map<CLevelDBWrapper*, std::shared_ptr<CLevelDBSnapshot>> snapshots;
+    vector<std::unique_ptr<CDBAccess>> db_accesses;
+    CCacheWrapper caches;
 };
 
 class CCacheDBManager {
@@ -128,11 +213,32 @@ public:
     ~CCacheDBManager();
 
     bool Flush();
+
+    // all of the db accesses managed by this, for stats
+    vector<CDBAccess*> GetDbAccessList() const;
+
+    // whether all of the state dbs are stored in one db and committed by one batch
+    bool IsSingleStateDb() const { return p_state_db != nullptr; }
+
+    uint64_t GetFlushCount() const { return flush_count; }
+    int64_t GetFlushTotalTime() const { return flush_total_time; }
+    int64_t GetFlushMaxTime() const { return flush_max_time; }
 private:
     CDBAccess* CreateDbAccess(DBNameType dbNameTypeIn);
+    int64_t GetDbCacheSize(DBNameType dbNameTypeIn, const string &configPrefix, int64_t defaultCacheSize);
+
+    void OpenStateDb();
+    void MigrateToStateDb();
+    void CheckStateDbUnused();
+    void FlushCaches();
 private:
     bool is_reindex = false;
     bool is_memory = false;
+    std::shared_ptr<CLevelDBWrapper> p_state_db = nullptr;  // the single db of all state dbs if enabled
+
+    uint64_t flush_count      = 0;
+    int64_t flush_total_time  = 0;  // in microseconds
+    int64_t flush_max_time    = 0;  // in microseconds
 };  // CCacheDBManager
 
 const CRegID& GetBlockBpRegid(const CBlock &block);
@@ -22,6 +22,14 @@ CCdpDBCache::CCdpDBCache(CCdpDBCache *pBaseIn)
       cdp_ratio_index_cache(pBaseIn->cdp_ratio_index_cache),
       cdp_height_index_cache(pBaseIn->cdp_height_index_cache) {}
 
+CCdpDBCache::CCdpDBCache(const CCdpDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+    : cdp_global_data_cache(topCache.cdp_global_data_cache, pSnapshotDbAccess),
+      cdp_cache(topCache.cdp_cache, pSnapshotDbAccess),
+      cdp_bcoin_cache(topCache.cdp_bcoin_cache, pSnapshotDbAccess),
+      user_cdp_cache(topCache.user_cdp_cache, pSnapshotDbAccess),
+      cdp_ratio_index_cache(topCache.cdp_ratio_index_cache, pSnapshotDbAccess),
+      cdp_height_index_cache(topCache.cdp_height_index_cache, pSnapshotDbAccess) {}
+
 bool CCdpDBCache::NewCDP(const int32_t blockHeight, CUserCDP &cdp) {
     return cdp_cache.SetData(cdp.cdpid, cdp) &&
         user_cdp_cache.SetData(make_pair(CRegIDKey(cdp.owner_regid), cdp.GetCoinPair()), cdp.cdpid) &&
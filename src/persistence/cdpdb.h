@@ -46,6 +46,7 @@ public:
     CCdpDBCache() {}
     CCdpDBCache(CDBAccess *pDbAccess);
     CCdpDBCache(CCdpDBCache *pBaseIn);
+    CCdpDBCache(const CCdpDBCache &topCache, CDBAccess *pSnapshotDbAccess);
 
     bool NewCDP(const int32_t blockHeight, CUserCDP &cdp);
     bool EraseCDP(const CUserCDP &oldCDP, const CUserCDP &cdp);
@@ -127,6 +128,10 @@ public:
     CClosedCdpDBCache(CClosedCdpDBCache *pBaseIn)
         : closedCdpTxCache(&pBaseIn->closedCdpTxCache), closedTxCdpCache(&pBaseIn->closedTxCdpCache) {}
 
+    CClosedCdpDBCache(const CClosedCdpDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : closedCdpTxCache(topCache.closedCdpTxCache, pSnapshotDbAccess),
+          closedTxCdpCache(topCache.closedTxCdpCache, pSnapshotDbAccess) {}
+
 public:
     bool AddClosedCdpIndex(const uint256& closedCdpId, const uint256& closedCdpTxId, CDPCloseType closeType) {
         return closedCdpTxCache.SetData(closedCdpId, {closedCdpTxId, (uint8_t)closeType});
@@ -77,6 +77,12 @@ public:
         contractAccountCache(pBaseIn->contractAccountCache),
         contractTracesCache(pBaseIn->contractTracesCache) {};
 
+    CContractDBCache(const CContractDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : contractCache(topCache.contractCache, pSnapshotDbAccess),
+          contractDataCache(topCache.contractDataCache, pSnapshotDbAccess),
+          contractAccountCache(topCache.contractAccountCache, pSnapshotDbAccess),
+          contractTracesCache(topCache.contractTracesCache, pSnapshotDbAccess) {}
+
     bool GetContractAccount(const CRegID &contractRegId, const string &accountKey, CAppUserAccount &appAccOut);
     bool SetContractAccount(const CRegID &contractRegId, const CAppUserAccount &appAccIn);
 
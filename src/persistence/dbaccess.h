@@ -6,12 +6,17 @@
 #ifndef PERSIST_DB_ACCESS_H
 #define PERSIST_DB_ACCESS_H
 
+#include "commons/lrucache.hpp"
 #include "commons/uint256.h"
 #include "dbconf.h"
 #include "leveldbwrapper.h"
 
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <tuple>
+#include <typeindex>
 #include <vector>
 #include <optional>
 
@@ -278,35 +283,142 @@ namespace db_util {
 typedef void(UndoDataFunc)(const CDbOpLogs &pDbOpLogs);
 typedef std::map<dbk::PrefixType, std::function<UndoDataFunc>> UndoDataFuncMap;
 
+/**
+ * Read cache of the clean values stored in db, it keeps the deserialized objects of the recently used keys
+ * across the flushes of the top level caches.
+ */
+class CDBReadCache {
+public:
+    struct Item {
+        std::shared_ptr<void> value;
+        std::type_index type;
+        uint32_t size;
+    };
+    typedef CLruCache<string, Item> Cache;
+
+public:
+    CDBReadCache(uint32_t maxSize) : cache(maxSize, &CDBReadCache::CalcItemSize) {}
+
+    template<typename ValueType>
+    bool Get(const string &key, ValueType &value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto pItem = cache.Get(key);
+        if (pItem == nullptr || pItem->type != std::type_index(typeid(ValueType))) {
+            miss_count++;
+            return false;
+        }
+        value = *std::static_pointer_cast<ValueType>(pItem->value);
+        hit_count++;
+        return true;
+    }
+
+    template<typename ValueType>
+    void Put(const string &key, const ValueType &value) {
+        if (cache.GetMaxSize() == 0) return;
+
+        uint32_t sz = ::GetSerializeSize(value, SER_DISK, CLIENT_VERSION);
+        Item item = {std::make_shared<ValueType>(value), std::type_index(typeid(ValueType)), sz};
+        std::lock_guard<std::mutex> lock(mtx);
+        cache.Insert(key, item);
+    }
+
+    void Erase(const string &key) {
+        std::lock_guard<std::mutex> lock(mtx);
+        cache.Remove(key);
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mtx);
+        cache.Clear();
+    }
+
+    bool Exists(const string &key) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return cache.Exists(key);
+    }
+
+    uint32_t GetMaxSize() const { return cache.GetMaxSize(); }
+    uint32_t GetSize() const { std::lock_guard<std::mutex> lock(mtx); return cache.GetSize(); }
+    uint32_t GetCount() const { std::lock_guard<std::mutex> lock(mtx); return cache.GetCount(); }
+    uint64_t GetEvictedCount() const { std::lock_guard<std::mutex> lock(mtx); return cache.GetEvictedCount(); }
+    uint64_t GetHitCount() const { std::lock_guard<std::mutex> lock(mtx); return hit_count; }
+    uint64_t GetMissCount() const { std::lock_guard<std::mutex> lock(mtx); return miss_count; }
+
+private:
+    static uint32_t CalcItemSize(const Cache::Item &item) {
+        // rough memory usage: serialized value + key + item overhead
+        return item.second.size + item.first.size() + sizeof(Cache::Item) + sizeof(Item);
+    }
+
+private:
+    mutable std::mutex mtx;
+    Cache cache;
+    uint64_t hit_count  = 0;
+    uint64_t miss_count = 0;
+};
+
 class CDBAccess {
 public:
     CDBAccess(DBNameType dbNameTypeIn, const boost::filesystem::path &path, size_t cacheSize,
-              bool memory, bool wipe)
-        : dbNameType(dbNameTypeIn), db(path, cacheSize, memory, wipe) {}
+              bool memory, bool wipe, uint32_t readCacheSize = 0)
+        : dbNameType(dbNameTypeIn), p_db(make_shared<CLevelDBWrapper>(path, cacheSize, memory, wipe)),
+          read_cache(readCacheSize) {}
 
-    int64_t GetDbCount() const { return db.GetDbCount(); }
+    /**
+     * Access the items of dbNameTypeIn in a shared db, the prefixes of all db names are unique, so the
+     * items of different db names can be stored in one db.
+     */
+    CDBAccess(DBNameType dbNameTypeIn, std::shared_ptr<CLevelDBWrapper> pDbIn, uint32_t readCacheSize = 0)
+        : dbNameType(dbNameTypeIn), p_db(pDbIn), read_cache(readCacheSize) {
+        assert(p_db != nullptr);
+    }
+
+    /**
+     * Read only access of the db at the snapshot, the read cache is not used as it may hold the values
+     * written after the snapshot.
+     */
+    CDBAccess(const CDBAccess &other, std::shared_ptr<CLevelDBSnapshot> pSnapshotIn)
+        : dbNameType(other.dbNameType), p_db(other.p_db), read_cache(0), p_snapshot(pSnapshotIn) {
+        assert(p_snapshot != nullptr);
+    }
+
+    int64_t GetDbCount() const { return p_db->GetDbCount(); }
     template<typename KeyType, typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, const KeyType &key, ValueType &value) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Read(keyStr, value);
+        return ReadData(keyStr, value);
     }
 
     template<typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, ValueType &value) const {
         const string prefix = dbk::GetKeyPrefix(prefixType);
-        return db.Read(prefix, value);
+        return ReadData(prefix, value);
     }
 
     template<typename KeyType, typename ValueType>
     bool HasData(const dbk::PrefixType prefixType, const KeyType &key) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Exists(keyStr);
+        if (p_snapshot != nullptr)
+            return p_db->Exists(keyStr, p_snapshot->Get());
+
+        return read_cache.Exists(keyStr) || p_db->Exists(keyStr);
     }
 
+    /**
+     * Write the raw batch to db, the caller must keep the read cache coherent with
+     * UpdateReadCache()/EraseReadCache() for the keys in batch.
+     * When a commit batch is set, the batch is appended to it and written by the owner of commit batch.
+     */
     inline void WriteBatch(CLevelDBBatch &batch) {
-        db.WriteBatch(batch, true);
+        assert(p_snapshot == nullptr && "can not write the db at snapshot");
+        if (p_commit_batch != nullptr)
+            p_commit_batch->Append(batch);
+        else
+            p_db->WriteBatch(batch, true);
     }
 
+    void SetCommitBatch(CLevelDBBatch *pCommitBatchIn) { p_commit_batch = pCommitBatchIn; }
+
     template<typename ValueType>
     void WriteBatch(const dbk::PrefixType prefixType, ValueType &value) {
         CLevelDBBatch batch;
@@ -317,17 +429,68 @@ public:
         } else {
             batch.Write(prefix, value);
         }
-        db.WriteBatch(batch, true);
+        WriteBatch(batch);
+
+        if (db_util::IsEmpty(value)) {
+            EraseReadCache(prefix);
+        } else {
+            UpdateReadCache(prefix, value);
+        }
+    }
+
+    template<typename ValueType>
+    void UpdateReadCache(const string &dbKey, const ValueType &value) {
+        read_cache.Put(dbKey, value);
     }
 
+    void EraseReadCache(const string &dbKey) { read_cache.Erase(dbKey); }
+
+    const CDBReadCache& GetReadCache() const { return read_cache; }
+
     DBNameType GetDbNameType() const { return dbNameType; }
 
+    std::shared_ptr<CLevelDBWrapper> GetDb() const { return p_db; }
+
+    bool IsReadOnly() const { return p_snapshot != nullptr; }
+
     std::shared_ptr<leveldb::Iterator> NewIterator() {
-        return std::shared_ptr<leveldb::Iterator>(db.NewIterator());
+        return std::shared_ptr<leveldb::Iterator>(
+            p_db->NewIterator(p_snapshot != nullptr ? p_snapshot->Get() : nullptr));
+    }
+
+    // flush stats of the top level caches: modified entries written to db vs. read-only entries skipped
+    void AddFlushStats(uint64_t writtenCount, uint64_t cleanCount) {
+        flush_written_count += writtenCount;
+        flush_clean_count += cleanCount;
+    }
+    uint64_t GetFlushWrittenCount() const { return flush_written_count; }
+    uint64_t GetFlushCleanCount() const { return flush_clean_count; }
+private:
+    template<typename ValueType>
+    bool ReadData(const string &dbKey, ValueType &value) const {
+        if (p_snapshot != nullptr)
+            return p_db->Read(dbKey, value, p_snapshot->Get());
+
+        if (read_cache.GetMaxSize() == 0)
+            return p_db->Read(dbKey, value);
+
+        if (read_cache.Get(dbKey, value))
+            return true;
+
+        if (!p_db->Read(dbKey, value))
+            return false;
+
+        read_cache.Put(dbKey, value);
+        return true;
     }
 private:
     DBNameType dbNameType;
-    mutable CLevelDBWrapper db; // // TODO: remove the mutable declare
+    std::shared_ptr<CLevelDBWrapper> p_db;
+    mutable CDBReadCache read_cache;
+    std::shared_ptr<CLevelDBSnapshot> p_snapshot = nullptr;  // read only at the snapshot if set
+    CLevelDBBatch *p_commit_batch = nullptr;
+    uint64_t flush_written_count = 0;
+    uint64_t flush_clean_count   = 0;
 };
 
 template<int32_t PREFIX_TYPE_VALUE, typename __KeyType, typename __ValueType>
@@ -358,6 +521,22 @@ public:
         assert(pDbAccess->GetDbNameType() == GetDbNameEnumByPrefix(PREFIX_TYPE));
     };
 
+    /**
+     * Read only copy of the top level cache, only the modified entries not flushed yet are copied, the others
+     * are read from the db at snapshot. It is never changed, so it can be read by many threads through the
+     * caches based on it.
+     */
+    CCompositeKVCache(const CCompositeKVCache &topCache, CDBAccess *pSnapshotDbAccess): pBase(nullptr),
+        pDbAccess(pSnapshotDbAccess), is_read_only(true) {
+        assert(topCache.pDbAccess != nullptr);
+        assert(pSnapshotDbAccess != nullptr && pSnapshotDbAccess->IsReadOnly());
+        for (const auto &key : topCache.dirty_keys) {
+            auto it = topCache.mapData.find(key);
+            assert(it != topCache.mapData.end());
+            mapData.emplace(key, make_shared<ValueType>(*it->second));
+        }
+    }
+
     CCompositeKVCache(const CCompositeKVCache &other) {
         operator=(other);
     }
@@ -370,8 +549,10 @@ public:
         for (auto otherItem : other.mapData) {
             mapData[otherItem.first] = make_shared<ValueType>(*otherItem.second);
         }
+        dirty_keys = other.dirty_keys;
         pDbOpLogMap = other.pDbOpLogMap;
         is_calc_size = other.is_calc_size;
+        is_read_only = other.is_read_only;
         size = other.size;
 
         return *this;
@@ -419,6 +600,7 @@ public:
             UpdateDataSize(*it->second, value);
             *it->second = value;
         }
+        dirty_keys.insert(key);
         return true;
     }
 
@@ -440,39 +622,64 @@ public:
             AddOpLog(key, *it->second, nullptr);
             db_util::SetEmpty(*it->second);
             IncDataSize(*it->second);
+            dirty_keys.insert(key);
         }
         return true;
     }
 
     void Clear() {
         mapData.clear();
+        dirty_keys.clear();
         size = 0;
     }
 
+    /**
+     * Write the modified entries to base cache or db, the entries only read from base/db are skipped.
+     */
     void Flush() {
         assert(pBase != nullptr || pDbAccess != nullptr);
         if (pBase != nullptr) {
             assert(pDbAccess == nullptr);
-            for (auto item : mapData) {
-                pBase->SetDataToSelf(item.first, *item.second);
+            for (const auto &key : dirty_keys) {
+                auto it = mapData.find(key);
+                assert(it != mapData.end());
+                pBase->SetDataToSelf(it->first, *it->second);
             }
         } else if (pDbAccess != nullptr) {
             assert(pBase == nullptr);
-            CLevelDBBatch batch;
-            for (auto item : mapData) {
-                string key = dbk::GenDbKey(PREFIX_TYPE, item.first);
-                if (db_util::IsEmpty(*item.second)) {
-                    batch.Erase(key);
-                } else {
-                    batch.Write(key, *item.second);
+            if (!dirty_keys.empty()) {
+                CLevelDBBatch batch;
+                vector<pair<string, ValueSPtr>> dbItems;
+                dbItems.reserve(dirty_keys.size());
+                for (const auto &key : dirty_keys) {
+                    auto it = mapData.find(key);
+                    assert(it != mapData.end());
+                    string dbKey = dbk::GenDbKey(PREFIX_TYPE, it->first);
+                    if (db_util::IsEmpty(*it->second)) {
+                        batch.Erase(dbKey);
+                    } else {
+                        batch.Write(dbKey, *it->second);
+                    }
+                    dbItems.emplace_back(std::move(dbKey), it->second);
+                }
+                pDbAccess->WriteBatch(batch);
+                // write through to the read cache of db, keep the flushed values warm
+                for (const auto &item : dbItems) {
+                    if (db_util::IsEmpty(*item.second)) {
+                        pDbAccess->EraseReadCache(item.first);
+                    } else {
+                        pDbAccess->UpdateReadCache(item.first, *item.second);
+                    }
                 }
             }
-            pDbAccess->WriteBatch(batch);
+            pDbAccess->AddFlushStats(dirty_keys.size(), mapData.size() - dirty_keys.size());
         }
 
         Clear();
     }
 
+    uint32_t GetDirtyCount() const { return dirty_keys.size(); }
+
     void UndoData(const CDbOpLog &dbOpLog) {
         KeyType key;
         ValueType value;
@@ -505,9 +712,16 @@ public:
     map<KeyType, ValueSPtr>& GetMapData() { return mapData; };
 private:
     Iterator GetDataIt(const KeyType &key) const {
+        assert(!is_read_only && "must read the read only cache through a cache based on it");
         Iterator it = mapData.find(key);
         if (it != mapData.end()) {
             return it;
+        } else if (pBase != nullptr && pBase->is_read_only) {
+            // the read only base is shared by threads, only the current mapData is changed
+            auto pBaseValue = db_util::MakeEmptyValue<ValueType>();
+            if (pBase->GetReadOnlyData(key, *pBaseValue)) {
+                return AddDataToMap(key, pBaseValue);
+            }
         } else if (pBase != nullptr) {
             // find key-value at base cache
             auto baseIt = pBase->GetDataIt(key);
@@ -526,8 +740,19 @@ private:
         return mapData.end();
     }
 
+    // read the value of the read only cache without adding it to mapData
+    bool GetReadOnlyData(const KeyType &key, ValueType &value) const {
+        auto it = mapData.find(key);
+        if (it != mapData.end()) {
+            value = *it->second;
+            return true;
+        }
+        return pDbAccess->GetData(PREFIX_TYPE, key, value);
+    }
+
     // set data to self only
     void SetDataToSelf(const KeyType &key, const ValueType &value) {
+        assert(!is_read_only);
         auto it = mapData.find(key);
         if (it != mapData.end()) {
             UpdateDataSize(*it->second, value);
@@ -535,6 +760,7 @@ private:
         } else {
             AddDataToMap(key, value);
         }
+        dirty_keys.insert(key);
     }
 
     inline Iterator AddDataToMap(const KeyType &keyIn, const ValueType &valueIn) const {
@@ -601,8 +827,10 @@ private:
     mutable CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> *pBase = nullptr;
     CDBAccess *pDbAccess = nullptr;
     mutable map<KeyType, ValueSPtr> mapData;
+    set<KeyType> dirty_keys;  // keys of the modified entries in mapData, the others are read from base/db only
     CDBOpLogMap *pDbOpLogMap = nullptr;
     bool is_calc_size = false;
+    bool is_read_only = false;  // read only copy of the top level cache, see CStateView
     mutable uint32_t size = 0;
 };
 
@@ -628,6 +856,18 @@ public:
         assert(pDbAccessIn != nullptr);
     }
 
+    /**
+     * Read only copy of the top level cache, the data is copied only if it has been modified and not flushed
+     * yet, otherwise it is read from the db at snapshot.
+     */
+    CSimpleKVCache(const CSimpleKVCache &topCache, CDBAccess *pSnapshotDbAccess): pBase(nullptr),
+        pDbAccess(pSnapshotDbAccess), is_read_only(true) {
+        assert(topCache.pDbAccess != nullptr);
+        assert(pSnapshotDbAccess != nullptr && pSnapshotDbAccess->IsReadOnly());
+        if (topCache.is_dirty && topCache.ptrData)
+            ptrData = make_shared<ValueType>(*topCache.ptrData);
+    }
+
     CSimpleKVCache(const CSimpleKVCache &other) {
         operator=(other);
     }
@@ -641,7 +881,9 @@ public:
         } else {
             ptrData = make_shared<ValueType>(*other.ptrData);
         }
+        is_dirty = other.is_dirty;
         pDbOpLogMap = other.pDbOpLogMap;
+        is_read_only = other.is_read_only;
         return *this;
     }
 
@@ -679,6 +921,7 @@ public:
         }
         AddOpLog(*ptrData, &value);
         *ptrData = value;
+        is_dirty = true;
         return true;
     }
 
@@ -692,33 +935,47 @@ public:
         if (ptr && !db_util::IsEmpty(*ptr)) {
             AddOpLog(*ptr, nullptr);
             db_util::SetEmpty(*ptr);
+            is_dirty = true;
         }
         return true;
     }
 
     void Clear() {
         ptrData = nullptr;
+        is_dirty = false;
     }
 
+    /**
+     * Write the data to base cache or db only if it has been modified.
+     */
     void Flush() {
         assert(pBase != nullptr || pDbAccess != nullptr);
         if (ptrData) {
             if (pBase != nullptr) {
                 assert(pDbAccess == nullptr);
-                pBase->ptrData = ptrData;
+                if (is_dirty) {
+                    assert(!pBase->is_read_only);
+                    pBase->ptrData  = ptrData;
+                    pBase->is_dirty = true;
+                }
             } else if (pDbAccess != nullptr) {
                 assert(pBase == nullptr);
-                pDbAccess->WriteBatch(PREFIX_TYPE, *ptrData);
+                if (is_dirty)
+                    pDbAccess->WriteBatch(PREFIX_TYPE, *ptrData);
+                pDbAccess->AddFlushStats(is_dirty ? 1 : 0, is_dirty ? 0 : 1);
             }
-            ptrData = nullptr;
         }
+        Clear();
     }
 
+    bool IsDirty() const { return is_dirty; }
+
     void UndoData(const CDbOpLog &dbOpLog) {
         if (!ptrData) {
             ptrData = db_util::MakeEmptyValue<ValueType>();
         }
         dbOpLog.Get(*ptrData);
+        is_dirty = true;
     }
 
     void UndoDataList(const CDbOpLogs &dbOpLogs) {
@@ -734,9 +991,17 @@ public:
     dbk::PrefixType GetPrefixType() const { return PREFIX_TYPE; }
 
     std::shared_ptr<ValueType> GetDataPtr() const {
+        assert(!is_read_only && "must read the read only cache through a cache based on it");
 
         if (ptrData) {
             return ptrData;
+        } else if (pBase != nullptr && pBase->is_read_only) {
+            // the read only base is shared by threads, only the current ptrData is changed
+            auto ptr = db_util::MakeEmptyValue<ValueType>();
+            if (pBase->GetReadOnlyData(*ptr)) {
+                ptrData = ptr;
+                return ptrData;
+            }
         } else if (pBase != nullptr){
             auto ptr = pBase->GetDataPtr();
             if (ptr) {
@@ -756,6 +1021,15 @@ public:
     }
 
 private:
+    // read the data of the read only cache without keeping it in ptrData
+    bool GetReadOnlyData(ValueType &value) const {
+        if (ptrData) {
+            value = *ptrData;
+            return true;
+        }
+        return pDbAccess->GetData(PREFIX_TYPE, value);
+    }
+
     inline void AddOpLog(const ValueType &oldValue, const ValueType *pNewValue) {
         if (pDbOpLogMap != nullptr) {
             CDbOpLog dbOpLog;
@@ -775,7 +1049,9 @@ private:
     mutable CSimpleKVCache<PREFIX_TYPE, ValueType> *pBase;
     CDBAccess *pDbAccess;
     mutable std::shared_ptr<ValueType> ptrData = nullptr;
+    bool is_dirty                              = false;  // ptrData has been modified, not only read from base/db
     CDBOpLogMap *pDbOpLogMap                   = nullptr;
+    bool is_read_only                          = false;  // read only copy of the top level cache, see CStateView
 };
 
 #endif  // PERSIST_DB_ACCESS_H
@@ -54,6 +54,13 @@ public:
         pending_delegates_cache(pBaseIn->pending_delegates_cache),
         active_delegates_cache(pBaseIn->active_delegates_cache) {}
 
+    CDelegateDBCache(const CDelegateDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : voteRegIdCache(topCache.voteRegIdCache, pSnapshotDbAccess),
+          regId2VoteCache(topCache.regId2VoteCache, pSnapshotDbAccess),
+          last_vote_height_cache(topCache.last_vote_height_cache, pSnapshotDbAccess),
+          pending_delegates_cache(topCache.pending_delegates_cache, pSnapshotDbAccess),
+          active_delegates_cache(topCache.active_delegates_cache, pSnapshotDbAccess) {}
+
     bool GetTopVoteDelegates(uint32_t delegateNum, uint64_t delegateVoteMin,
                              VoteDelegateVector &topVoteDelegates, bool isR3Fork);
 
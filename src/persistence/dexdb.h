@@ -63,6 +63,13 @@ public:
           operator_owner_map_cache(pDbAccess),
           operator_last_id_cache(pDbAccess) {};
 
+    CDexDBCache(const CDexDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : activeOrderCache(topCache.activeOrderCache, pSnapshotDbAccess),
+          blockOrdersCache(topCache.blockOrdersCache, pSnapshotDbAccess),
+          operator_detail_cache(topCache.operator_detail_cache, pSnapshotDbAccess),
+          operator_owner_map_cache(topCache.operator_owner_map_cache, pSnapshotDbAccess),
+          operator_last_id_cache(topCache.operator_last_id_cache, pSnapshotDbAccess) {}
+
 
 public:
     bool GetActiveOrder(const uint256 &orderTxId, dex::CDEXOrderDetail& activeOrder);
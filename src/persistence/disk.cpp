@@ -5,8 +5,12 @@
 
 #include "disk.h"
 #include "logging.h"
+#include "sync.h"
+#include "commons/lrucache.hpp"
 #include "boost/filesystem.hpp"
 
+#include <memory>
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CBlockFileInfo
 
@@ -62,3 +66,59 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly) {
     return OpenDiskFile(pos, "blk", fReadOnly);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// cached block file handles
+
+namespace {
+
+struct CBlockFileHandle {
+    CCriticalSection cs_file;  // the reads seek the shared file position
+    FILE *file = nullptr;
+
+    ~CBlockFileHandle() {
+        if (file)
+            fclose(file);
+    }
+};
+
+CCriticalSection cs_blockFileHandles;
+CLruCache<int32_t, std::shared_ptr<CBlockFileHandle>> blockFileHandles(MAX_OPEN_BLOCK_FILES);
+
+std::shared_ptr<CBlockFileHandle> GetBlockFileHandle(int32_t nFile) {
+    LOCK(cs_blockFileHandles);
+    auto ppHandle = blockFileHandles.Get(nFile);
+    if (ppHandle)
+        return *ppHandle;
+
+    // the evicted handle is closed after its last read
+    auto pHandle  = std::make_shared<CBlockFileHandle>();
+    pHandle->file = OpenBlockFile(CDiskBlockPos(nFile, 0), true);
+    if (!pHandle->file)
+        return nullptr;
+
+    blockFileHandles.Insert(nFile, pHandle);
+    return pHandle;
+}
+
+}  // namespace
+
+bool ReadBlockFileData(const CDiskBlockPos &pos, char *pData, uint32_t size) {
+    if (pos.IsNull())
+        return false;
+
+    auto pHandle = GetBlockFileHandle(pos.nFile);
+    if (!pHandle)
+        return false;
+
+    LOCK(pHandle->cs_file);
+    if (fseek(pHandle->file, pos.nPos, SEEK_SET)) {
+        LogPrint(BCLog::ERROR, "Unable to seek to position %u of block file %d\n", pos.nPos, pos.nFile);
+        return false;
+    }
+    if (fread(pData, 1, size, pHandle->file) != size) {
+        LogPrint(BCLog::ERROR, "Unable to read %u bytes at position %u of block file %d\n", size, pos.nPos, pos.nFile);
+        return false;
+    }
+    return true;
+}
@@ -127,4 +127,13 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 /** Open a block file (blk?????.dat) */
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
+/** Maximum number of the read-only block file handles kept open to serve the blocks to the peers */
+static const uint32_t MAX_OPEN_BLOCK_FILES = 8;
+
+/**
+ * Read the bytes at the position of a block file (blk?????.dat) by a cached read-only handle. The block files are
+ * only appended, so the handles keep valid and the reads need no cs_main.
+ */
+bool ReadBlockFileData(const CDiskBlockPos &pos, char *pData, uint32_t size);
+
 #endif //PERSIST_DISK_H
\ No newline at end of file
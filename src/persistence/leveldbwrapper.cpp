@@ -86,6 +86,24 @@ CLevelDBWrapper::~CLevelDBWrapper() {
     options.env = nullptr;
 }
 
+namespace {
+    class CBatchAppender : public leveldb::WriteBatch::Handler {
+    public:
+        CBatchAppender(leveldb::WriteBatch &batchIn) : batch(batchIn) {}
+
+        void Put(const leveldb::Slice &key, const leveldb::Slice &value) override { batch.Put(key, value); }
+        void Delete(const leveldb::Slice &key) override { batch.Delete(key); }
+
+    private:
+        leveldb::WriteBatch &batch;
+    };
+}
+
+void CLevelDBBatch::Append(const CLevelDBBatch &other) {
+    CBatchAppender appender(batch);
+    ThrowError(other.batch.Iterate(&appender));
+}
+
 bool CLevelDBWrapper::WriteBatch(CLevelDBBatch &batch, bool fSync) {
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     ThrowError(status);
@@ -16,6 +16,8 @@
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
+#include <memory>
+
 using namespace json_spirit;
 
 class CDbOpLog {
@@ -87,6 +89,7 @@ typedef vector<CDbOpLog> CDbOpLogs;
 class CDBOpLogMap {
 public:
     map<string, CDbOpLogs>& GetMap() { return mapDbOpLogs; }
+    const map<string, CDbOpLogs>& GetMap() const { return mapDbOpLogs; }
 
     const CDbOpLogs* GetDbOpLogsPtr(dbk::PrefixType prefixType) const {
         assert(prefixType != dbk::EMPTY);
@@ -145,6 +148,17 @@ public:
         batch.Delete(key);
     }
 
+    // put the raw serialized value, e.g. copy the items from another db
+    void WriteRaw(const leveldb::Slice &key, const leveldb::Slice &value) {
+        batch.Put(key, value);
+    }
+
+    void Clear() {
+        batch.Clear();
+    }
+
+    // append all of the changes queued in other batch to this batch
+    void Append(const CLevelDBBatch &other);
  };
 
 class CLevelDBWrapper {
@@ -174,12 +188,13 @@ public:
     CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
     ~CLevelDBWrapper();
 
+    // read the value as it was when the snapshot was taken if pSnapshot is not null
     template<typename V>
-    bool Read(std::string key, V &value) {
+    bool Read(std::string key, V &value, const leveldb::Snapshot *pSnapshot = nullptr) {
     	leveldb::Slice slKey(key);
 
         string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(GetReadOptions(readoptions, pSnapshot), slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -202,10 +217,10 @@ public:
         return WriteBatch(batch, fSync);
     }
 
-    bool Exists(const std::string &key) {
+    bool Exists(const std::string &key, const leveldb::Snapshot *pSnapshot = nullptr) {
     	leveldb::Slice slKey(key);
         string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(GetReadOptions(readoptions, pSnapshot), slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -234,11 +249,42 @@ public:
     }
 
     // not exactly clean encapsulation, but it's easiest for now
-    leveldb::Iterator *NewIterator() {
-        return pdb->NewIterator(iteroptions);
+    leveldb::Iterator *NewIterator(const leveldb::Snapshot *pSnapshot = nullptr) {
+        return pdb->NewIterator(GetReadOptions(iteroptions, pSnapshot));
     }
+
+    // the consistent read point of the db, must be released by ReleaseSnapshot()
+    const leveldb::Snapshot *GetSnapshot() { return pdb->GetSnapshot(); }
+    void ReleaseSnapshot(const leveldb::Snapshot *pSnapshot) { pdb->ReleaseSnapshot(pSnapshot); }
+
     int64_t GetDbCount();
    // Object ToJsonObj();
+private:
+    static leveldb::ReadOptions GetReadOptions(const leveldb::ReadOptions &options,
+                                               const leveldb::Snapshot *pSnapshot) {
+        leveldb::ReadOptions ret = options;
+        ret.snapshot = pSnapshot;
+        return ret;
+    }
+};
+
+/**
+ * Snapshot of the db, the reads at it do not see the later writes. It is released with the last reader.
+ */
+class CLevelDBSnapshot {
+public:
+    explicit CLevelDBSnapshot(std::shared_ptr<CLevelDBWrapper> pDbIn)
+        : p_db(pDbIn), p_snapshot(pDbIn->GetSnapshot()) {}
+    ~CLevelDBSnapshot() { p_db->ReleaseSnapshot(p_snapshot); }
+
+    const leveldb::Snapshot *Get() const { return p_snapshot; }
+
+private:
+    CLevelDBSnapshot(const CLevelDBSnapshot&) = delete;
+    CLevelDBSnapshot& operator=(const CLevelDBSnapshot&) = delete;
+
+    std::shared_ptr<CLevelDBWrapper> p_db;
+    const leveldb::Snapshot *p_snapshot;
 };
 
 #endif // PERSIST_LEVELDBWRAPPER_H
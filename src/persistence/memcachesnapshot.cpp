@@ -0,0 +1,128 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "memcachesnapshot.h"
+
+#include "cachewrapper.h"
+#include "commons/util/util.h"
+#include "config/configuration.h"
+#include "main.h"
+
+#include <openssl/rand.h>
+
+#include <boost/filesystem.hpp>
+
+bool CMemCacheSnapshot::Write(const CBlockIndex *pTip, CCacheDBManager &cdMan) {
+    int64_t start = GetTimeMillis();
+    if (pTip == nullptr)
+        return ERRORMSG("no tip block to take the memory cache snapshot");
+
+    version            = CURRENT_VERSION;
+    tip_block_hash     = pTip->GetBlockHash();
+    tx_cache_height    = SysCfg().GetTxCacheHeight();
+    price_slide_window = 0;
+    if (!cdMan.pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, price_slide_window))
+        return ERRORMSG("read sys param MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT error");
+
+    cdMan.pTxCache->GetTxids(txids);
+    coin_price_points = cdMan.pPpCache->GetCoinPricePointMap();
+
+    // serialize snapshot, checksum data up to that point, then append csum
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    ssSnapshot << FLATDATA(SysCfg().MessageStart());
+    ssSnapshot << *this;
+    uint256 hash = Hash(ssSnapshot.begin(), ssSnapshot.end());
+    ssSnapshot << hash;
+
+    uint16_t randv = 0;
+    RAND_bytes((uint8_t*)&randv, sizeof(randv));
+    boost::filesystem::path pathTmp = path.string() + strprintf(".%04x", randv);
+    FILE* file                      = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout               = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!fileout)
+        return ERRORMSG("Failed to open file %s", pathTmp.string());
+
+    try {
+        fileout << ssSnapshot;
+    } catch (std::exception& e) {
+        return ERRORMSG("Serialize or I/O error - %s", e.what());
+    }
+    FileCommit(fileout);
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, path))
+        return ERRORMSG("Rename-into-path failed");
+
+    LogPrint(BCLog::INFO, "Wrote memory cache snapshot at tip block=[%d]%s, txids=%u, coin pairs=%u (%dms)\n",
+             pTip->height, tip_block_hash.ToString(), txids.size(), coin_price_points.size(),
+             GetTimeMillis() - start);
+    return true;
+}
+
+bool CMemCacheSnapshot::ReadFile() {
+    if (!boost::filesystem::exists(path))
+        return false;
+
+    FILE* file       = fopen(path.string().c_str(), "rb");
+    CAutoFile filein = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("Failed to open file %s", path.string());
+
+    int64_t fileSize = boost::filesystem::file_size(path);
+    int64_t dataSize = fileSize - sizeof(uint256);
+    if (dataSize < 0)
+        dataSize = 0;
+    vector<uint8_t> vchData;
+    vchData.resize(dataSize);
+    uint256 hashIn;
+
+    try {
+        filein.read((char*)&vchData[0], dataSize);
+        filein >> hashIn;
+    } catch (std::exception& e) {
+        return ERRORMSG("Deserialize or I/O error - %s", e.what());
+    }
+    filein.fclose();
+
+    CDataStream ssSnapshot(vchData, SER_DISK, CLIENT_VERSION);
+    uint256 hashTmp = Hash(ssSnapshot.begin(), ssSnapshot.end());
+    if (hashIn != hashTmp)
+        return ERRORMSG("Checksum mismatch, data corrupted");
+
+    uint8_t pchMsgTmp[4];
+    try {
+        ssSnapshot >> FLATDATA(pchMsgTmp);
+        if (memcmp(pchMsgTmp, SysCfg().MessageStart(), sizeof(pchMsgTmp)))
+            return ERRORMSG("Invalid network magic number");
+
+        ssSnapshot >> *this;
+    } catch (std::exception& e) {
+        return ERRORMSG("Deserialize or I/O error - %s", e.what());
+    }
+    return true;
+}
+
+bool CMemCacheSnapshot::Load(const CBlockIndex *pTip, CCacheDBManager &cdMan) {
+    int64_t start = GetTimeMillis();
+    if (pTip == nullptr || !ReadFile())
+        return false;
+
+    uint64_t slideWindow = 0;
+    cdMan.pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
+    if (version != CURRENT_VERSION || tip_block_hash != pTip->GetBlockHash() ||
+        tx_cache_height != SysCfg().GetTxCacheHeight() || price_slide_window != slideWindow) {
+        LogPrint(BCLog::INFO, "Memory cache snapshot of tip block=%s mismatched, current tip block=[%d]%s\n",
+                 tip_block_hash.ToString(), pTip->height, pTip->GetBlockHash().ToString());
+        return false;
+    }
+
+    cdMan.pTxCache->Clear();
+    cdMan.pTxCache->AddBlockTx(txids);
+    cdMan.pPpCache->SetCoinPricePointMap(coin_price_points);
+
+    LogPrint(BCLog::INFO, "Loaded memory cache snapshot at tip block=[%d]%s, txids=%u, coin pairs=%u (%dms)\n",
+             pTip->height, tip_block_hash.ToString(), txids.size(), coin_price_points.size(),
+             GetTimeMillis() - start);
+    return true;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_MEMCACHESNAPSHOT_H
+#define PERSIST_MEMCACHESNAPSHOT_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "pricefeeddb.h"
+
+#include <boost/filesystem/path.hpp>
+#include <vector>
+
+class CBlockIndex;
+class CCacheDBManager;
+
+// the snapshot file name in data dir
+static const std::string MEM_CACHE_SNAPSHOT_FILE = "memcache.dat";
+
+/**
+ * Snapshot of the memory only caches (tx memory cache and price point memory cache) at the tip block.
+ * It is written on clean shutdown and loaded on startup instead of rebuilding the caches from the
+ * recent blocks on disk, if the tip and the window sizes are not changed.
+ */
+class CMemCacheSnapshot {
+public:
+    static const int32_t CURRENT_VERSION = 1;
+
+    int32_t version = CURRENT_VERSION;
+    uint256 tip_block_hash;
+    int32_t tx_cache_height     = 0;
+    uint64_t price_slide_window = 0;
+    vector<uint256> txids;
+    CoinPricePointMap coin_price_points;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(version);
+        READWRITE(tip_block_hash);
+        READWRITE(tx_cache_height);
+        READWRITE(price_slide_window);
+        READWRITE(txids);
+        READWRITE(coin_price_points);
+    )
+
+public:
+    CMemCacheSnapshot() {}
+    CMemCacheSnapshot(const boost::filesystem::path &pathIn) : path(pathIn) {}
+
+    // take the snapshot of memory caches of cdMan at tip and write it to file
+    bool Write(const CBlockIndex *pTip, CCacheDBManager &cdMan);
+    // read the snapshot from file and load it to the memory caches of cdMan, if it matches the tip
+    bool Load(const CBlockIndex *pTip, CCacheDBManager &cdMan);
+
+private:
+    bool ReadFile();
+
+private:
+    boost::filesystem::path path;
+};
+
+#endif  // PERSIST_MEMCACHESNAPSHOT_H
@@ -134,8 +134,12 @@ bool CPricePointMemCache::AddPrice(const HeightType blockHeight, const CRegID &r
             return false;
         }
 
+        bool isNewCoinPair = mapCoinPricePointCache.count(pp.GetCoinPricePair()) == 0;
         CConsecutiveBlockPrice &cbp = mapCoinPricePointCache[pp.GetCoinPricePair()];
+        bool isNewHeight = cbp.mapBlockUserPrices.count(blockHeight) == 0;
         cbp.AddUserPrice(blockHeight, regId, pp.GetPrice());
+        if (is_journal_enabled)
+            price_journal.push_back({pp.GetCoinPricePair(), blockHeight, regId, isNewCoinPair, isNewHeight});
         LogPrint(BCLog::PRICEFEED,
                  "[%d] add block user price, redId: %s, pricePoint: %s\n",
                  blockHeight, regId.ToString(), pp.ToString());
@@ -144,6 +148,31 @@ bool CPricePointMemCache::AddPrice(const HeightType blockHeight, const CRegID &r
     return true;
 }
 
+void CPricePointMemCache::EnableJournal(bool enabled) {
+    is_journal_enabled = enabled;
+    if (!enabled)
+        price_journal.clear();
+}
+
+void CPricePointMemCache::RollbackJournal(size_t journalSize) {
+    while (price_journal.size() > journalSize) {
+        const UserPriceLog &log = price_journal.back();
+        auto coinIt = mapCoinPricePointCache.find(log.coin_pair);
+        if (coinIt != mapCoinPricePointCache.end()) {
+            BlockUserPriceMap &blockUserPrices = coinIt->second.mapBlockUserPrices;
+            auto heightIt = blockUserPrices.find(log.height);
+            if (heightIt != blockUserPrices.end()) {
+                heightIt->second.erase(log.regid);
+                if (log.is_new_height)
+                    blockUserPrices.erase(heightIt);
+            }
+            if (log.is_new_coin_pair)
+                mapCoinPricePointCache.erase(coinIt);
+        }
+        price_journal.pop_back();
+    }
+}
+
 bool CPricePointMemCache::ExistBlockUserPrice(const HeightType blockHeight, const CRegID &regId,
                                               const PriceCoinPair &coinPricePair) {
     if (mapCoinPricePointCache.count(coinPricePair) &&
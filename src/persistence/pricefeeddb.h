@@ -37,6 +37,10 @@ public:
 
 public:
     BlockUserPriceMap mapBlockUserPrices;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(mapBlockUserPrices);
+    )
 };
 
 class CPricePointMemCache {
@@ -57,6 +61,15 @@ public:
     void SetBaseViewPtr(CPricePointMemCache *pBaseIn);
     void Flush();
 
+    // for the memory cache snapshot
+    const CoinPricePointMap& GetCoinPricePointMap() const { return mapCoinPricePointCache; }
+    void SetCoinPricePointMap(const CoinPricePointMap &mapIn) { mapCoinPricePointCache = mapIn; }
+
+    // journal of the user prices added by AddPrice(), for rolling back to a savepoint of cache wrapper
+    void EnableJournal(bool enabled);
+    size_t GetJournalSize() const { return price_journal.size(); }
+    void RollbackJournal(size_t journalSize);
+
 private:
     CMedianPriceDetail GetMedianPrice(const HeightType blockHeight, const uint64_t slideWindow, const PriceCoinPair &coinPricePair);
 
@@ -78,9 +91,19 @@ private:
     static uint64_t ComputeMedianNumber(vector<uint64_t> &numbers);
 
 private:
+    struct UserPriceLog {
+        PriceCoinPair coin_pair;
+        HeightType height;
+        CRegID regid;
+        bool is_new_coin_pair;  // the coin pair was added to mapCoinPricePointCache by the user price
+        bool is_new_height;     // the height was added to mapBlockUserPrices by the user price
+    };
+
     CoinPricePointMap mapCoinPricePointCache;  // coinPriceType -> consecutiveBlockPrice
     CPricePointMemCache *pBase;
     PriceDetailMap latest_median_prices;
+    bool is_journal_enabled = false;
+    vector<UserPriceLog> price_journal;
 
 };
 
@@ -90,6 +113,10 @@ public:
     CPriceFeedCache(CDBAccess *pDbAccess)
     : price_feed_coin_pairs_cache(pDbAccess),
       median_price_cache(pDbAccess) {};
+
+    CPriceFeedCache(const CPriceFeedCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : price_feed_coin_pairs_cache(topCache.price_feed_coin_pairs_cache, pSnapshotDbAccess),
+          median_price_cache(topCache.median_price_cache, pSnapshotDbAccess) {}
 public:
     bool Flush() {
         price_feed_coin_pairs_cache.Flush();
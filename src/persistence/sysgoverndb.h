@@ -27,6 +27,11 @@ public:
                                                     proposals_cache(pBaseIn->proposals_cache),
                                                     approvals_cache(pBaseIn->approvals_cache) {};
 
+    CSysGovernDBCache(const CSysGovernDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : governors_cache(topCache.governors_cache, pSnapshotDbAccess),
+          proposals_cache(topCache.proposals_cache, pSnapshotDbAccess),
+          approvals_cache(topCache.approvals_cache, pSnapshotDbAccess) {}
+
     bool Flush() {
         governors_cache.Flush();
         proposals_cache.Flush();
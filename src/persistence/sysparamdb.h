@@ -57,6 +57,14 @@ public:
                                                   current_total_bps_size_cache(pBaseIn->current_total_bps_size_cache),
                                                   new_total_bps_size_cache(pBaseIn->new_total_bps_size_cache){}
 
+    CSysParamDBCache(const CSysParamDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : sys_param_chache(topCache.sys_param_chache, pSnapshotDbAccess),
+          miner_fee_cache(topCache.miner_fee_cache, pSnapshotDbAccess),
+          cdp_param_cache(topCache.cdp_param_cache, pSnapshotDbAccess),
+          cdp_interest_param_changes_cache(topCache.cdp_interest_param_changes_cache, pSnapshotDbAccess),
+          current_total_bps_size_cache(topCache.current_total_bps_size_cache, pSnapshotDbAccess),
+          new_total_bps_size_cache(topCache.new_total_bps_size_cache, pSnapshotDbAccess) {}
+
     bool GetParam(const SysParamType &paramType, uint64_t& paramValue) {
         if (kSysParamTable.count(paramType) == 0)
             return false;
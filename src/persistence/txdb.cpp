@@ -14,19 +14,36 @@
 
 #include <algorithm>
 
-bool CTxMemCache::AddBlockTx(const CBlock &block) {
+static vector<uint256> GetBlockTxids(const CBlock &block) {
+    vector<uint256> blockTxids;
+    blockTxids.reserve(block.vptx.size());
     for (auto &ptx : block.vptx) {
-        txids[ptx->GetHash()] = true;
+        blockTxids.push_back(ptx->GetHash());
     }
-    return true;
+    return blockTxids;
+}
+
+bool CTxMemCache::AddBlockTx(const CBlock &block) {
+    return AddBlockTx(GetBlockTxids(block));
 }
 
 bool CTxMemCache::RemoveBlockTx(const CBlock &block) {
-    for (auto &ptx : block.vptx) {
+    return RemoveBlockTx(GetBlockTxids(block));
+}
+
+bool CTxMemCache::AddBlockTx(const vector<uint256> &blockTxids) {
+    for (const auto &txid : blockTxids) {
+        txids[txid] = true;
+    }
+    return true;
+}
+
+bool CTxMemCache::RemoveBlockTx(const vector<uint256> &blockTxids) {
+    for (const auto &txid : blockTxids) {
         if (pBase == nullptr) {
-            txids.erase(ptx->GetHash());
+            txids.erase(txid);
         } else {
-            txids[ptx->GetHash()] = false;
+            txids[txid] = false;
         }
     }
     return true;
@@ -66,6 +83,15 @@ void CTxMemCache::Clear() { txids.clear(); }
 
 uint64_t CTxMemCache::GetSize() { return txids.size(); }
 
+void CTxMemCache::GetTxids(vector<uint256> &txidsOut) const {
+    txidsOut.clear();
+    txidsOut.reserve(txids.size());
+    for (const auto &item : txids) {
+        if (item.second)
+            txidsOut.push_back(item.first);
+    }
+}
+
 Object CTxMemCache::ToJsonObj() const {
     Array txArray;
     for (auto &item : txids) {
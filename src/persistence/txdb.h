@@ -32,6 +32,8 @@ public:
 
     bool AddBlockTx(const CBlock &block);
     bool RemoveBlockTx(const CBlock &block);
+    bool AddBlockTx(const vector<uint256> &blockTxids);
+    bool RemoveBlockTx(const vector<uint256> &blockTxids);
 
     void Clear();
     void SetBaseViewPtr(CTxMemCache *pBaseIn) { pBase = pBaseIn; }
@@ -39,6 +41,8 @@ public:
 
     Object ToJsonObj() const;
     uint64_t GetSize();
+    // get the existing txids of this cache only
+    void GetTxids(vector<uint256> &txidsOut) const;
 
 private:
     void BatchWrite(const TxIdMap &txidsIn);
@@ -22,6 +22,10 @@ public:
     CTxReceiptDBCache() {}
     CTxReceiptDBCache(CDBAccess *pDbAccess) : tx_receipt_cache(pDbAccess), block_receipt_cache(pDbAccess) {}
 
+    CTxReceiptDBCache(const CTxReceiptDBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : tx_receipt_cache(topCache.tx_receipt_cache, pSnapshotDbAccess),
+          block_receipt_cache(topCache.block_receipt_cache, pSnapshotDbAccess) {}
+
 public:
     bool SetTxReceipts(const TxID &txid, const vector<CReceipt> &receipts);
 
@@ -24,6 +24,10 @@ public:
     CTxUTXODBCache(CTxUTXODBCache* pBaseIn): tx_utxo_cache(pBaseIn->tx_utxo_cache),
                 tx_utxo_password_proof_cache(pBaseIn->tx_utxo_password_proof_cache) {} ;
 
+    CTxUTXODBCache(const CTxUTXODBCache &topCache, CDBAccess *pSnapshotDbAccess)
+        : tx_utxo_cache(topCache.tx_utxo_cache, pSnapshotDbAccess),
+          tx_utxo_password_proof_cache(topCache.tx_utxo_password_proof_cache, pSnapshotDbAccess) {}
+
 public:
     bool SetUtxoTx(const pair<TxID, CFixedUInt16> &utxoKey);
     bool GetUtxoTx(const pair<TxID, CFixedUInt16> &utxoKey);
@@ -214,7 +214,7 @@ string RegIDToAddress(CUserID &userId) {
 }
 
 Object GetTxDetailJSON(CCacheWrapper &cw, const CBlockHeader &header,
-                       const shared_ptr<CBaseTx> pBaseTx, const CTxCord &txCord) {
+                       const shared_ptr<CBaseTx> pBaseTx, const CTxCord &txCord, int32_t tipHeight) {
     Object obj;
     auto txid = pBaseTx->GetHash();
     //obj = pBaseTx->IsMultiSignSupport()?pBaseTx->ToJsonMultiSign(*database):pBaseTx->ToJson(*pCdMan->pAccountCache);
@@ -228,19 +228,18 @@ Object GetTxDetailJSON(CCacheWrapper &cw, const CBlockHeader &header,
 
     if (SysCfg().IsGenReceipt()) {
         vector<CReceipt> receipts;
-        pCdMan->pReceiptCache->GetTxReceipts(txid, receipts);
+        cw.txReceiptCache.GetTxReceipts(txid, receipts);
         obj.push_back(Pair("receipts", JSON::ToJson(cw.accountCache, receipts)));
     }
 
     CDataStream ds(SER_DISK, CLIENT_VERSION);
     ds << pBaseTx;
     obj.push_back(Pair("rawtx", HexStr(ds.begin(), ds.end())));
-    obj.push_back(Pair("confirmations",     chainActive.Height() - (int32_t)header.GetHeight()));
+    obj.push_back(Pair("confirmations",     tipHeight - (int32_t)header.GetHeight()));
 
     string trace;
-    auto database = std::make_shared<CCacheWrapper>(pCdMan);
-    auto resolver = make_resolver(*database);
-    if(database->contractCache.GetContractTraces(txid, trace)){
+    auto resolver = make_resolver(cw);
+    if(cw.contractCache.GetContractTraces(txid, trace)){
 
         json_spirit::Value value_json;
         std::vector<char>  trace_bytes = std::vector<char>(trace.begin(), trace.end());
@@ -252,29 +251,25 @@ Object GetTxDetailJSON(CCacheWrapper &cw, const CBlockHeader &header,
     return obj;
 }
 
+/**
+ * Query the tx on the state view of the tip without cs_main, the confirmed tx is read from the block file by
+ * the tx index in the view, which is not changed by the blocks connected later.
+ */
 Object GetTxDetailJSON(const uint256& txid) {
-    auto pCw = make_shared<CCacheWrapper>(pCdMan);
+    auto pView = GetStateView();
+    auto pCw = std::make_shared<CCacheWrapper>(&pView->GetCaches());
     Object obj;
     {
         std::shared_ptr<CBaseTx> pBaseTx;
 
-        LOCK(cs_main);
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos postx;
             if (pCw->blockCache.ReadTxIndex(txid, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-                CBlockHeader header;
-
-                try {
-                    file >> header;
-                    fseek(file, postx.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
-                    obj = GetTxDetailJSON(*pCw, header, pBaseTx, postx.tx_cord);
-                } catch (std::exception &e) {
-                    throw runtime_error(strprintf("%s : Deserialize or I/O error - %s", __func__, e.what()).c_str());
-                }
+                CTxBodyCache::InfoPtr pInfo;
+                if (!txBodyCache.GetOrRead(txid, postx, pInfo))
+                    throw runtime_error(strprintf("%s : read tx %s from block file failed", __func__, txid.GetHex()));
 
-                return obj;
+                return GetTxDetailJSON(*pCw, *pInfo->header, pInfo->tx, postx.tx_cord, pView->GetHeight());
             }
         }
 
@@ -291,7 +286,11 @@ Object GetTxDetailJSON(const uint256& txid) {
 
         /* try */
         CBlock genesisblock;
-        CBlockIndex* pGenesisBlockIndex = mapBlockIndex[SysCfg().GetGenesisBlockHash()];
+        CBlockIndex* pGenesisBlockIndex = nullptr;
+        {
+            LOCK(cs_main);
+            pGenesisBlockIndex = mapBlockIndex[SysCfg().GetGenesisBlockHash()];
+        }
         ReadBlockFromDisk(pGenesisBlockIndex, genesisblock);
         assert(genesisblock.GetMerkleRootHash() == genesisblock.BuildMerkleTree());
         for (uint32_t i = 0; i < genesisblock.vptx.size(); ++i) {
@@ -299,7 +298,7 @@ Object GetTxDetailJSON(const uint256& txid) {
                 obj = genesisblock.vptx[i]->ToJson(*pCw);
 
 
-                obj.push_back(Pair("confirmed_height",  chainActive.Height()));
+                obj.push_back(Pair("confirmed_height",  pView->GetHeight()));
                 obj.push_back(Pair("confirmed_time",    (int32_t)genesisblock.GetTime()));
                 obj.push_back(Pair("block_hash",        genesisblock.GetHash().GetHex()));
                 obj.push_back(Pair("tx_cord", CTxCord(0, i).ToString()));
@@ -308,11 +307,11 @@ Object GetTxDetailJSON(const uint256& txid) {
                 ds << genesisblock.vptx[i];
                 if (SysCfg().IsGenReceipt()) {
                     vector<CReceipt> receipts;
-                    pCdMan->pReceiptCache->GetTxReceipts(txid, receipts);
+                    pCw->txReceiptCache.GetTxReceipts(txid, receipts);
                     obj.push_back(Pair("receipts", JSON::ToJson(pCw->accountCache, receipts)));
                 }
                 obj.push_back(Pair("rawtx", HexStr(ds.begin(), ds.end())));
-                obj.push_back(Pair("confirmations",     chainActive.Height()));
+                obj.push_back(Pair("confirmations",     pView->GetHeight()));
 
                 return obj;
             }
@@ -851,10 +850,11 @@ static uint64_t ComputeCDPInterest(CSysParamDBCache &sysParamCache, const CUserC
     return interest;
 }
 
-Object RPC_PARAM::CdpToJson(const CUserCDP &cdp, uint32_t tipHeight) {
+static Object GetCdpJson(CPriceFeedCache &priceFeedCache, CSysParamDBCache &sysParamCache, const CUserCDP &cdp,
+                         uint32_t tipHeight) {
 
-    uint64_t bcoinMedianPrice = GetPriceByCdp(*pCdMan->pPriceFeedCache, cdp);
-    uint64_t interest = ComputeCDPInterest(*pCdMan->pSysParamCache, cdp, tipHeight);
+    uint64_t bcoinMedianPrice = RPC_PARAM::GetPriceByCdp(priceFeedCache, cdp);
+    uint64_t interest = ComputeCDPInterest(sysParamCache, cdp, tipHeight);
 
     int32_t blockInterval = tipHeight >= cdp.block_height ? tipHeight - cdp.block_height : 0;
     int32_t interestDays    = std::max<int32_t>(1, ceil((double)blockInterval / SysCfg().GetOneDayBlocks(tipHeight)));
@@ -863,4 +863,12 @@ Object RPC_PARAM::CdpToJson(const CUserCDP &cdp, uint32_t tipHeight) {
     obj.push_back(Pair("interest_due", interest));
     obj.push_back(Pair("interest_days", interestDays));
     return obj;
+}
+
+Object RPC_PARAM::CdpToJson(const CUserCDP &cdp, uint32_t tipHeight) {
+    return GetCdpJson(*pCdMan->pPriceFeedCache, *pCdMan->pSysParamCache, cdp, tipHeight);
+}
+
+Object RPC_PARAM::CdpToJson(CCacheWrapper &cw, const CUserCDP &cdp, uint32_t tipHeight) {
+    return GetCdpJson(cw.priceFeedCache, cw.sysParamCache, cdp, tipHeight);
 }
\ No newline at end of file
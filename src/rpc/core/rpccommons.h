@@ -46,7 +46,7 @@ class CBlockHeader;
 
 string RegIDToAddress(CUserID &userId);
 Object GetTxDetailJSON(CCacheWrapper &cw, const CBlockHeader &block,
-                       const shared_ptr<CBaseTx> pBaseTx, const CTxCord &txCord);
+                       const shared_ptr<CBaseTx> pBaseTx, const CTxCord &txCord, int32_t tipHeight);
 Object GetTxDetailJSON(const uint256& txid);
 Array GetTxAddressDetail(std::shared_ptr<CBaseTx> pBaseTx);
 
@@ -129,6 +129,7 @@ namespace RPC_PARAM {
     CBlock ReadBlock(CBlockIndex* pBlockIndex);
 
     Object CdpToJson(const CUserCDP &cdp, uint32_t tipHeight);
+    Object CdpToJson(CCacheWrapper &cw, const CUserCDP &cdp, uint32_t tipHeight);
 }
 
 /*
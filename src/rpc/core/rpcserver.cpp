@@ -70,6 +70,7 @@ std::unique_ptr<T> MakeUnique(Args&&... args) {
 }
 
 static bool JsonRPCHandler(HTTPRequest* req, const std::string&);
+static bool MetricsHandler(HTTPRequest* req, const std::string&);
 
 void RPCTypeCheck(const Array& params, const list<Value_type>& typesExpected, bool fAllowNull) {
     unsigned int i = 0;
@@ -325,6 +326,8 @@ bool StartRPCServer() {
     }
 
     RegisterHTTPHandler("/", true, JsonRPCHandler);
+    if (SysCfg().GetBoolArg("-rpcmetrics", false))
+        RegisterHTTPHandler("/metrics", true, MetricsHandler);
 
     struct event_base* eventBase = EventBase();
     assert(eventBase);
@@ -343,6 +346,7 @@ void InterruptRPCServer() {
 void StopRPCServer() {
     LogPrint(BCLog::INFO, "Stopping HTTP RPC server\n");
     UnregisterHTTPHandler("/", true);
+    UnregisterHTTPHandler("/metrics", true);
 
     if (httpRPCTimerInterface) {
         RPCUnsetTimerInterface(httpRPCTimerInterface.get());
@@ -568,6 +572,18 @@ static bool JsonRPCHandler(HTTPRequest* req, const std::string&) {
     return true;
 }
 
+/** metrics handler registered to http server, it serves the Prometheus scrapers without authorization */
+static bool MetricsHandler(HTTPRequest* req, const std::string&) {
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        req->WriteReply(HTTP_BAD_METHOD, "metrics handles only GET requests");
+        return false;
+    }
+
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, CMetricsRegistry::Instance().ToPrometheusText());
+    return true;
+}
+
 void RPCSetTimerInterface(RPCTimerInterface* iface) {
     timerInterface = iface;
 }
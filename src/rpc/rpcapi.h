@@ -218,6 +218,8 @@ extern Value listmintxfees(const Array& params, bool fHelp);
 // debug only
 extern Value dumpdb(const Array& params, bool fHelp);
 extern Value getmemstat(const Array& params, bool fHelp);
+extern Value getdbcachestat(const Array& params, bool fHelp);
+extern Value getmetrics(const Array& params, bool fHelp);
 
 extern Value startcommontpstest(const Array& params, bool fHelp);
 extern Value startcontracttpstest(const Array& params, bool fHelp);
@@ -54,9 +54,9 @@ static const CRPCCommand vRPCCommands[] =
     { "getminerbyblocktime",            &getminerbyblocktime,               true,      true,        false   },
     
     /* uses wallet if enabled */
-    { "getaccountinfo",                 &getaccountinfo,                    true,      false,       true    },
+    { "getaccountinfo",                 &getaccountinfo,                    true,      true,        true    },
     { "getnewaddr",                     &getnewaddr,                        false,     false,       true    },
-    { "gettxdetail",                    &gettxdetail,                       true,      false,       true    },
+    { "gettxdetail",                    &gettxdetail,                       true,      true,        true    },
     { "getclosedcdp",                   &getclosedcdp,                      true,      false,       true    },
     { "getwalletinfo",                  &getwalletinfo,                     true,      false,       true    },
 
@@ -168,8 +168,8 @@ static const CRPCCommand vRPCCommands[] =
     { "submitsetcodetx",                &submitsetcodetx,                   true,       false,      true    },
     { "submittx",                       &submittx,                          true,       false,      true    },
 
-    { "wasm_gettable",                  &wasm_gettable,                      true,       false,      true    },
-    { "wasm_getrow",                    &wasm_getrow,                        true,       false,      true    },
+    { "wasm_gettable",                  &wasm_gettable,                      true,       true,       true    },
+    { "wasm_getrow",                    &wasm_getrow,                        true,       true,       true    },
     { "wasm_json2bin",                  &wasm_json2bin,                      true,       false,      true    },
     { "wasm_bin2json",                  &wasm_bin2json,                      true,       false,      true    },
     { "wasm_getcode",                   &wasm_getcode,                       true,       false,      true    },
@@ -196,6 +196,8 @@ static const CRPCCommand vRPCCommands[] =
     /* debug */
     { "dumpdb",                         &dumpdb,                            true,       false,       false    },
     { "getmemstat",                     &getmemstat,                        true,       false,       false    },
+    { "getdbcachestat",                 &getdbcachestat,                    true,       false,       false    },
+    { "getmetrics",                     &getmetrics,                        true,       false,       false    },
 
 #ifdef ENABLE_GPERFTOOLS
     { "startheapprofiler",              &startheapprofiler,                 true,       false,       false    },
@@ -259,7 +259,8 @@ Value getblock(const Array& params, bool fHelp) {
     if(fListTxs) {
         Array arr;
         for (size_t i = 0; i < block.vptx.size(); i++) {
-            arr.push_back(GetTxDetailJSON(*pCw, block, block.vptx[i], CTxCord(block.GetHeight(), i)));
+            arr.push_back(GetTxDetailJSON(*pCw, block, block.vptx[i], CTxCord(block.GetHeight(), i),
+                                          chainActive.Height()));
         }
         o.push_back(Pair("tx_details", arr));
     }
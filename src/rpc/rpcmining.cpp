@@ -159,7 +159,7 @@ Value submitblock(const Array& params, bool fHelp) {
     }
 
     CValidationState state;
-    bool fAccepted = ProcessBlock(state, NULL, &pBlock);
+    bool fAccepted = ProcessBlock(state, NULL, &pBlock, NULL, true);
     Object obj;
     if (!fAccepted) {
         obj.push_back(Pair("status",        "rejected"));
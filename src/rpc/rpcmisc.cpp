@@ -670,15 +670,17 @@ Value getmemstat(const Array& params, bool fHelp) {
     // mapBlockIndex
     {
         Object statObj;
+        LOCK(cs_main);
         statObj.push_back(Pair("count", (int64_t)mapBlockIndex.size()));
-        uint64_t totalSz = 0;
-        if (mapBlockIndex.size() > 0) {
-            const auto &idx = *mapBlockIndex.rbegin()->second;
-            // need to calc size for each idx?
-            totalSz = sizeof(mapBlockIndex) + mapBlockIndex.size() * (sizeof(idx));
-        }
+        uint64_t mapSz   = sizeof(mapBlockIndex) + GetBlockMapMemoryUsage(mapBlockIndex);
+        uint64_t arenaSz = blockIndexArena.GetMemoryUsage();
+        uint64_t totalSz = mapSz + arenaSz;
         statObj.push_back(Pair("size", SizeToString(totalSz)));
         statObj.push_back(Pair("size_bytes", totalSz));
+        statObj.push_back(Pair("map_size_bytes", mapSz));
+        statObj.push_back(Pair("arena_count", (int64_t)blockIndexArena.GetCount()));
+        statObj.push_back(Pair("arena_size_bytes", arenaSz));
+        statObj.push_back(Pair("load_factor", mapBlockIndex.load_factor()));
 
         obj.push_back(Pair("block_index_map", statObj));
     }
@@ -763,6 +765,135 @@ Value getmemstat(const Array& params, bool fHelp) {
     return obj;
 }
 
+Value getdbcachestat(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 0) {
+        throw runtime_error(
+            "getdbcachestat \n"
+            "\nget the stat of db read caches and flushes.\n"
+            "\nArguments:\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"$db_name\": {\n"
+            "    \"read_cache_max_size\": xxxxx,   (numeric) the max size of read cache in bytes\n"
+            "    \"read_cache_size\": xxxxx,       (numeric) the current size of read cache in bytes\n"
+            "    \"read_cache_count\": xxxxx,      (numeric) the count of cached items\n"
+            "    \"read_cache_hits\": xxxxx,       (numeric) the count of reads hit in read cache\n"
+            "    \"read_cache_misses\": xxxxx,     (numeric) the count of reads missed in read cache\n"
+            "    \"read_cache_evictions\": xxxxx,  (numeric) the count of items evicted from read cache\n"
+            "    \"flush_written\": xxxxx,         (numeric) the count of modified items written to db\n"
+            "    \"flush_clean_skipped\": xxxxx    (numeric) the count of clean items skipped by flush\n"
+            "  },\n"
+            "  ...\n"
+            "  \"flush\": {\n"
+            "    \"single_state_db\": true|false, (boolean) whether all state dbs are committed by one batch\n"
+            "    \"count\": xxxxx,                 (numeric) the count of flushes\n"
+            "    \"avg_time_ms\": xxxxx,           (numeric) the average elapsed time of flushes in ms\n"
+            "    \"max_time_ms\": xxxxx            (numeric) the max elapsed time of flushes in ms\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getdbcachestat", "") +
+            "\nAs json rpc\n" +
+            HelpExampleRpc("getdbcachestat", ""));
+    }
+
+    Object obj;
+    for (auto pDbAccess : pCdMan->GetDbAccessList()) {
+        const auto &readCache = pDbAccess->GetReadCache();
+        Object statObj;
+        statObj.push_back(Pair("read_cache_max_size",   (uint64_t)readCache.GetMaxSize()));
+        statObj.push_back(Pair("read_cache_size",       (uint64_t)readCache.GetSize()));
+        statObj.push_back(Pair("read_cache_count",      (uint64_t)readCache.GetCount()));
+        statObj.push_back(Pair("read_cache_hits",       readCache.GetHitCount()));
+        statObj.push_back(Pair("read_cache_misses",     readCache.GetMissCount()));
+        statObj.push_back(Pair("read_cache_evictions",  readCache.GetEvictedCount()));
+        statObj.push_back(Pair("flush_written",         pDbAccess->GetFlushWrittenCount()));
+        statObj.push_back(Pair("flush_clean_skipped",   pDbAccess->GetFlushCleanCount()));
+
+        obj.push_back(Pair(::GetDbName(pDbAccess->GetDbNameType()), statObj));
+    }
+
+    Object flushObj;
+    uint64_t flushCount = pCdMan->GetFlushCount();
+    flushObj.push_back(Pair("single_state_db",  pCdMan->IsSingleStateDb()));
+    flushObj.push_back(Pair("count",            flushCount));
+    flushObj.push_back(Pair("avg_time_ms",      flushCount > 0 ? pCdMan->GetFlushTotalTime() * 0.001 / flushCount : 0.0));
+    flushObj.push_back(Pair("max_time_ms",      pCdMan->GetFlushMaxTime() * 0.001));
+    obj.push_back(Pair("flush", flushObj));
+
+    return obj;
+}
+
+Value getmetrics(const Array& params, bool fHelp) {
+    if (fHelp || params.size() > 1) {
+        throw runtime_error(
+            "getmetrics ( reset )\n"
+            "\nget the counters, gauges and benchmark latencies collected since startup or the last reset.\n"
+            "\nArguments:\n"
+            "1.\"reset\"            (boolean, optional) reset the counters and latencies after reading, default is false\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"counters\": { \"$name\": xxxxx, ... },\n"
+            "  \"gauges\": { \"$name\": xxxxx, ... },\n"
+            "  \"benchmarks\": {\n"
+            "    \"$name\": {\n"
+            "      \"count\": xxxxx,       (numeric) the count of the measured scopes\n"
+            "      \"avg_us\": xxxxx,      (numeric) the average time spent in us\n"
+            "      \"p50_us\": xxxxx,      (numeric) the median time spent in us\n"
+            "      \"p90_us\": xxxxx,      (numeric) the 90th percentile of the time spent in us\n"
+            "      \"p99_us\": xxxxx,      (numeric) the 99th percentile of the time spent in us\n"
+            "      \"max_us\": xxxxx       (numeric) the max time spent in us\n"
+            "    },\n"
+            "    ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getmetrics", "") +
+            "\nAs json rpc\n" +
+            HelpExampleRpc("getmetrics", ""));
+    }
+
+    bool reset = params.size() > 0 && params[0].get_bool();
+    auto &registry = CMetricsRegistry::Instance();
+
+    vector<pair<string, uint64_t>> counters;
+    registry.GetCounters(counters);
+    Object counterObj;
+    for (const auto &item : counters)
+        counterObj.push_back(Pair(item.first, item.second));
+
+    vector<pair<string, int64_t>> gauges;
+    registry.GetGauges(gauges);
+    Object gaugeObj;
+    for (const auto &item : gauges)
+        gaugeObj.push_back(Pair(item.first, item.second));
+
+    vector<pair<string, CMetricHistogram::Stat>> histograms;
+    registry.GetHistograms(histograms);
+    Object benchmarkObj;
+    for (const auto &item : histograms) {
+        const auto &stat = item.second;
+        Object statObj;
+        statObj.push_back(Pair("count",     stat.count));
+        statObj.push_back(Pair("avg_us",    stat.count > 0 ? stat.sum / stat.count : 0));
+        statObj.push_back(Pair("p50_us",    stat.p50));
+        statObj.push_back(Pair("p90_us",    stat.p90));
+        statObj.push_back(Pair("p99_us",    stat.p99));
+        statObj.push_back(Pair("max_us",    stat.max));
+        benchmarkObj.push_back(Pair(item.first, statObj));
+    }
+
+    if (reset)
+        registry.Reset();
+
+    Object obj;
+    obj.push_back(Pair("counters",      counterObj));
+    obj.push_back(Pair("gauges",        gaugeObj));
+    obj.push_back(Pair("benchmarks",    benchmarkObj));
+    return obj;
+}
+
 #ifdef ENABLE_GPERFTOOLS
 
 #include <gperftools/heap-profiler.h>
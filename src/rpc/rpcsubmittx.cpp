@@ -367,7 +367,10 @@ Value wasm_gettable( const Array &params, bool fHelp ) {
     RPCTypeCheck(params, list_of(str_type)(str_type));
 
     try{
-        auto db_contract    = pCdMan->pContractCache;
+        // read the state view of the tip without cs_main
+        auto pView          = GetStateView();
+        auto pCw            = std::make_shared<CCacheWrapper>(&pView->GetCaches());
+        auto db_contract    = &pCw->contractCache;
         auto contract_regid = RPC_PARAM::ParseRegId(params[0], "contract");
         auto contract_table = wasm::name(params[1].get_str());
         auto key_prefix_arr = GetKeyPrefixArray(params, 2);
@@ -397,6 +400,12 @@ Value wasm_gettable( const Array &params, bool fHelp ) {
         CHAIN_ASSERT( pContractDataIt, wasm_chain::table_not_found,
                       "cannot get table '%s' from contract '%s'", contract_table.to_string(), contract_regid.ToString() )
 
+        // all of the rows are unpacked by the cached serializer of the abi
+        auto abis_ptr   = wasm::abi_serializer::get_cached(abi, max_serialization_time);
+        auto table_type = abis_ptr->get_table_type(contract_table.to_string());
+        CHAIN_ASSERT( table_type.size() > 0, wasm_chain::abi_parse_exception,
+                      "can not get table %s's type from abi", contract_table.to_string() )
+
         bool                hasMore = false;
         json_spirit::Object object_return;
         json_spirit::Array  row_json;
@@ -415,7 +424,7 @@ Value wasm_gettable( const Array &params, bool fHelp ) {
 
             //unpack value in bytes to json
             std::vector<char> value_bytes(value.begin(), value.end());
-            json_spirit::Value   value_json  = wasm::abi_serializer::unpack(abi, contract_table.value, value_bytes, max_serialization_time);
+            json_spirit::Value   value_json  = abis_ptr->binary_to_variant(table_type, value_bytes, max_serialization_time);
             json_spirit::Object& object_json = value_json.get_obj();
 
             //append key and value
@@ -440,7 +449,10 @@ Value wasm_getrow( const Array &params, bool fHelp ) {
     RPCTypeCheck(params, list_of(str_type)(str_type)(str_type));
 
     try{
-        auto db_contract    = pCdMan->pContractCache;
+        // read the state view of the tip without cs_main
+        auto pView          = GetStateView();
+        auto pCw            = std::make_shared<CCacheWrapper>(&pView->GetCaches());
+        auto db_contract    = &pCw->contractCache;
         auto contract_regid = RPC_PARAM::ParseRegId(params[0], "contract");
         auto contract_table = wasm::name(params[1].get_str());
         auto key = RPC_PARAM::GetBinStrFromHex(params[2], "key");
@@ -652,9 +652,12 @@ Value getaccountinfo(const Array& params, bool fHelp) {
     bool on_chain = false;
     bool pubkey_registered = false;
     bool in_wallet = false;
-    uint32_t tipHeight = chainActive.Height();
+    // read the state view of the tip without cs_main
+    auto pView = GetStateView();
+    auto pCw = std::make_shared<CCacheWrapper>(&pView->GetCaches());
+    uint32_t tipHeight = pView->GetHeight();
 
-    if (pCdMan->pAccountCache->GetAccount(userId, account)) {
+    if (pCw->accountCache.GetAccount(userId, account)) {
         on_chain = true;
         pubkey_registered = account.owner_pubkey.IsValid();
     }
@@ -680,7 +683,7 @@ Value getaccountinfo(const Array& params, bool fHelp) {
                 addrStr));
         }
     }
-    obj = account.ToJsonObj();
+    obj = account.ToJsonObj(pCw->delegateCache, tipHeight);
     obj.push_back(Pair("onchain", on_chain));
     obj.push_back(Pair("in_wallet", in_wallet));
     obj.push_back(Pair("pubkey_registered", pubkey_registered));
@@ -689,9 +692,9 @@ Value getaccountinfo(const Array& params, bool fHelp) {
     if (on_chain && !account.regid.IsEmpty()) {
         Array cdps;
         vector<CUserCDP> userCdps;
-        if (pCdMan->pCdpCache->GetCDPList(account.regid, userCdps)) {
+        if (pCw->cdpCache.GetCDPList(account.regid, userCdps)) {
             for (auto& cdp : userCdps) {
-                cdps.push_back(RPC_PARAM::CdpToJson(cdp, tipHeight));
+                cdps.push_back(RPC_PARAM::CdpToJson(*pCw, cdp, tipHeight));
             }
         }
 
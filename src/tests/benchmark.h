@@ -0,0 +1,17 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef TESTS_BENCHMARK_H
+#define TESTS_BENCHMARK_H
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * A test case measuring the throughput, which it reports by BOOST_TEST_MESSAGE. It is skipped by the unit test run
+ * unless selected by its name or the bench label, e.g. unit_test --run_test=@bench --log_level=message
+ */
+#define BENCHMARK_TEST_CASE(name) \
+    BOOST_AUTO_TEST_CASE(name, *boost::unit_test::label("bench") * boost::unit_test::disabled())
+
+#endif  // TESTS_BENCHMARK_H
@@ -0,0 +1,170 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "persistence/cachewrapper.h"
+#include "tests/benchmark.h"
+
+using namespace std;
+
+static const uint32_t CACHE_SIZE = 50 << 10;  // 50K
+
+// cache wrapper whose contract cache is based on a memory db
+struct FCacheWrapperTests {
+    FCacheWrapperTests()
+        : contract_db(DBNameType::CONTRACT, "cachewrapper_tests", CACHE_SIZE, true, true),
+          db_contract_cache(&contract_db) {
+        cw.contractCache.SetBaseViewPtr(&db_contract_cache);
+    }
+
+    CDBAccess contract_db;
+    CContractDBCache db_contract_cache;
+    CCacheWrapper cw;
+};
+
+static bool GetContractData(CCacheWrapper &cw, const CRegID &regid, const string &key, string &value) {
+    return cw.contractCache.GetContractData(regid, key, value);
+}
+
+BOOST_FIXTURE_TEST_SUITE(cachewrapper_tests, FCacheWrapperTests)
+
+BOOST_AUTO_TEST_CASE(savepoint_rollback_test)
+{
+    const CRegID regid(100, 1);
+    string value;
+    BOOST_CHECK(cw.contractCache.SetContractData(regid, "key1", "value1"));
+
+    {
+        CCacheSavepoint savepoint(cw);
+        BOOST_CHECK(cw.GetSavepointCount() == 1);
+        BOOST_CHECK(cw.contractCache.SetContractData(regid, "key1", "value1-changed"));
+        BOOST_CHECK(cw.contractCache.SetContractData(regid, "key2", "value2"));
+        BOOST_CHECK(cw.contractCache.EraseContractData(regid, "key1"));
+        BOOST_CHECK(!GetContractData(cw, regid, "key1", value));
+    }
+    BOOST_CHECK(cw.GetSavepointCount() == 0);
+    BOOST_CHECK(GetContractData(cw, regid, "key1", value) && value == "value1");
+    BOOST_CHECK(!GetContractData(cw, regid, "key2", value));
+
+    {
+        CCacheSavepoint savepoint(cw);
+        BOOST_CHECK(cw.contractCache.SetContractData(regid, "key2", "value2"));
+        savepoint.Commit();
+    }
+    BOOST_CHECK(GetContractData(cw, regid, "key2", value) && value == "value2");
+
+    // the rolled back changes are not flushed to db
+    cw.contractCache.Flush();
+    db_contract_cache.Flush();
+    CContractDBCache dbCache(&contract_db);
+    BOOST_CHECK(dbCache.GetContractData(regid, "key1", value) && value == "value1");
+    BOOST_CHECK(dbCache.GetContractData(regid, "key2", value) && value == "value2");
+}
+
+BOOST_AUTO_TEST_CASE(savepoint_nested_test)
+{
+    const CRegID regid(100, 1);
+    string value;
+
+    cw.Savepoint();
+    BOOST_CHECK(cw.contractCache.SetContractData(regid, "outer", "1"));
+
+    cw.Savepoint();
+    BOOST_CHECK(cw.contractCache.SetContractData(regid, "outer", "2"));
+    BOOST_CHECK(cw.contractCache.SetContractData(regid, "inner", "1"));
+    cw.RollbackToSavepoint();
+    BOOST_CHECK(GetContractData(cw, regid, "outer", value) && value == "1");
+    BOOST_CHECK(!GetContractData(cw, regid, "inner", value));
+
+    cw.Savepoint();
+    BOOST_CHECK(cw.contractCache.SetContractData(regid, "inner", "2"));
+    cw.ReleaseSavepoint();
+    BOOST_CHECK(cw.GetSavepointCount() == 1);
+
+    // rolling back the outer savepoint discards the changes of the released inner one too
+    cw.RollbackToSavepoint();
+    BOOST_CHECK(cw.GetSavepointCount() == 0);
+    BOOST_CHECK(!GetContractData(cw, regid, "outer", value));
+    BOOST_CHECK(!GetContractData(cw, regid, "inner", value));
+
+    // the owner's op log map journals the savepoints and keeps the logs of the released ones only
+    CDBOpLogMap dbOpLogMap;
+    cw.SetDbOpLogMap(&dbOpLogMap);
+    cw.Savepoint();
+    BOOST_CHECK(cw.contractCache.SetContractData(regid, "logged", "1"));
+    cw.ReleaseSavepoint();
+    cw.Savepoint();
+    BOOST_CHECK(cw.contractCache.SetContractData(regid, "logged", "2"));
+    cw.RollbackToSavepoint();
+    BOOST_CHECK(GetContractData(cw, regid, "logged", value) && value == "1");
+    const CDbOpLogs *pDbOpLogs = dbOpLogMap.GetDbOpLogsPtr(dbk::CONTRACT_DATA);
+    BOOST_CHECK(pDbOpLogs != nullptr && pDbOpLogs->size() == 1);
+    cw.SetDbOpLogMap(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(savepoint_price_point_test)
+{
+    const CRegID regid(100, 1);
+    const PriceCoinPair coinPair(SYMB::WICC, SYMB::USD);
+    vector<CPricePoint> pricePoints = {CPricePoint(coinPair, 10000)};
+
+    {
+        CCacheSavepoint savepoint(cw);
+        BOOST_CHECK(cw.ppCache.AddPrice(10, regid, pricePoints));
+        savepoint.Commit();
+    }
+    {
+        CCacheSavepoint savepoint(cw);
+        BOOST_CHECK(cw.ppCache.AddPrice(11, regid, pricePoints));
+        BOOST_CHECK(cw.ppCache.AddPrice(11, CRegID(100, 2), pricePoints));
+    }
+
+    const auto &coinPricePoints = cw.ppCache.GetCoinPricePointMap();
+    BOOST_CHECK(coinPricePoints.size() == 1);
+    const auto &blockUserPrices = coinPricePoints.at(coinPair).mapBlockUserPrices;
+    BOOST_CHECK(blockUserPrices.size() == 1 && blockUserPrices.count(10) == 1);
+    BOOST_CHECK(cw.ppCache.GetJournalSize() == 0);
+}
+
+// pack the txs into the block in a time budget, each tx changes a few entries and every 10th tx fails
+BENCHMARK_TEST_CASE(savepoint_pack_benchmark)
+{
+    const int64_t TIME_BUDGET   = 200 * 1000;  // in microseconds
+    const int32_t TX_DATA_COUNT = 4;
+
+    auto executeTx = [&](CCacheWrapper &txCw, int32_t txIndex) {
+        CRegID regid(txIndex % 1000 + 1, 1);
+        for (int32_t i = 0; i < TX_DATA_COUNT; i++)
+            txCw.contractCache.SetContractData(regid, strprintf("key-%d", i), strprintf("value-%d", txIndex));
+        return txIndex % 10 != 9;
+    };
+
+    int32_t wrapperTxCount = 0;
+    int64_t beginTime      = GetTimeMicros();
+    while (GetTimeMicros() - beginTime < TIME_BUDGET) {
+        auto spCW = std::make_shared<CCacheWrapper>(&cw);
+        if (executeTx(*spCW, wrapperTxCount))
+            spCW->Flush();
+        wrapperTxCount++;
+    }
+
+    int32_t savepointTxCount = 0;
+    beginTime                = GetTimeMicros();
+    while (GetTimeMicros() - beginTime < TIME_BUDGET) {
+        CCacheSavepoint savepoint(cw);
+        if (executeTx(cw, savepointTxCount))
+            savepoint.Commit();
+        savepointTxCount++;
+    }
+
+    BOOST_TEST_MESSAGE(strprintf("txs packed in %lldms: new wrapper per tx=%d, savepoint per tx=%d",
+                                 TIME_BUDGET / 1000, wrapperTxCount, savepointTxCount));
+    BOOST_CHECK(wrapperTxCount > 0 && savepointTxCount > 0);
+    BOOST_CHECK(cw.GetSavepointCount() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -39,5 +39,29 @@ BOOST_AUTO_TEST_CASE(lrucache_test)
     BOOST_CHECK(cache.Get("1") == nullptr);
 }
 
+BOOST_AUTO_TEST_CASE(lrucache_size_test)
+{
+    typedef CLruCache<std::string, std::string> Cache;
+    Cache cache(10, [](const Cache::Item &item) { return item.second.size(); });
+    cache.Insert("1", "aaa");
+    cache.Insert("2", "bbb");
+    BOOST_CHECK(cache.GetSize() == 6 && cache.GetCount() == 2);
+
+    // update the existed key
+    cache.Insert("1", "aaaa");
+    BOOST_CHECK(cache.GetSize() == 7 && cache.GetCount() == 2);
+    BOOST_CHECK(cache.GetQueue().front() == Cache::Item("1", "aaaa"));
+
+    cache.Insert("3", "cccc");
+    BOOST_CHECK(cache.GetSize() == 8 && cache.GetCount() == 2);
+    BOOST_CHECK(cache.GetEvictedCount() == 1);
+    BOOST_CHECK(cache.Get("2") == nullptr);
+
+    cache.Remove("1");
+    BOOST_CHECK(cache.GetSize() == 4 && cache.GetCount() == 1);
+    cache.Clear();
+    BOOST_CHECK(cache.GetSize() == 0 && cache.GetCount() == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,73 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include "commons/util/util.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(metrics_tests)
+
+BOOST_AUTO_TEST_CASE(histogram_bucket_test)
+{
+    uint32_t lastIndex = 0;
+    for (uint64_t us = 0; us < (1ULL << 20); us++) {
+        uint32_t index = CMetricHistogram::GetBucketIndex(us);
+        BOOST_REQUIRE(index == lastIndex || index == lastIndex + 1);
+        BOOST_REQUIRE(CMetricHistogram::GetBucketLowerBound(index) <= us);
+        BOOST_REQUIRE(us < CMetricHistogram::GetBucketLowerBound(index + 1));
+        lastIndex = index;
+    }
+    BOOST_CHECK(CMetricHistogram::GetBucketIndex(UINT64_MAX) == CMetricHistogram::BUCKET_COUNT - 1);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_percentile_test)
+{
+    CMetricHistogram histogram;
+    for (uint64_t us = 1; us <= 10000; us++)
+        histogram.Record(us);
+
+    auto stat = histogram.GetStat();
+    BOOST_CHECK(stat.count == 10000);
+    BOOST_CHECK(stat.sum == 10000ULL * 10001 / 2);
+    BOOST_CHECK(stat.max == 10000);
+    // the relative error is bounded by the half width of the sub buckets
+    BOOST_CHECK(stat.p50 >= 5000 * 15 / 16 && stat.p50 <= 5000 * 17 / 16);
+    BOOST_CHECK(stat.p90 >= 9000 * 15 / 16 && stat.p90 <= 9000 * 17 / 16);
+    BOOST_CHECK(stat.p99 >= 9900 * 15 / 16 && stat.p99 <= 10000);
+
+    histogram.Reset();
+    BOOST_CHECK(histogram.GetStat().count == 0);
+}
+
+BOOST_AUTO_TEST_CASE(registry_test)
+{
+    const int32_t THREAD_COUNT = 4;
+    const int32_t LOOP_COUNT   = 100000;
+
+    vector<thread> threads;
+    for (int32_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&]() {
+            for (int32_t i = 0; i < LOOP_COUNT; i++) {
+                METRIC_COUNTER("metrics_tests_counter").Increase();
+                auto bm = MAKE_BENCHMARK("metrics_tests benchmark");
+            }
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    BOOST_CHECK(CMetricsRegistry::Instance().GetCounter("metrics_tests_counter").Get() ==
+                uint64_t(THREAD_COUNT * LOOP_COUNT));
+    BOOST_CHECK(CMetricsRegistry::Instance().GetHistogram("metrics_tests benchmark").GetStat().count ==
+                uint64_t(THREAD_COUNT * LOOP_COUNT));
+
+    string text = CMetricsRegistry::Instance().ToPrometheusText();
+    BOOST_CHECK(text.find("coin_metrics_tests_counter 400000\n") != string::npos);
+    BOOST_CHECK(text.find("coin_benchmark_duration_us_count{name=\"metrics_tests benchmark\"} 400000\n") !=
+                string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,48 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "commons/workerpool.h"
+
+#include <atomic>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static bool RunBatch(CWorkerPool &workerPool, size_t count) {
+    vector<atomic<uint32_t>> runs(count);
+    workerPool.Run(count, [&](size_t index) { runs[index]++; });
+    for (const auto &run : runs) {
+        if (run != 1)
+            return false;
+    }
+    return true;
+}
+
+BOOST_AUTO_TEST_SUITE(commons_workerpool_tests)
+
+BOOST_AUTO_TEST_CASE(workerpool_run_test)
+{
+    CWorkerPool workerPool;
+    BOOST_CHECK(RunBatch(workerPool, 100));
+
+    workerPool.Start("test", 4);
+    BOOST_CHECK(workerPool.GetThreadCount() == 4);
+    for (size_t count = 1; count <= 100; count++)
+        BOOST_CHECK(RunBatch(workerPool, count));
+}
+
+BOOST_AUTO_TEST_CASE(workerpool_restart_test)
+{
+    CWorkerPool workerPool;
+    for (uint32_t i = 0; i < 10; i++) {
+        workerPool.Start("test", 4);
+        BOOST_CHECK(RunBatch(workerPool, 100));
+        BOOST_CHECK(RunBatch(workerPool, 100));
+        workerPool.Stop();
+        BOOST_CHECK(workerPool.GetThreadCount() == 0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <boost/test/unit_test.hpp>
+#include "commons/random.h"
+#include "crypto/hash.h"
+#include "crypto/sha256.h"
+#include "tests/benchmark.h"
+#include "tx/coinminttx.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(crypto_sha256_tests)
+
+// build the block with txCount different txs
+static void MakeBlock(CBlock &block, int32_t txCount) {
+    block.vptx.clear();
+    for (int32_t i = 0; i < txCount; i++) {
+        block.vptx.push_back(std::make_shared<CCoinMintTx>(CRegID(i + 1, 1), i, SYMB::WICC, i * COIN));
+    }
+}
+
+// compute the merkle root by hashing the pairs one by one
+static uint256 ComputeMerkleRootSerially(vector<uint256> hashes) {
+    if (hashes.empty())
+        return uint256();
+
+    while (hashes.size() > 1) {
+        vector<uint256> parents;
+        for (size_t i = 0; i < hashes.size(); i += 2) {
+            const uint256 &left  = hashes[i];
+            const uint256 &right = hashes[min(i + 1, hashes.size() - 1)];
+            parents.push_back(Hash(BEGIN(left), END(left), BEGIN(right), END(right)));
+        }
+        hashes.swap(parents);
+    }
+    return hashes[0];
+}
+
+BOOST_AUTO_TEST_CASE(sha256d64_test)
+{
+    BOOST_TEST_MESSAGE("SHA256 implementation: " + SHA256AutoDetect());
+
+    for (int32_t blocks = 0; blocks <= 33; blocks++) {
+        vector<uint8_t> in(blocks * 64), out(blocks * 32);
+        if (blocks > 0)
+            GetRandBytes(in.data(), in.size());
+
+        SHA256D64(out.data(), in.data(), blocks);
+        for (int32_t i = 0; i < blocks; i++) {
+            uint256 expected = Hash(in.begin() + i * 64, in.begin() + (i + 1) * 64);
+            BOOST_CHECK(memcmp(out.data() + i * 32, expected.begin(), 32) == 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_root_test)
+{
+    SHA256AutoDetect();
+
+    CBlock block;
+    for (int32_t txCount = 0; txCount <= 40; txCount++) {
+        MakeBlock(block, txCount);
+        vector<uint256> txids;
+        for (const auto &ptx : block.vptx)
+            txids.push_back(ptx->GetHash());
+
+        uint256 root = block.BuildMerkleTree();
+        BOOST_CHECK(root == ComputeMerkleRootSerially(txids));
+
+        for (int32_t i = 0; i < txCount; i++) {
+            BOOST_CHECK(block.GetTxid(i) == txids[i]);
+            BOOST_CHECK(CBlock::CheckMerkleBranch(txids[i], block.GetMerkleBranch(i), i) == root);
+        }
+    }
+}
+
+BENCHMARK_TEST_CASE(merkle_root_benchmark)
+{
+    const int32_t TX_COUNT  = 4000;
+    const int32_t RUN_COUNT = 50;
+
+    CBlock block;
+    MakeBlock(block, TX_COUNT);
+    vector<uint256> txids;
+    for (const auto &ptx : block.vptx)
+        txids.push_back(ptx->GetHash());
+
+    int64_t beginTime = GetTimeMicros();
+    for (int32_t n = 0; n < RUN_COUNT; n++) {
+        for (const auto &ptx : block.vptx)
+            ptx->GetHash(true);
+    }
+    int64_t txHashTime = GetTimeMicros() - beginTime;
+
+    beginTime = GetTimeMicros();
+    uint256 serialRoot;
+    for (int32_t n = 0; n < RUN_COUNT; n++)
+        serialRoot = ComputeMerkleRootSerially(txids);
+    int64_t serialTime = GetTimeMicros() - beginTime;
+
+    string algo = SHA256AutoDetect();
+    beginTime = GetTimeMicros();
+    uint256 root;
+    for (int32_t n = 0; n < RUN_COUNT; n++)
+        root = block.BuildMerkleTree();
+    int64_t batchTime = GetTimeMicros() - beginTime;
+
+    BOOST_CHECK(root == serialRoot);
+    BOOST_TEST_MESSAGE(strprintf("hash %d txs %d times: %lldus (%.0f tx/s)", TX_COUNT, RUN_COUNT, txHashTime,
+                                 TX_COUNT * RUN_COUNT * 1000000.0 / max<int64_t>(txHashTime, 1)));
+    BOOST_TEST_MESSAGE(strprintf("merkle root of %d txs %d times: serial=%lldus, batched(%s)=%lldus", TX_COUNT,
+                                 RUN_COUNT, serialTime, algo, batchTime));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
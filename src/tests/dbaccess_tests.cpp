@@ -7,8 +7,12 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <boost/test/unit_test.hpp>
 #include "persistence/dbaccess.h"
+#include "tests/benchmark.h"
 
 using namespace std;
 
@@ -162,6 +166,55 @@ BOOST_AUTO_TEST_CASE(dbcache_scalar_value_Level3_test)
     BOOST_CHECK( value1 == "keyid-1" );
 }
 
+BOOST_AUTO_TEST_CASE(dbcache_dirty_flush_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->SetData("regid-2", "keyid-2");
+    pDBCache1->SetData("regid-3", "keyid-3");
+    BOOST_CHECK(pDBCache1->GetDirtyCount() == 3);
+    pDBCache1->Flush();
+    BOOST_CHECK(pDBAccess->GetFlushWrittenCount() == 3 && pDBAccess->GetFlushCleanCount() == 0);
+
+    // read 2 entries and modify 1 entry in child cache, only the modified one is merged to parent
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    string value;
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value));
+    BOOST_CHECK(pDBCache2->GetData(string("regid-2"), value));
+    BOOST_CHECK(pDBCache2->SetData("regid-3", "keyid-3-new"));
+    BOOST_CHECK(pDBCache2->EraseData("regid-4"));  // erase a not existed key is not a modification
+    BOOST_CHECK(pDBCache2->GetDirtyCount() == 1);
+    pDBCache2->Flush();
+    BOOST_CHECK(pDBCache1->GetMapData().size() == 3);
+    BOOST_CHECK(pDBCache1->GetDirtyCount() == 1);
+
+    pDBCache1->Flush();
+    BOOST_CHECK(pDBAccess->GetFlushWrittenCount() == 4 && pDBAccess->GetFlushCleanCount() == 2);
+    BOOST_CHECK(pDBCache2->GetData(string("regid-3"), value));
+    BOOST_CHECK(value == "keyid-3-new");
+
+    auto pScalarCache1 = make_shared< CSimpleKVCache<prefix, string> >(pDBAccess.get());
+    auto pScalarCache2 = make_shared< CSimpleKVCache<prefix, string> >(pScalarCache1.get());
+    pScalarCache2->SetData("keyid-1");
+    BOOST_CHECK(pScalarCache2->IsDirty());
+    pScalarCache2->Flush();
+    BOOST_CHECK(pScalarCache1->IsDirty());
+    pScalarCache1->Flush();
+    BOOST_CHECK(pDBAccess->GetFlushWrittenCount() == 5);
+
+    BOOST_CHECK(pScalarCache2->GetData(value) && value == "keyid-1");
+    BOOST_CHECK(!pScalarCache2->IsDirty());
+    pScalarCache2->Flush();
+    BOOST_CHECK(!pScalarCache1->IsDirty());
+    pScalarCache1->Flush();
+    BOOST_CHECK(pDBAccess->GetFlushWrittenCount() == 5 && pDBAccess->GetFlushCleanCount() == 3);
+}
+
 template <typename T>
 static uint32_t GetSerSize(const T &t) {
     return ::GetSerializeSize(t, SER_DISK, CLIENT_VERSION);
@@ -200,4 +253,281 @@ BOOST_AUTO_TEST_CASE(dbcache_cache_size_test)
     BOOST_CHECK(!pDBCache2->IsCalcSize() && pDBCache2->GetCacheSize() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(dbcache_read_cache_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe, CACHE_SIZE);
+    const auto &readCache = pDBAccess->GetReadCache();
+
+    auto pDBCache = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache->SetData("regid-1", "keyid-1");
+    pDBCache->SetData("regid-2", "keyid-2");
+    pDBCache->Flush();
+    // the flushed values are kept in read cache
+    BOOST_CHECK(readCache.GetCount() == 2);
+    BOOST_CHECK(readCache.GetHitCount() == 0 && readCache.GetMissCount() == 2);
+
+    string value;
+    BOOST_CHECK(pDBCache->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(readCache.GetHitCount() == 1 && readCache.GetMissCount() == 2);
+    pDBCache->Flush();
+    BOOST_CHECK(pDBCache->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(readCache.GetHitCount() == 2);
+    BOOST_CHECK(!pDBCache->GetData(string("regid-3"), value));
+    BOOST_CHECK(readCache.GetMissCount() == 3);
+
+    // the erased value is removed from read cache
+    BOOST_CHECK(pDBCache->EraseData("regid-2"));
+    pDBCache->Flush();
+    BOOST_CHECK(readCache.GetCount() == 1);
+    BOOST_CHECK(!pDBCache->GetData(string("regid-2"), value));
+
+    // the least recently used values are evicted when exceeding the max size
+    shared_ptr<CDBAccess> pDBAccess2 = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir / "small", CACHE_SIZE, false, isWipe, 512);
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess2.get());
+    for (int32_t i = 0; i < 10; i++) {
+        pDBCache2->SetData("regid-" + std::to_string(i), "keyid-" + std::to_string(i));
+    }
+    pDBCache2->Flush();
+    const auto &readCache2 = pDBAccess2->GetReadCache();
+    BOOST_CHECK(readCache2.GetSize() <= 512 && readCache2.GetCount() < 10);
+    BOOST_CHECK(readCache2.GetEvictedCount() == 10 - readCache2.GetCount());
+    BOOST_CHECK(pDBCache2->GetData(string("regid-0"), value) && value == "keyid-0");
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_single_db_commit_test)
+{
+    const bool isWipe = true;
+    auto pStateDb = make_shared<CLevelDBWrapper>(db_dir / "state", CACHE_SIZE, false, isWipe);
+    auto pAccountDb = make_shared<CDBAccess>(DBNameType::ACCOUNT, pStateDb);
+    auto pLogDb = make_shared<CDBAccess>(DBNameType::LOG, pStateDb);
+
+    auto pAccountCache = make_shared< CCompositeKVCache<dbk::REGID_KEYID, string, string> >(pAccountDb.get());
+    auto pLogCache = make_shared< CCompositeKVCache<dbk::TX_EXECUTE_FAIL, string, string> >(pLogDb.get());
+    pAccountCache->SetData("regid-1", "keyid-1");
+    pLogCache->SetData("regid-1", "fail-1");
+
+    // the writes are held in commit batch until it is written
+    CLevelDBBatch commitBatch;
+    pAccountDb->SetCommitBatch(&commitBatch);
+    pLogDb->SetCommitBatch(&commitBatch);
+    pAccountCache->Flush();
+    pLogCache->Flush();
+    pAccountDb->SetCommitBatch(nullptr);
+    pLogDb->SetCommitBatch(nullptr);
+
+    string value;
+    BOOST_CHECK(!pAccountDb->GetData(dbk::REGID_KEYID, string("regid-1"), value));
+    BOOST_CHECK(!pLogDb->GetData(dbk::TX_EXECUTE_FAIL, string("regid-1"), value));
+    pStateDb->WriteBatch(commitBatch, true);
+    BOOST_CHECK(pAccountDb->GetData(dbk::REGID_KEYID, string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pLogDb->GetData(dbk::TX_EXECUTE_FAIL, string("regid-1"), value) && value == "fail-1");
+
+    // the items of the same key in different db names are not overlapped
+    BOOST_CHECK(pAccountCache->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pLogCache->GetData(string("regid-1"), value) && value == "fail-1");
+}
+
+// compare the flush latency of writing the dbs one by one and writing one commit batch
+BENCHMARK_TEST_CASE(dbcache_single_db_flush_benchmark)
+{
+    const bool isWipe = true;
+    const int32_t DB_COUNT = 15;
+    const int32_t FLUSH_COUNT = 20;
+
+    vector<shared_ptr<CDBAccess>> multiDbs;
+    for (int32_t i = 0; i < DB_COUNT; i++) {
+        multiDbs.push_back(make_shared<CDBAccess>(DBNameType::ACCOUNT, db_dir / ("multi-" + std::to_string(i)),
+                                                  CACHE_SIZE, false, isWipe));
+    }
+    auto pStateDb = make_shared<CLevelDBWrapper>(db_dir / "single", CACHE_SIZE, false, isWipe);
+    vector<shared_ptr<CDBAccess>> singleDbs;
+    for (int32_t i = 0; i < DB_COUNT; i++) {
+        singleDbs.push_back(make_shared<CDBAccess>(DBNameType::ACCOUNT, pStateDb));
+    }
+
+    auto flushDbs = [&](vector<shared_ptr<CDBAccess>> &dbs, CLevelDBWrapper *pCommitDb) {
+        int64_t beginTime = GetTimeMicros();
+        for (int32_t n = 0; n < FLUSH_COUNT; n++) {
+            CLevelDBBatch commitBatch;
+            for (int32_t i = 0; i < DB_COUNT; i++) {
+                if (pCommitDb != nullptr) dbs[i]->SetCommitBatch(&commitBatch);
+                CCompositeKVCache<dbk::REGID_KEYID, string, string> cache(dbs[i].get());
+                cache.SetData(strprintf("regid-%d-%d", i, n), "keyid");
+                cache.Flush();
+                dbs[i]->SetCommitBatch(nullptr);
+            }
+            if (pCommitDb != nullptr) pCommitDb->WriteBatch(commitBatch, true);
+        }
+        return GetTimeMicros() - beginTime;
+    };
+
+    int64_t multiTime = flushDbs(multiDbs, nullptr);
+    int64_t singleTime = flushDbs(singleDbs, pStateDb.get());
+    BOOST_TEST_MESSAGE(strprintf("flush %d dbs %d times: multiple dbs=%lldus, single commit batch=%lldus",
+                                 DB_COUNT, FLUSH_COUNT, multiTime, singleTime));
+
+    string value;
+    BOOST_CHECK(singleDbs[0]->GetData(dbk::REGID_KEYID, strprintf("regid-%d-%d", DB_COUNT - 1, FLUSH_COUNT - 1), value));
+    BOOST_CHECK(value == "keyid");
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_snapshot_view_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe, CACHE_SIZE);
+
+    auto pTopCache = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pTopCache->SetData("regid-1", "keyid-1");
+    pTopCache->SetData("regid-2", "keyid-2");
+    pTopCache->SetData("regid-3", "keyid-3");
+    pTopCache->Flush();
+    auto pScalarCache = make_shared< CSimpleKVCache<prefix, string> >(pDBAccess.get());
+    pScalarCache->SetData("scalar-1");
+    pScalarCache->Flush();
+
+    // the changes not flushed yet are copied to the view, the others are read from db at snapshot
+    string value;
+    BOOST_CHECK(pTopCache->GetData(string("regid-1"), value));
+    BOOST_CHECK(pTopCache->SetData("regid-2", "keyid-2-new"));
+    BOOST_CHECK(pTopCache->EraseData("regid-3"));
+    BOOST_CHECK(pTopCache->SetData("regid-4", "keyid-4"));
+    BOOST_CHECK(pScalarCache->SetData("scalar-2"));
+
+    CDBAccess snapshotAccess(*pDBAccess, make_shared<CLevelDBSnapshot>(pDBAccess->GetDb()));
+    CCompositeKVCache<prefix, string, string> view(*pTopCache, &snapshotAccess);
+    CSimpleKVCache<prefix, string> scalarView(*pScalarCache, &snapshotAccess);
+    BOOST_CHECK(view.GetMapData().size() == 3);
+
+    // the later blocks are not seen by the view
+    pTopCache->Flush();
+    BOOST_CHECK(pTopCache->SetData("regid-1", "keyid-1-new"));
+    BOOST_CHECK(pTopCache->SetData("regid-5", "keyid-5"));
+    pTopCache->Flush();
+    pScalarCache->Flush();
+    BOOST_CHECK(pScalarCache->SetData("scalar-3"));
+    pScalarCache->Flush();
+
+    CCompositeKVCache<prefix, string, string> cache(&view);
+    BOOST_CHECK(cache.GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(cache.GetData(string("regid-2"), value) && value == "keyid-2-new");
+    BOOST_CHECK(!cache.GetData(string("regid-3"), value));
+    BOOST_CHECK(cache.GetData(string("regid-4"), value) && value == "keyid-4");
+    BOOST_CHECK(!cache.HasData(string("regid-5")));
+    CSimpleKVCache<prefix, string> scalarCache(&scalarView);
+    BOOST_CHECK(scalarCache.GetData(value) && value == "scalar-2");
+
+    // the reads do not change the shared view, the changes stay in the cache based on it
+    BOOST_CHECK(view.GetMapData().size() == 3);
+    BOOST_CHECK(cache.SetData("regid-6", "keyid-6"));
+    BOOST_CHECK(view.GetMapData().size() == 3);
+
+    // the snapshot of the current db sees the latest blocks
+    CDBAccess latestAccess(*pDBAccess, make_shared<CLevelDBSnapshot>(pDBAccess->GetDb()));
+    CCompositeKVCache<prefix, string, string> latestView(*pTopCache, &latestAccess);
+    CSimpleKVCache<prefix, string> latestScalarView(*pScalarCache, &latestAccess);
+    BOOST_CHECK(latestView.GetMapData().empty());
+    CCompositeKVCache<prefix, string, string> latestCache(&latestView);
+    BOOST_CHECK(latestCache.GetData(string("regid-1"), value) && value == "keyid-1-new");
+    BOOST_CHECK(latestCache.GetData(string("regid-5"), value) && value == "keyid-5");
+    CSimpleKVCache<prefix, string> latestScalarCache(&latestScalarView);
+    BOOST_CHECK(latestScalarCache.GetData(value) && value == "scalar-3");
+}
+
+// the query rate of the readers while the blocks are connected, the readers share the lock with the block
+// connecting as the queries taking cs_main, or read the view of the last block without the lock
+BENCHMARK_TEST_CASE(dbcache_snapshot_view_benchmark)
+{
+    typedef CCompositeKVCache<dbk::REGID_KEYID, string, string> CacheType;
+    const bool isWipe = true;
+    const int32_t KEY_COUNT = 10000;
+    const int32_t BLOCK_KEY_COUNT = 500;
+    const int32_t READER_COUNT = 4;
+    const int64_t DURATION = 1000;  // in milliseconds
+
+    auto pDBAccess = make_shared<CDBAccess>(DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe, CACHE_SIZE);
+    CacheType topCache(pDBAccess.get());
+    for (int32_t i = 0; i < KEY_COUNT; i++)
+        topCache.SetData(strprintf("regid-%d", i), "keyid");
+    topCache.Flush();
+
+    auto run = [&](bool useView) {
+        std::mutex mainMutex;  // cs_main
+        std::mutex viewMutex;
+        shared_ptr<CDBAccess> pViewAccess;
+        shared_ptr<CacheType> pView;
+        auto newView = [&]() {
+            auto pAccess = make_shared<CDBAccess>(*pDBAccess, make_shared<CLevelDBSnapshot>(pDBAccess->GetDb()));
+            auto pNewView = make_shared<CacheType>(topCache, pAccess.get());
+            std::lock_guard<std::mutex> lock(viewMutex);
+            pViewAccess = pAccess;
+            pView = pNewView;
+        };
+        newView();
+
+        std::atomic<bool> stopped(false);
+        std::atomic<int64_t> queryCount(0);
+        std::atomic<int64_t> blockCount(0);
+        std::atomic<int64_t> missCount(0);  // Boost.Test checks are not thread safe
+        vector<std::thread> threads;
+        for (int32_t n = 0; n < READER_COUNT; n++) {
+            threads.emplace_back([&, n]() {
+                string value;
+                for (int64_t i = n; !stopped; i++) {
+                    string key = strprintf("regid-%d", (i * 7919) % KEY_COUNT);
+                    if (useView) {
+                        shared_ptr<CDBAccess> pAccess;
+                        shared_ptr<CacheType> pCurView;
+                        {
+                            std::lock_guard<std::mutex> lock(viewMutex);
+                            pAccess  = pViewAccess;
+                            pCurView = pView;
+                        }
+                        CacheType cache(pCurView.get());
+                        if (!cache.GetData(key, value))
+                            missCount++;
+                    } else {
+                        std::lock_guard<std::mutex> lock(mainMutex);
+                        CacheType cache(&topCache);
+                        if (!cache.GetData(key, value))
+                            missCount++;
+                    }
+                    queryCount++;
+                }
+            });
+        }
+
+        int64_t beginTime = GetTimeMillis();
+        while (GetTimeMillis() < beginTime + DURATION) {
+            std::lock_guard<std::mutex> lock(mainMutex);
+            CacheType cache(&topCache);
+            for (int32_t i = 0; i < BLOCK_KEY_COUNT; i++)
+                cache.SetData(strprintf("regid-%d", (blockCount * BLOCK_KEY_COUNT + i) % KEY_COUNT), "keyid-new");
+            cache.Flush();
+            topCache.Flush();
+            blockCount++;
+            if (useView)
+                newView();
+        }
+        stopped = true;
+        for (auto &thread : threads)
+            thread.join();
+
+        BOOST_CHECK(missCount == 0);
+        int64_t elapsed = GetTimeMillis() - beginTime;
+        return make_pair(queryCount * 1000 / elapsed, blockCount * 1000 / elapsed);
+    };
+
+    auto locked = run(false);
+    auto viewed = run(true);
+    BOOST_TEST_MESSAGE(strprintf("%d readers, queries/s (blocks/s): with lock=%lld (%lld), with view=%lld (%lld)",
+                                 READER_COUNT, locked.first, locked.second, viewed.first, viewed.second));
+    BOOST_CHECK(viewed.first > 0 && viewed.second > 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
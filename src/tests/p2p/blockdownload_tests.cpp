@@ -0,0 +1,257 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "p2p/blockdownload.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include "commons/tinyformat.h"
+#include "tests/benchmark.h"
+
+using namespace std;
+
+static vector<shared_ptr<CBlock>> MakeChain(int32_t count, uint256 &genesisHash) {
+    CBlock genesis;
+    genesis.SetHeight(0);
+    genesisHash = genesis.GetHash();
+
+    vector<shared_ptr<CBlock>> blocks;
+    uint256 prevHash = genesisHash;
+    for (int32_t height = 1; height <= count; height++) {
+        auto pBlock = make_shared<CBlock>();
+        pBlock->SetHeight(height);
+        pBlock->SetPrevBlockHash(prevHash);
+        prevHash = pBlock->GetHash();
+        blocks.push_back(pBlock);
+    }
+    return blocks;
+}
+
+static vector<uint256> GetHashes(const vector<shared_ptr<CBlock>> &blocks, size_t begin, size_t end) {
+    vector<uint256> hashes;
+    for (size_t i = begin; i < min(end, blocks.size()); i++)
+        hashes.push_back(blocks[i]->GetHash());
+    return hashes;
+}
+
+// simulate the initial sync from the peers serving the blocks over links of the same latency and bandwidth, the
+// stalled peers never answer, return the simulated seconds to process all of the blocks
+static double SimulateSync(const vector<shared_ptr<CBlock>> &blocks, const uint256 &genesisHash, int32_t peerCount,
+                           int32_t stalledCount) {
+    const int64_t RTT           = 100000;  // 100ms
+    const int64_t TRANSFER_TIME = 2000;    // 2ms per block
+    const int64_t TICK          = 100000;
+
+    CBlockDownloadScheduler scheduler;
+    scheduler.Reset(0, genesisHash);
+
+    map<uint256, shared_ptr<CBlock>> mapBlocks;
+    for (const auto &pBlock : blocks)
+        mapBlocks[pBlock->GetHash()] = pBlock;
+
+    vector<int64_t> linkFreeTimes(peerCount, 0);
+    multimap<int64_t, pair<NodeId, shared_ptr<CBlock>>> arrivals;
+    int64_t now = 0, hashesArrival = RTT;
+    size_t hashesSent = 0;
+    int32_t processedHeight = 0;
+    set<NodeId> disconnected;
+    scheduler.SetHashesRequested(0, now);  // the first peer is the sync peer
+
+    while (processedHeight < (int32_t)blocks.size()) {
+        if (hashesArrival >= 0 && hashesArrival <= now) {
+            hashesSent += MAX_HEADERS_RESULTS;
+            scheduler.AddHashes(GetHashes(blocks, hashesSent - MAX_HEADERS_RESULTS, hashesSent),
+                                hashesSent >= blocks.size());
+            hashesArrival = -1;
+        }
+        while (!arrivals.empty() && arrivals.begin()->first <= now) {
+            const auto &arrival = arrivals.begin()->second;
+            BOOST_REQUIRE(scheduler.ReceivedBlock(arrival.second, arrival.first));
+            arrivals.erase(arrivals.begin());
+        }
+        for (const auto &pBlock : scheduler.PopReadyBlocks())
+            BOOST_REQUIRE((int32_t)pBlock->GetHeight() == ++processedHeight);
+
+        if (hashesArrival < 0 && scheduler.NeedMoreHashes(now)) {
+            scheduler.SetHashesRequested(0, now);
+            hashesArrival = now + RTT;
+        }
+        // the stalling peers are disconnected after the grace period
+        scheduler.CheckStalledWindows(now, BLOCK_DOWNLOAD_WINDOW_TIMEOUT * 1000000);
+        for (int32_t id = 0; id < peerCount; id++) {
+            if (!disconnected.count(id) && scheduler.IsStallingNode(id, now)) {
+                BOOST_REQUIRE(id >= peerCount - stalledCount);
+                disconnected.insert(id);
+                scheduler.RemovePeer(id);
+            }
+        }
+        for (int32_t id = 0; id < peerCount; id++) {
+            if (disconnected.count(id))
+                continue;
+            for (const auto &hash : scheduler.GetBlocksToRequest(id, blocks.size(), MAX_BLOCKS_IN_TRANSIT_PER_PEER, now)) {
+                if (id >= peerCount - stalledCount)
+                    continue;
+                int64_t sendTime  = max(now + RTT / 2, linkFreeTimes[id]) + TRANSFER_TIME;
+                linkFreeTimes[id] = sendTime;
+                arrivals.emplace(sendTime + RTT / 2, make_pair(id, mapBlocks[hash]));
+            }
+        }
+
+        int64_t next = now + TICK;
+        if (!arrivals.empty())
+            next = min(next, arrivals.begin()->first);
+        if (hashesArrival >= 0)
+            next = min(next, hashesArrival);
+        now = max(next, now + 1);
+    }
+    BOOST_CHECK(!scheduler.IsActive());
+    return now / 1000000.0;
+}
+
+BOOST_AUTO_TEST_SUITE(blockdownload_tests)
+
+BOOST_AUTO_TEST_CASE(window_assignment_test)
+{
+    uint256 genesisHash;
+    auto blocks = MakeChain(520, genesisHash);
+
+    CBlockDownloadScheduler scheduler;
+    scheduler.Reset(0, genesisHash);
+    scheduler.AddHashes(GetHashes(blocks, 0, 500), false);
+    BOOST_CHECK(scheduler.IsScheduled(blocks[0]->GetHash()));
+
+    // the windows are aligned by height, the first one starts from the tip
+    BOOST_CHECK(scheduler.GetBlocksToRequest(1, 1000, 1000, 0) == GetHashes(blocks, 0, 63));
+    BOOST_CHECK(scheduler.GetInFlightCount(1) == 63);
+    // the windows beyond the peer are skipped
+    BOOST_CHECK(scheduler.GetBlocksToRequest(2, 79, 1000, 0) == GetHashes(blocks, 63, 79));
+    BOOST_CHECK(scheduler.GetBlocksToRequest(3, 1000, 1000, 0) == GetHashes(blocks, 79, 143));
+
+    // the partial window waits for the rest hashes
+    size_t requested = 63 + 16 + 64;
+    for (NodeId id = 4; id < 20; id++)
+        requested += scheduler.GetBlocksToRequest(id, 1000, 1000, 0).size();
+    BOOST_CHECK(requested == 495);
+
+    // a short response has the last hashes
+    scheduler.AddHashes(GetHashes(blocks, 500, blocks.size()), true);
+    BOOST_CHECK(scheduler.GetBlocksToRequest(20, 1000, 1000, 0) == GetHashes(blocks, 495, 520));
+    BOOST_CHECK(!scheduler.NeedMoreHashes(0));
+
+    // the blocks are processed in height order whatever order they arrive in
+    for (size_t i = blocks.size() - 1; i >= 63; i--)
+        BOOST_CHECK(scheduler.ReceivedBlock(blocks[i], 2));
+    BOOST_CHECK(scheduler.PopReadyBlocks().empty());
+    for (size_t i = 0; i < 63; i++)
+        BOOST_CHECK(scheduler.ReceivedBlock(blocks[i], 1));
+    auto readyBlocks = scheduler.PopReadyBlocks();
+    BOOST_REQUIRE(readyBlocks.size() == blocks.size());
+    for (size_t i = 0; i < readyBlocks.size(); i++)
+        BOOST_CHECK(readyBlocks[i] == blocks[i]);
+
+    // the blocks are charged to the peers delivering them
+    BOOST_CHECK(scheduler.GetInFlightCount(1) == 0 && scheduler.GetInFlightCount(2) == 0);
+    BOOST_CHECK(scheduler.GetInFlightCount(3) == 64);
+    BOOST_CHECK(scheduler.GetNextHeight() == 521);
+    BOOST_CHECK(!scheduler.IsActive());
+}
+
+BOOST_AUTO_TEST_CASE(stalled_window_test)
+{
+    uint256 genesisHash;
+    auto blocks = MakeChain(31, genesisHash);
+
+    CBlockDownloadScheduler scheduler;
+    scheduler.Reset(0, genesisHash);
+    scheduler.AddHashes(GetHashes(blocks, 0, blocks.size()), true);
+    BOOST_CHECK(scheduler.GetBlocksToRequest(1, 31, 16, 0).size() == 15);
+    BOOST_CHECK(scheduler.GetBlocksToRequest(2, 31, 16, 0).size() == 16);
+    BOOST_CHECK(scheduler.ReceivedBlock(blocks[15], 2));
+
+    int64_t timeout = BLOCK_DOWNLOAD_WINDOW_TIMEOUT * 1000000;
+    int64_t grace   = BLOCK_DOWNLOAD_STALL_GRACE * 1000000;
+    BOOST_CHECK(scheduler.CheckStalledWindows(timeout - 1, timeout).empty());
+    BOOST_CHECK(scheduler.CheckStalledWindows(timeout, timeout).size() == 2);
+    // the blocks requested stay in flight from the stalling peers
+    BOOST_CHECK(scheduler.GetInFlightCount(1) == 15 && scheduler.GetInFlightCount(2) == 15);
+    BOOST_CHECK(!scheduler.IsStallingNode(1, timeout + grace - 1));
+
+    // a window is not reassigned to the peer stalling it
+    BOOST_CHECK(scheduler.GetBlocksToRequest(1, 31, 64, timeout) == GetHashes(blocks, 16, 31));
+    BOOST_CHECK(scheduler.GetBlocksToRequest(2, 31, 64, timeout) == GetHashes(blocks, 0, 15));
+
+    // a late block is charged to the stalling peer delivering it rather than to the new owner of the window, and
+    // the peer is not disconnected any more
+    BOOST_CHECK(scheduler.ReceivedBlock(blocks[0], 1));
+    BOOST_CHECK(scheduler.GetInFlightCount(1) == 29 && scheduler.GetInFlightCount(2) == 30);
+    BOOST_CHECK(!scheduler.IsStallingNode(1, timeout + grace));
+    BOOST_CHECK(scheduler.IsStallingNode(2, timeout + grace));
+
+    // the windows of a disconnected peer are reassigned at once
+    scheduler.RemovePeer(2);
+    BOOST_CHECK(!scheduler.IsStallingNode(2, timeout + grace));
+    BOOST_CHECK(scheduler.GetBlocksToRequest(3, 31, 64, timeout) == GetHashes(blocks, 1, 15));
+}
+
+BOOST_AUTO_TEST_CASE(appended_hashes_test)
+{
+    uint256 genesisHash;
+    auto blocks = MakeChain(20, genesisHash);
+
+    CBlockDownloadScheduler scheduler;
+    scheduler.Reset(0, genesisHash);
+    scheduler.AddHashes(GetHashes(blocks, 0, 10), true);
+    BOOST_CHECK(scheduler.GetBlocksToRequest(1, 20, 64, 0) == GetHashes(blocks, 0, 10));
+    for (size_t i = 0; i < 10; i++)
+        BOOST_CHECK(scheduler.ReceivedBlock(blocks[i], 1));
+    BOOST_CHECK(scheduler.PopReadyBlocks().size() == 10);
+
+    // the headers of the new blocks fill the rest of the partial window done already
+    scheduler.AddHashes(GetHashes(blocks, 10, blocks.size()), true);
+    BOOST_CHECK(scheduler.GetBlocksToRequest(2, 20, 64, 0) == GetHashes(blocks, 10, 20));
+    BOOST_CHECK(scheduler.GetInFlightCount(1) == 0 && scheduler.GetInFlightCount(2) == 10);
+}
+
+BOOST_AUTO_TEST_CASE(unexpected_block_test)
+{
+    uint256 genesisHash;
+    auto blocks = MakeChain(16, genesisHash);
+
+    CBlockDownloadScheduler scheduler;
+    scheduler.Reset(0, genesisHash);
+    scheduler.SetHashesRequested(1, 0);
+    BOOST_CHECK(scheduler.IsHashesRequestedFrom(1));
+    // the peer announced the blocks from another height
+    scheduler.AddHashes(GetHashes(blocks, 1, blocks.size()), true);
+    BOOST_CHECK(!scheduler.IsHashesRequestedFrom(1));
+    BOOST_CHECK(!scheduler.ReceivedBlock(blocks[1], 1));
+    BOOST_CHECK(!scheduler.IsActive());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_sync_test)
+{
+    uint256 genesisHash;
+    auto blocks = MakeChain(1000, genesisHash);
+
+    double singlePeerTime = SimulateSync(blocks, genesisHash, 1, 0);
+    BOOST_CHECK(SimulateSync(blocks, genesisHash, 8, 0) * 3 < singlePeerTime);
+    // the sync goes on without the stalling peer
+    BOOST_CHECK(SimulateSync(blocks, genesisHash, 8, 1) > 0);
+}
+
+BENCHMARK_TEST_CASE(sync_throughput_benchmark)
+{
+    uint256 genesisHash;
+    auto blocks = MakeChain(4000, genesisHash);
+
+    double singlePeerTime = SimulateSync(blocks, genesisHash, 1, 0);
+    double multiPeerTime  = SimulateSync(blocks, genesisHash, 8, 0);
+    double stalledTime    = SimulateSync(blocks, genesisHash, 8, 1);
+    BOOST_TEST_MESSAGE(strprintf("sync %u blocks: 1 peer %.1fs (%.0f blocks/s), 8 peers %.1fs (%.0f blocks/s), "
+                                 "8 peers with 1 stalled %.1fs (%.0f blocks/s)", blocks.size(), singlePeerTime,
+                                 blocks.size() / singlePeerTime, multiPeerTime, blocks.size() / multiPeerTime,
+                                 stalledTime, blocks.size() / stalledTime));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
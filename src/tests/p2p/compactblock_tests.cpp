@@ -0,0 +1,129 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "p2p/compactblock.h"
+
+#include <boost/test/unit_test.hpp>
+#include "commons/util/time.h"
+#include "config/version.h"
+#include "tests/benchmark.h"
+#include "tx/blockrewardtx.h"
+#include "tx/coinminttx.h"
+
+using namespace std;
+
+static const int32_t BLOCK_TX_COUNT = 1000;
+
+// a block of a reward tx and the mint txs, whose txs are in the mempool too
+static CBlock MakeBlock(map<uint256, CTxMemPoolEntry> &memPoolTxs) {
+    CBlock block;
+    block.SetHeight(100);
+    block.vptx.push_back(std::make_shared<CUCoinBlockRewardTx>(CRegID(1, 1), map<TokenSymbol, uint64_t>(), 100));
+    for (int32_t i = 0; i < BLOCK_TX_COUNT; i++) {
+        CCoinMintTx tx(CRegID(i + 1, 1), i, SYMB::WICC, i * COIN);
+        memPoolTxs.emplace(tx.GetHash(), CTxMemPoolEntry(&tx, GetTime(), 1));
+        block.vptx.push_back(tx.GetNewInstance());
+    }
+    block.SetMerkleRootHash(block.BuildMerkleTree());
+    return block;
+}
+
+static CCompactBlock RoundTrip(const CCompactBlock &cmpctBlock, size_t &size) {
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << cmpctBlock;
+    size = ss.size();
+
+    CCompactBlock received;
+    ss >> received;
+    return received;
+}
+
+BOOST_AUTO_TEST_SUITE(compactblock_tests)
+
+BOOST_AUTO_TEST_CASE(rebuild_from_mempool_test)
+{
+    map<uint256, CTxMemPoolEntry> memPoolTxs;
+    CBlock block = MakeBlock(memPoolTxs);
+    size_t fullSize = ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION);
+
+    size_t compactSize;
+    CCompactBlock cmpctBlock = RoundTrip(CCompactBlock(block), compactSize);
+    BOOST_CHECK(cmpctBlock.prefilledTxs.size() == 1 && cmpctBlock.prefilledTxs[0].index == 0);
+    BOOST_CHECK(cmpctBlock.shortTxIds.size() == BLOCK_TX_COUNT);
+    BOOST_CHECK(compactSize * 5 < fullSize);
+
+    CPartialBlock partialBlock;
+    BOOST_CHECK(partialBlock.Init(cmpctBlock, memPoolTxs) == CPartialBlock::READ_OK);
+    BOOST_CHECK(partialBlock.GetMissingIndexes().empty());
+    BOOST_CHECK(partialBlock.GetMempoolTxCount() == BLOCK_TX_COUNT);
+
+    CBlock rebuilt;
+    BOOST_CHECK(partialBlock.FillBlock(rebuilt, {}) == CPartialBlock::READ_OK);
+    BOOST_CHECK(rebuilt.GetHash() == block.GetHash());
+}
+
+BENCHMARK_TEST_CASE(rebuild_benchmark)
+{
+    const int32_t REBUILD_COUNT = 100;
+
+    map<uint256, CTxMemPoolEntry> memPoolTxs;
+    CBlock block = MakeBlock(memPoolTxs);
+    size_t fullSize = ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION);
+
+    size_t compactSize;
+    CCompactBlock cmpctBlock = RoundTrip(CCompactBlock(block), compactSize);
+
+    int64_t beginTime = GetTimeMicros();
+    for (int32_t i = 0; i < REBUILD_COUNT; i++) {
+        CPartialBlock partialBlock;
+        CBlock rebuilt;
+        BOOST_REQUIRE(partialBlock.Init(cmpctBlock, memPoolTxs) == CPartialBlock::READ_OK);
+        BOOST_REQUIRE(partialBlock.FillBlock(rebuilt, {}) == CPartialBlock::READ_OK);
+    }
+    BOOST_TEST_MESSAGE("block of " << block.vptx.size() << " txs: full " << fullSize << " bytes, compact "
+                                   << compactSize << " bytes, rebuilt in "
+                                   << (GetTimeMicros() - beginTime) / REBUILD_COUNT << "us");
+}
+
+BOOST_AUTO_TEST_CASE(missing_txs_test)
+{
+    map<uint256, CTxMemPoolEntry> memPoolTxs;
+    CBlock block = MakeBlock(memPoolTxs);
+    memPoolTxs.erase(block.vptx[3]->GetHash());
+    memPoolTxs.erase(block.vptx[500]->GetHash());
+
+    CPartialBlock partialBlock;
+    BOOST_CHECK(partialBlock.Init(CCompactBlock(block), memPoolTxs) == CPartialBlock::READ_OK);
+    vector<uint32_t> missingIndexes = partialBlock.GetMissingIndexes();
+    BOOST_CHECK(missingIndexes == vector<uint32_t>({3, 500}));
+
+    // the peer must send all of the missing txs
+    CBlock rebuilt;
+    BOOST_CHECK(partialBlock.FillBlock(rebuilt, {block.vptx[3]}) == CPartialBlock::READ_INVALID);
+    // the wrong txs break the merkle root
+    BOOST_CHECK(partialBlock.FillBlock(rebuilt, {block.vptx[500], block.vptx[3]}) == CPartialBlock::READ_FAILED);
+    BOOST_CHECK(partialBlock.FillBlock(rebuilt, {block.vptx[3], block.vptx[500]}) == CPartialBlock::READ_OK);
+    BOOST_CHECK(rebuilt.GetHash() == block.GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(invalid_compact_block_test)
+{
+    map<uint256, CTxMemPoolEntry> memPoolTxs;
+    CBlock block = MakeBlock(memPoolTxs);
+    CPartialBlock partialBlock;
+
+    CCompactBlock emptyBlock;
+    BOOST_CHECK(partialBlock.Init(emptyBlock, memPoolTxs) == CPartialBlock::READ_INVALID);
+
+    CCompactBlock outOfRange(block);
+    outOfRange.prefilledTxs[0].index = block.vptx.size();
+    BOOST_CHECK(partialBlock.Init(outOfRange, memPoolTxs) == CPartialBlock::READ_INVALID);
+
+    // the duplicate short ids can not be told apart, the full block is requested
+    CCompactBlock duplicated(block);
+    duplicated.shortTxIds[1] = duplicated.shortTxIds[0];
+    BOOST_CHECK(partialBlock.Init(duplicated, memPoolTxs) == CPartialBlock::READ_FAILED);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
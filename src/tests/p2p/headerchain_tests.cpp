@@ -0,0 +1,107 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "p2p/headerchain.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+// add the headers of a branch from the parent header, or from the stored block if pPrev is nullptr
+static vector<CHeaderIndex *> AddBranch(CHeaderChain &chain, CHeaderIndex *pPrev, const uint256 &rootHash,
+                                        int32_t rootHeight, int32_t count, uint32_t nonce) {
+    vector<CHeaderIndex *> branch;
+    uint256 prevHash = pPrev ? pPrev->hash : rootHash;
+    int32_t height   = pPrev ? pPrev->height : rootHeight;
+    for (int32_t i = 0; i < count; i++) {
+        CBlockHeader header;
+        header.SetHeight(++height);
+        header.SetPrevBlockHash(prevHash);
+        header.SetNonce(nonce);
+        pPrev    = chain.Add(header, pPrev);
+        prevHash = pPrev->hash;
+        branch.push_back(pPrev);
+    }
+    return branch;
+}
+
+static vector<uint256> GetHashes(const vector<CHeaderIndex *> &branch, size_t begin, size_t end) {
+    vector<uint256> hashes;
+    for (size_t i = begin; i < end; i++)
+        hashes.push_back(branch[i]->hash);
+    return hashes;
+}
+
+BOOST_AUTO_TEST_SUITE(headerchain_tests)
+
+BOOST_AUTO_TEST_CASE(best_header_test)
+{
+    CBlockHeader genesis;
+    genesis.SetHeight(0);
+    uint256 genesisHash = genesis.GetHash();
+
+    CHeaderChain chain;
+    BOOST_CHECK(chain.GetBest() == nullptr);
+    auto mainBranch = AddBranch(chain, nullptr, genesisHash, 0, 5, 0);
+    BOOST_CHECK(chain.GetBest() == mainBranch.back());
+    BOOST_CHECK(chain.Find(mainBranch[2]->hash) == mainBranch[2]);
+    // the known headers are not added again
+    BOOST_CHECK(chain.Add(mainBranch[0]->header, nullptr) == mainBranch[0]);
+    BOOST_CHECK(chain.Size() == 5);
+
+    // a shorter fork does not change the best header, the first header received at a height wins
+    auto forkBranch = AddBranch(chain, mainBranch[1], genesisHash, 0, 3, 1);
+    BOOST_CHECK(forkBranch.back()->height == 5);
+    BOOST_CHECK(chain.GetBest() == mainBranch.back());
+
+    // a longer fork does
+    auto forkTip = AddBranch(chain, forkBranch.back(), genesisHash, 0, 1, 1);
+    BOOST_CHECK(chain.GetBest() == forkTip.back());
+    BOOST_CHECK(chain.GetBranchRoot(forkTip.back()) == genesisHash);
+
+    vector<uint256> hashes;
+    BOOST_CHECK(chain.GetPath(forkTip.back(), genesisHash, hashes));
+    vector<uint256> expected = GetHashes(mainBranch, 0, 2);
+    for (auto pIndex : forkBranch)
+        expected.push_back(pIndex->hash);
+    expected.push_back(forkTip.back()->hash);
+    BOOST_CHECK(hashes == expected);
+
+    BOOST_CHECK(chain.GetPath(mainBranch.back(), mainBranch[1]->hash, hashes));
+    BOOST_CHECK(hashes == GetHashes(mainBranch, 2, 5));
+    BOOST_CHECK(chain.GetPath(mainBranch.back(), mainBranch.back()->hash, hashes) && hashes.empty());
+    // the blocks of another branch are not on the path
+    BOOST_CHECK(!chain.GetPath(forkTip.back(), mainBranch[2]->hash, hashes));
+}
+
+BOOST_AUTO_TEST_CASE(prune_test)
+{
+    CBlockHeader genesis;
+    genesis.SetHeight(0);
+    uint256 genesisHash = genesis.GetHash();
+
+    CHeaderChain chain;
+    auto mainBranch = AddBranch(chain, nullptr, genesisHash, 0, 6, 0);
+    AddBranch(chain, mainBranch[0], genesisHash, 0, 2, 1);
+    uint256 storedHash       = mainBranch[1]->hash;
+    vector<uint256> expected = GetHashes(mainBranch, 2, 6);
+
+    // the blocks up to height 2 are stored, the branches start from them
+    chain.Prune(2);
+    BOOST_CHECK(chain.Size() == 5);
+    BOOST_CHECK(chain.Find(storedHash) == nullptr);
+    BOOST_CHECK(chain.GetBest() == mainBranch.back());
+    BOOST_CHECK(chain.GetBranchRoot(mainBranch.back()) == storedHash);
+
+    vector<uint256> hashes;
+    BOOST_CHECK(chain.GetPath(mainBranch.back(), storedHash, hashes));
+    BOOST_CHECK(hashes == expected);
+
+    // the best header is stored too
+    chain.Prune(6);
+    BOOST_CHECK(chain.Size() == 0);
+    BOOST_CHECK(chain.GetBest() == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "p2p/socketevents.h"
+
+#include <boost/test/unit_test.hpp>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "commons/tinyformat.h"
+#include "tests/benchmark.h"
+
+using namespace std;
+
+static const int32_t MSG_SIZE = 32;
+
+// loopback peers, the server side sockets are watched by the socket events
+struct FLoopbackPeers {
+    explicit FLoopbackPeers(int32_t peerCount) {
+        SOCKET hListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        BOOST_REQUIRE(hListenSocket != INVALID_SOCKET);
+
+        struct sockaddr_in addr = {};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len        = sizeof(addr);
+        BOOST_REQUIRE(::bind(hListenSocket, (struct sockaddr *)&addr, len) == 0);
+        BOOST_REQUIRE(listen(hListenSocket, peerCount) == 0);
+        BOOST_REQUIRE(getsockname(hListenSocket, (struct sockaddr *)&addr, &len) == 0);
+
+        for (int32_t i = 0; i < peerCount; i++) {
+            SOCKET hClient = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            BOOST_REQUIRE(connect(hClient, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+            SOCKET hServer = accept(hListenSocket, nullptr, nullptr);
+            BOOST_REQUIRE(hServer != INVALID_SOCKET);
+            fcntl(hServer, F_SETFL, fcntl(hServer, F_GETFL, 0) | O_NONBLOCK);
+            clients.push_back(hClient);
+            servers.push_back(hServer);
+        }
+        close(hListenSocket);
+    }
+
+    ~FLoopbackPeers() {
+        for (auto hSocket : clients)
+            close(hSocket);
+        for (auto hSocket : servers)
+            close(hSocket);
+    }
+
+    vector<SOCKET> clients;
+    vector<SOCKET> servers;
+};
+
+static int64_t GetCpuTimeMicros() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL + usage.ru_utime.tv_usec +
+           usage.ru_stime.tv_usec;
+}
+
+// send msgCount messages by the first activeCount peers in turn and receive them as the socket handler does,
+// return the cpu time per message in us
+static double RunMessages(CSocketEvents &events, FLoopbackPeers &peers, int32_t activeCount, int32_t msgCount) {
+    bool fEdgeTriggered = events.IsEdgeTriggered();
+    for (auto hSocket : peers.servers)
+        BOOST_REQUIRE(events.AddSocket(hSocket, false));
+
+    unordered_set<SOCKET> setHasData;
+    char msg[MSG_SIZE] = {};
+    char buf[0x10000];
+    int64_t totalBytes = 0;
+    int64_t beginTime  = GetCpuTimeMicros();
+    for (int32_t n = 0; n < msgCount; n++) {
+        BOOST_REQUIRE(send(peers.clients[n % activeCount], msg, MSG_SIZE, 0) == MSG_SIZE);
+
+        int64_t expectedBytes = int64_t(n + 1) * MSG_SIZE;
+        while (totalBytes < expectedBytes) {
+            unordered_set<SOCKET> recvReady, sendReady;
+            BOOST_REQUIRE(events.Wait(setHasData.empty() ? 50 : 0, peers.servers, {}, recvReady, sendReady));
+            if (!fEdgeTriggered)
+                setHasData.clear();
+            setHasData.insert(recvReady.begin(), recvReady.end());
+
+            for (auto it = setHasData.begin(); it != setHasData.end();) {
+                int32_t nBytes = recv(*it, buf, sizeof(buf), MSG_DONTWAIT);
+                if (nBytes > 0)
+                    totalBytes += nBytes;
+                if (nBytes < (int32_t)sizeof(buf))
+                    it = setHasData.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+    BOOST_CHECK(totalBytes == int64_t(msgCount) * MSG_SIZE);
+    return double(GetCpuTimeMicros() - beginTime) / msgCount;
+}
+
+static vector<string> GetModes() {
+    vector<string> modes = {"select"};
+#ifdef HAVE_SYS_EPOLL_H
+    modes.push_back("epoll");
+#endif
+    return modes;
+}
+
+BOOST_AUTO_TEST_SUITE(socketevents_tests)
+
+BOOST_AUTO_TEST_CASE(socket_events_mode_test)
+{
+    BOOST_CHECK(MakeSocketEvents("select") != nullptr);
+    BOOST_CHECK(MakeSocketEvents("unknown") == nullptr);
+    BOOST_CHECK(MakeSocketEvents(DEFAULT_SOCKET_EVENTS) != nullptr);
+#ifdef HAVE_SYS_EPOLL_H
+    BOOST_CHECK(MakeSocketEvents("epoll")->IsEdgeTriggered());
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(socket_events_recv_test)
+{
+    const int32_t PEER_COUNT = 16;
+
+    for (const auto &mode : GetModes()) {
+        for (int32_t activeCount : {1, PEER_COUNT}) {
+            FLoopbackPeers peers(PEER_COUNT);
+            RunMessages(*MakeSocketEvents(mode), peers, activeCount, 200);
+        }
+    }
+}
+
+// many idle peers with a few active ones is the common case of the seed nodes
+BENCHMARK_TEST_CASE(socket_events_benchmark)
+{
+    const int32_t PEER_COUNT = 300;
+    const int32_t MSG_COUNT  = 5000;
+
+    for (const auto &mode : GetModes()) {
+        for (int32_t activeCount : {1, PEER_COUNT}) {
+            FLoopbackPeers peers(PEER_COUNT);
+            auto pEvents   = MakeSocketEvents(mode);
+            double cpuTime = RunMessages(*pEvents, peers, activeCount, MSG_COUNT);
+            BOOST_TEST_MESSAGE(strprintf("%s: %d peers, %d active, cpu per message=%.2fus", mode, PEER_COUNT,
+                                         activeCount, cpuTime));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,159 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/block.h"
+
+#include <boost/test/unit_test.hpp>
+#include "commons/arith_uint256.h"
+#include "main.h"
+#include "persistence/blockdb.h"
+#include "tests/benchmark.h"
+
+using namespace std;
+
+// the synthetic block index is a chain with a fork block every 100 blocks, BLOCK_INDEX_BENCH_SIZE sets its height in
+// the benchmark
+static int32_t GetBenchHeight() {
+    const char *pSize = getenv("BLOCK_INDEX_BENCH_SIZE");
+    return pSize ? atoi(pSize) : 20000;
+}
+
+static map<uint256, uint256> WriteBlockIndexes(CBlockIndexDB &db, int32_t height) {
+    map<uint256, uint256> parents;
+    uint256 prevHash;
+    for (int32_t i = 0; i < height; i++) {
+        CDiskBlockIndex diskIndex;
+        diskIndex.height   = i;
+        diskIndex.nStatus  = BLOCK_VALID_TRANSACTIONS | BLOCK_HAVE_DATA;
+        diskIndex.nDataPos = i;
+        diskIndex.nTime    = i;
+        diskIndex.hashPrev = prevHash;
+        BOOST_CHECK(db.WriteBlockIndex(diskIndex));
+        uint256 hash = diskIndex.GetBlockHash();
+        parents[hash] = prevHash;
+
+        if (i > 0 && i % 100 == 0) {
+            diskIndex.nNonce = 1;
+            BOOST_CHECK(db.WriteBlockIndex(diskIndex));
+            parents[diskIndex.GetBlockHash()] = prevHash;
+        }
+        prevHash = hash;
+    }
+    return parents;
+}
+
+// load the block indexes as LoadBlockIndexDB() does and return the elapsed time in microseconds
+static int64_t LoadBlockIndexes(CBlockIndexDB &db, CWorkerPool &workerPool) {
+    mapBlockIndex.clear();
+    blockIndexArena.Clear();
+
+    int64_t beginTime = GetTimeMicros();
+    BOOST_CHECK(db.LoadBlockIndexes(workerPool));
+    vector<pair<int32_t, CBlockIndex *>> sortedByHeight;
+    for (const auto &item : mapBlockIndex)
+        sortedByHeight.push_back(make_pair(item.second->height, item.second));
+    sort(sortedByHeight.begin(), sortedByHeight.end());
+    BuildSkipList(sortedByHeight, workerPool);
+    return GetTimeMicros() - beginTime;
+}
+
+static void CheckBlockIndexes(map<uint256, uint256> &parents) {
+    BOOST_CHECK(mapBlockIndex.size() == parents.size());
+    map<CBlockIndex *, CBlockIndex *> skips;
+    for (const auto &item : mapBlockIndex) {
+        CBlockIndex *pIndex = item.second;
+        BOOST_CHECK(pIndex->GetBlockHash() == item.first);
+        BOOST_CHECK((pIndex->pprev ? pIndex->pprev->GetBlockHash() : uint256()) == parents[item.first]);
+        BOOST_CHECK(pIndex->pprev == nullptr || pIndex->pprev->height == pIndex->height - 1);
+        skips[pIndex] = pIndex->pskip;
+    }
+
+    // the skip pointers are the same as the ones built one by one
+    vector<pair<int32_t, CBlockIndex *>> sortedByHeight;
+    for (const auto &item : skips)
+        sortedByHeight.push_back(make_pair(item.first->height, item.first));
+    sort(sortedByHeight.begin(), sortedByHeight.end());
+    for (const auto &item : sortedByHeight) {
+        item.second->pskip = nullptr;
+        item.second->BuildSkip();
+        BOOST_CHECK(item.second->pskip == skips[item.second]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(blockindex_tests)
+
+BOOST_AUTO_TEST_CASE(arena_test)
+{
+    CBlockIndexArena arena;
+    BlockMap blockMap;
+    vector<CBlockIndex *> indexes;
+    CBlockIndex *pPrev = nullptr;
+    // the indexes of more than one chunk
+    for (int32_t height = 0; height < (int32_t)CBlockIndexArena::CHUNK_SIZE * 2 + 10; height++) {
+        CBlockIndex *pIndex = arena.Allocate();
+        BOOST_CHECK(pIndex->pprev == nullptr && pIndex->height == 0);
+
+        pIndex->height     = height;
+        pIndex->pprev      = pPrev;
+        pIndex->pBlockHash = &blockMap.emplace(ArithToUint256(arith_uint256(height + 1)), pIndex).first->first;
+        indexes.push_back(pIndex);
+        pPrev = pIndex;
+    }
+    BOOST_CHECK(arena.GetCount() == indexes.size());
+    BOOST_CHECK(arena.GetMemoryUsage() == 3 * CBlockIndexArena::CHUNK_SIZE * sizeof(CBlockIndex));
+    BOOST_CHECK(GetBlockMapMemoryUsage(blockMap) > 0);
+
+    // neither the growth of the arena nor the rehash of the map moves the indexes and their hashes
+    for (int32_t height = 0; height < (int32_t)indexes.size(); height++) {
+        CBlockIndex *pIndex = indexes[height];
+        BOOST_CHECK(pIndex->height == height);
+        BOOST_CHECK(pIndex->GetBlockHash() == ArithToUint256(arith_uint256(height + 1)));
+        BOOST_CHECK(blockMap.at(pIndex->GetBlockHash()) == pIndex);
+        BOOST_CHECK(pIndex->pprev == (height > 0 ? indexes[height - 1] : nullptr));
+    }
+
+    arena.Clear();
+    BOOST_CHECK(arena.GetCount() == 0 && arena.GetMemoryUsage() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(load_test)
+{
+    CBlockIndexDB db(true, true);
+    map<uint256, uint256> parents = WriteBlockIndexes(db, 2000);
+
+    CWorkerPool serialPool;
+    LoadBlockIndexes(db, serialPool);
+    CheckBlockIndexes(parents);
+
+    CWorkerPool workerPool;
+    workerPool.Start("loadtest", 3);
+    LoadBlockIndexes(db, workerPool);
+    workerPool.Stop();
+    CheckBlockIndexes(parents);
+
+    mapBlockIndex.clear();
+    blockIndexArena.Clear();
+}
+
+BENCHMARK_TEST_CASE(load_benchmark)
+{
+    CBlockIndexDB db(true, true);
+    map<uint256, uint256> parents = WriteBlockIndexes(db, GetBenchHeight());
+
+    CWorkerPool serialPool;
+    int64_t serialTime = LoadBlockIndexes(db, serialPool);
+
+    CWorkerPool workerPool;
+    workerPool.Start("loadtest", 3);
+    int64_t parallelTime = LoadBlockIndexes(db, workerPool);
+    workerPool.Stop();
+    BOOST_TEST_MESSAGE("load " << parents.size() << " block indexes: " << serialTime << "us on 1 thread, "
+                               << parallelTime << "us on 4 threads");
+    BOOST_CHECK(mapBlockIndex.size() == parents.size());
+
+    mapBlockIndex.clear();
+    blockIndexArena.Clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/blockundo.h"
+
+#include <boost/test/unit_test.hpp>
+#include "commons/arith_uint256.h"
+#include "commons/util/time.h"
+#include "config/version.h"
+#include "tests/benchmark.h"
+#include "tx/coinminttx.h"
+
+using namespace std;
+
+static const int32_t BLOCK_TX_COUNT = 200;
+
+// the blocks of a chain with the undo data of their txs, an account and a receipt are changed by each tx
+struct CUndoTestChain {
+    BlockMap blockMap;
+    vector<std::unique_ptr<CBlockIndex>> indexes;
+    vector<CBlock> blocks;
+    vector<CBlockUndo> blockUndos;
+
+    explicit CUndoTestChain(int32_t height) {
+        CBlockIndex *pPrev = nullptr;
+        for (int32_t i = 0; i < height; i++) {
+            CBlock block;
+            block.SetHeight(i);
+            CBlockUndo blockUndo;
+            for (int32_t n = 0; n < BLOCK_TX_COUNT; n++) {
+                CCoinMintTx tx(CRegID(i + 1, n), i, SYMB::WICC, n * COIN);
+                block.vptx.push_back(tx.GetNewInstance());
+
+                CTxUndo txUndo(tx.GetHash());
+                CDbOpLog accountLog, receiptLog;
+                accountLog.Set(CRegID(i + 1, n).ToString(), string(100, 'a'));
+                receiptLog.Set(tx.GetHash(), string(50, 'r'));
+                txUndo.dbOpLogMap.AddOpLog(dbk::REGID_KEYID, accountLog);
+                txUndo.dbOpLogMap.AddOpLog(dbk::TX_RECEIPT, receiptLog);
+                blockUndo.vtxundo.push_back(txUndo);
+            }
+            blocks.push_back(block);
+            blockUndos.push_back(blockUndo);
+
+            std::unique_ptr<CBlockIndex> pIndex(new CBlockIndex());
+            pIndex->height     = i;
+            pIndex->pprev      = pPrev;
+            pIndex->pBlockHash = &blockMap.emplace(ArithToUint256(arith_uint256(i + 1)), pIndex.get()).first->first;
+            pPrev = pIndex.get();
+            indexes.push_back(std::move(pIndex));
+        }
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(blockundo_tests)
+
+BOOST_AUTO_TEST_CASE(undo_cache_test)
+{
+    CUndoTestChain chain(10);
+    CBlockUndoCache undoCache;
+    undoCache.SetMaxCount(5);
+    for (size_t i = 0; i < chain.indexes.size(); i++)
+        undoCache.Put(chain.indexes[i].get(), chain.blocks[i], chain.blockUndos[i]);
+
+    // the oldest blocks are evicted
+    BOOST_CHECK(undoCache.Get(chain.indexes[4].get()) == nullptr);
+    auto pInfo = undoCache.Get(chain.indexes[9].get());
+    BOOST_CHECK(pInfo != nullptr && pInfo->block_hash == chain.indexes[9]->GetBlockHash());
+
+    // the undo data is shared, the txs of the block are copied to be executed again
+    std::shared_ptr<const CBlockUndo> pBlockUndo;
+    BOOST_CHECK(undoCache.ReadBlockUndo(chain.indexes[9].get(), pBlockUndo));
+    BOOST_CHECK(pBlockUndo == pInfo->block_undo);
+    BOOST_CHECK(pBlockUndo->vtxundo.size() == BLOCK_TX_COUNT);
+    BOOST_CHECK(pBlockUndo->vtxundo[1].txid == chain.blockUndos[9].vtxundo[1].txid);
+
+    CBlock block;
+    BOOST_CHECK(undoCache.ReadBlock(chain.indexes[9].get(), block));
+    BOOST_CHECK(block.GetHash() == chain.blocks[9].GetHash());
+    BOOST_CHECK(block.vptx.size() == BLOCK_TX_COUNT);
+    BOOST_CHECK(block.vptx[0] != pInfo->block.vptx[0] && block.vptx[0] != chain.blocks[9].vptx[0]);
+    BOOST_CHECK(block.vptx[0]->GetHash() == chain.blocks[9].vptx[0]->GetHash());
+
+    // the index reused by another block is not matched
+    uint256 otherHash = ArithToUint256(arith_uint256(1000));
+    const uint256 *pBlockHash = chain.indexes[8]->pBlockHash;
+    chain.indexes[8]->pBlockHash = &otherHash;
+    uint64_t missCount = undoCache.GetMissCount();
+    BOOST_CHECK(undoCache.Get(chain.indexes[8].get()) == nullptr);
+    BOOST_CHECK(undoCache.GetMissCount() == missCount + 1);
+    chain.indexes[8]->pBlockHash = pBlockHash;
+
+    undoCache.Clear();
+    BOOST_CHECK(undoCache.Get(chain.indexes[9].get()) == nullptr);
+}
+
+// the time to get the blocks and the undo data to disconnect and reconnect the blocks of a reorg, from the cache or
+// by deserializing them as they are read from disk, which is the lower bound of reading them without the cache
+BENCHMARK_TEST_CASE(reorg_depth_benchmark)
+{
+    const vector<int32_t> depths = {1, 3, 10, 50};
+    CUndoTestChain chain(depths.back());
+    CBlockUndoCache undoCache;
+    undoCache.SetMaxCount(DEFAULT_UNDO_CACHE_BLOCKS);
+
+    vector<string> rawBlocks, rawBlockUndos;
+    for (size_t i = 0; i < chain.indexes.size(); i++) {
+        undoCache.Put(chain.indexes[i].get(), chain.blocks[i], chain.blockUndos[i]);
+
+        CDataStream ssBlock(SER_DISK, CLIENT_VERSION), ssBlockUndo(SER_DISK, CLIENT_VERSION);
+        ssBlock << chain.blocks[i];
+        ssBlockUndo << chain.blockUndos[i];
+        rawBlocks.push_back(ssBlock.str());
+        rawBlockUndos.push_back(ssBlockUndo.str());
+    }
+
+    for (auto depth : depths) {
+        int64_t beginTime = GetTimeMicros();
+        for (int32_t i = chain.indexes.size() - 1; i >= (int32_t)chain.indexes.size() - depth; i--) {
+            // disconnect and then reconnect each block
+            CBlock block;
+            std::shared_ptr<const CBlockUndo> pBlockUndo;
+            BOOST_CHECK(undoCache.ReadBlock(chain.indexes[i].get(), block));
+            BOOST_CHECK(undoCache.ReadBlockUndo(chain.indexes[i].get(), pBlockUndo));
+            BOOST_CHECK(undoCache.ReadBlock(chain.indexes[i].get(), block));
+        }
+        int64_t cacheTime = GetTimeMicros() - beginTime;
+
+        beginTime = GetTimeMicros();
+        for (int32_t i = chain.indexes.size() - 1; i >= (int32_t)chain.indexes.size() - depth; i--) {
+            CBlock block;
+            CBlockUndo blockUndo;
+            CDataStream(rawBlocks[i], SER_DISK, CLIENT_VERSION) >> block;
+            CDataStream(rawBlockUndos[i], SER_DISK, CLIENT_VERSION) >> blockUndo;
+            CDataStream(rawBlocks[i], SER_DISK, CLIENT_VERSION) >> block;
+            BOOST_CHECK(blockUndo.vtxundo.size() == BLOCK_TX_COUNT);
+        }
+        int64_t diskTime = GetTimeMicros() - beginTime;
+
+        BOOST_TEST_MESSAGE("reorg depth " << depth << " of " << BLOCK_TX_COUNT << " txs per block: cache "
+                                          << cacheTime << "us, deserialized " << diskTime << "us");
+    }
+    BOOST_CHECK(undoCache.GetMissCount() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/block.h"
+
+#include <boost/test/unit_test.hpp>
+#include "commons/util/time.h"
+#include "config/version.h"
+#include "tests/benchmark.h"
+#include "tx/coinminttx.h"
+
+using namespace std;
+
+static const int32_t TX_COUNT = 1000;
+
+// the txs of a block as they are put into cache by ConnectBlock
+static vector<CTxBodyCache::InfoPtr> MakeTxBodies(int32_t count) {
+    CBlock block;
+    block.SetHeight(100);
+    auto pHeader = std::make_shared<const CBlockHeader>(block);
+
+    vector<CTxBodyCache::InfoPtr> txBodies;
+    for (int32_t i = 0; i < count; i++) {
+        CCoinMintTx tx(CRegID(i + 1, 1), 100, SYMB::WICC, COIN + i);
+        auto pInfo    = std::make_shared<CTxBodyInfo>();
+        pInfo->tx     = tx.GetNewInstance();
+        pInfo->header = pHeader;
+        pInfo->size   = ::GetSerializeSize(pInfo->tx, SER_DISK, CLIENT_VERSION);
+        pInfo->pos    = CDiskTxPos(CDiskBlockPos(0, 0), i * pInfo->size, CTxCord(100, i));
+        txBodies.push_back(pInfo);
+    }
+    return txBodies;
+}
+
+BOOST_AUTO_TEST_SUITE(txbodycache_tests)
+
+BOOST_AUTO_TEST_CASE(tx_body_cache_test)
+{
+    auto txBodies = MakeTxBodies(10);
+    CTxBodyCache txCache;
+
+    // disabled by default
+    txCache.Put(txBodies[0]->tx->GetHash(), txBodies[0]);
+    BOOST_CHECK(!txCache.IsEnabled());
+    BOOST_CHECK(txCache.Get(txBodies[0]->tx->GetHash(), txBodies[0]->pos) == nullptr);
+
+    // bounded by the size of the txs, the least recently used txs are evicted
+    txCache.SetMaxSize(txBodies[0]->size * 5);
+    for (const auto &pInfo : txBodies)
+        txCache.Put(pInfo->tx->GetHash(), pInfo);
+
+    BOOST_CHECK(txCache.Get(txBodies[4]->tx->GetHash(), txBodies[4]->pos) == nullptr);
+    auto pInfo = txCache.Get(txBodies[9]->tx->GetHash(), txBodies[9]->pos);
+    BOOST_CHECK(pInfo == txBodies[9]);
+    BOOST_CHECK(pInfo->header->GetHeight() == 100);
+
+    uint64_t hitCount = txCache.GetHitCount(), missCount = txCache.GetMissCount();
+    BOOST_CHECK(txCache.Get(txBodies[5]->tx->GetHash(), txBodies[5]->pos) != nullptr);
+    BOOST_CHECK(txCache.Get(txBodies[0]->tx->GetHash(), txBodies[0]->pos) == nullptr);
+    BOOST_CHECK(txCache.GetHitCount() == hitCount + 1);
+    BOOST_CHECK(txCache.GetMissCount() == missCount + 1);
+
+    // the recently used tx stays after more txs are put
+    auto moreTxBodies = MakeTxBodies(14);
+    for (int32_t i = 10; i < 14; i++)
+        txCache.Put(moreTxBodies[i]->tx->GetHash(), moreTxBodies[i]);
+    BOOST_CHECK(txCache.Get(txBodies[5]->tx->GetHash(), txBodies[5]->pos) != nullptr);
+    BOOST_CHECK(txCache.Get(txBodies[9]->tx->GetHash(), txBodies[9]->pos) == nullptr);
+
+    // the tx at another position, as of a disconnected block, is not found until it is put again
+    auto pMoved = std::make_shared<CTxBodyInfo>(*txBodies[5]);
+    pMoved->pos = CDiskTxPos(CDiskBlockPos(1, 0), 0, CTxCord(101, 1));
+    BOOST_CHECK(txCache.Get(pMoved->tx->GetHash(), pMoved->pos) == nullptr);
+    txCache.Put(pMoved->tx->GetHash(), pMoved);
+    BOOST_CHECK(txCache.Get(pMoved->tx->GetHash(), pMoved->pos) == pMoved);
+    BOOST_CHECK(txCache.Get(txBodies[5]->tx->GetHash(), txBodies[5]->pos) == nullptr);
+
+    txCache.Clear();
+    BOOST_CHECK(txCache.Get(txBodies[5]->tx->GetHash(), txBodies[5]->pos) == nullptr);
+}
+
+// the time to look up the txs from the cache or by deserializing them as they are read from the block file, which is
+// the lower bound of reading them without the cache
+BENCHMARK_TEST_CASE(tx_lookup_benchmark)
+{
+    auto txBodies = MakeTxBodies(TX_COUNT);
+    CTxBodyCache txCache;
+    txCache.SetMaxSize(DEFAULT_TX_BODY_CACHE_SIZE << 20);
+
+    vector<string> rawTxs;
+    for (const auto &pInfo : txBodies) {
+        txCache.Put(pInfo->tx->GetHash(), pInfo);
+
+        CDataStream ssTx(SER_DISK, CLIENT_VERSION);
+        ssTx << pInfo->tx;
+        rawTxs.push_back(ssTx.str());
+    }
+
+    int64_t beginTime = GetTimeMicros();
+    for (const auto &pInfo : txBodies)
+        BOOST_CHECK(txCache.Get(pInfo->tx->GetHash(), pInfo->pos) != nullptr);
+    int64_t cacheTime = GetTimeMicros() - beginTime;
+
+    beginTime = GetTimeMicros();
+    for (const auto &rawTx : rawTxs) {
+        std::shared_ptr<CBaseTx> pBaseTx;
+        CDataStream(rawTx, SER_DISK, CLIENT_VERSION) >> pBaseTx;
+        BOOST_CHECK(pBaseTx != nullptr);
+    }
+    int64_t diskTime = GetTimeMicros() - beginTime;
+
+    BOOST_TEST_MESSAGE("lookup of " << TX_COUNT << " txs: cache " << cacheTime << "us, deserialized " << diskTime
+                                    << "us");
+    BOOST_CHECK(txCache.GetMissCount() == 0);
+    BOOST_CHECK(txCache.GetHitCount() == TX_COUNT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <boost/test/unit_test.hpp>
+#include "miner/miner.h"
+#include "tx/coinminttx.h"
+#include "tx/txmempool.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(txmempool_tests)
+
+static CTxMemPoolEntry MakeEntry(int32_t index, uint64_t fees) {
+    CCoinMintTx tx(CRegID(index + 1, 1), index, SYMB::WICC, index * COIN);
+    tx.llFees = fees;
+    return CTxMemPoolEntry(&tx, GetTime(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(priority_level_test)
+{
+    BOOST_CHECK(CTxMemPoolPriorityKey::GetPriorityLevel(0.5) == 0);
+    BOOST_CHECK(CTxMemPoolPriorityKey::GetPriorityLevel(TRANSACTION_PRIORITY_CEILING) == 0);
+    BOOST_CHECK(CTxMemPoolPriorityKey::GetPriorityLevel(PRICE_MEDIAN_TRANSACTION_PRIORITY) <
+                CTxMemPoolPriorityKey::GetPriorityLevel(PRICE_FEED_TRANSACTION_PRIORITY));
+}
+
+// the priority index and the tx priorities of the miner share the same strict orders
+BOOST_AUTO_TEST_CASE(priority_index_order_test)
+{
+    set<CTxMemPoolPriorityKey> priorityIndex;
+    map<uint256, CTxMemPoolEntry> entries;
+    for (int32_t i = 0; i < 200; i++) {
+        CTxMemPoolEntry entry = MakeEntry(i, (i % 7) * 10000);
+        uint256 txid          = entry.GetTransaction()->GetHash();
+        priorityIndex.insert(CTxMemPoolPriorityKey(txid, entry));
+        entries.emplace(txid, entry);
+    }
+    BOOST_CHECK(priorityIndex.size() == 200);
+
+    double lastFeePerKb = -1;
+    set<TxPriority> txPriorities;
+    for (const auto &key : priorityIndex) {
+        BOOST_CHECK(key.feePerKb >= lastFeePerKb);
+        lastFeePerKb = key.feePerKb;
+
+        const CTxMemPoolEntry &entry = entries.at(key.txid);
+        txPriorities.emplace_hint(txPriorities.end(), entry.GetPriority(), key.feePerKb, entry.GetTransaction());
+    }
+    BOOST_CHECK(txPriorities.size() == priorityIndex.size());
+
+    auto keyIt = priorityIndex.begin();
+    for (const auto &txPriority : txPriorities) {
+        BOOST_CHECK(txPriority.baseTx->GetHash() == keyIt->txid);
+        ++keyIt;
+    }
+
+    // the system txs above the priority ceiling rank ahead of any fee rate
+    txPriorities.emplace(PRICE_MEDIAN_TRANSACTION_PRIORITY, 0, MakeEntry(1000, 0).GetTransaction());
+    BOOST_CHECK(txPriorities.rbegin()->priority == PRICE_MEDIAN_TRANSACTION_PRIORITY);
+
+    // remove the lowest fee rate entries as the eviction does
+    while (priorityIndex.size() > 100) {
+        uint256 txid = priorityIndex.begin()->txid;
+        BOOST_CHECK(priorityIndex.erase(CTxMemPoolPriorityKey(txid, entries.at(txid))) == 1);
+    }
+    BOOST_CHECK(priorityIndex.begin()->feePerKb > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "vm/luavm/luavm.h"
+
+#include <boost/test/unit_test.hpp>
+#include "commons/util/time.h"
+#include "config/version.h"
+#include "tests/benchmark.h"
+#include "vm/luavm/lua/lua.hpp"
+
+using namespace std;
+
+int32_t luaopen_mylib_v3(lua_State *L);
+
+static const int32_t CALL_COUNT = 1000;
+static const uint64_t FUEL_LIMIT = 1000000;
+
+// builds strings and tables to burn the fuel of both the operators and the memory
+static const string SCRIPT =
+    "local t = {}\n"
+    "for i = 1, 100 do\n"
+    "    t[#t + 1] = tostring(i * 3) .. 'x'\n"
+    "end\n"
+    "gResult = table.concat(t, ',')\n";
+
+// the fuel burned by the script run in the state, which is closed after the run
+static uint64_t RunScript(CLuaStatePtr luaState) {
+    BOOST_REQUIRE(luaState);
+    lua_State *L = luaState.get();
+    BOOST_REQUIRE(luaL_loadbuffer(L, SCRIPT.c_str(), SCRIPT.size(), "line") == LUA_OK);
+    BOOST_REQUIRE(lua_pcallk(L, 0, 0, 0, 0, NULL, MAJOR_VER_R3) == LUA_OK);
+    return lua_GetBurnedFuel(L);
+}
+
+static CLuaStatePtr GetPooledState(CLuaStatePool &pool) {
+    // the states are opened by the thread of the pool
+    for (int32_t i = 0; i < 1000; i++) {
+        CLuaStatePtr luaState = pool.Get(MAJOR_VER_R3, luaopen_mylib_v3, FUEL_LIMIT, nullptr);
+        if (luaState)
+            return luaState;
+        MilliSleep(1);
+    }
+    return nullptr;
+}
+
+BOOST_AUTO_TEST_SUITE(luavm_tests)
+
+BOOST_AUTO_TEST_CASE(state_pool_fuel_test)
+{
+    string strError;
+    uint64_t fuel = RunScript(CLuaVM::OpenState(MAJOR_VER_R3, luaopen_mylib_v3, FUEL_LIMIT, nullptr, strError));
+    BOOST_CHECK(fuel > 0);
+
+    // a pooled state burns the fuel of a state opened by the call
+    CLuaStatePool pool;
+    for (int32_t i = 0; i < 10; i++)
+        BOOST_CHECK_EQUAL(RunScript(GetPooledState(pool)), fuel);
+
+    // the states of another burn version are dropped
+    BOOST_CHECK(GetPooledState(pool) != nullptr);
+    BOOST_CHECK(pool.Get(MAJOR_VER_R2, luaopen_mylib_v3, FUEL_LIMIT, nullptr) == nullptr);
+
+    pool.Stop();
+    BOOST_CHECK(pool.Get(MAJOR_VER_R3, luaopen_mylib_v3, FUEL_LIMIT, nullptr) == nullptr);
+}
+
+// the time to open a state and run a small script, by the states opened by each call or taken from the pool
+BENCHMARK_TEST_CASE(state_pool_benchmark)
+{
+    string strError;
+    int64_t beginTime = GetTimeMicros();
+    for (int32_t i = 0; i < CALL_COUNT; i++)
+        RunScript(CLuaVM::OpenState(MAJOR_VER_R3, luaopen_mylib_v3, FUEL_LIMIT, nullptr, strError));
+    int64_t openTime = GetTimeMicros() - beginTime;
+
+    CLuaStatePool pool;
+    int64_t pooledTime = 0;
+    for (int32_t i = 0; i < CALL_COUNT; i++) {
+        CLuaStatePtr luaState = GetPooledState(pool);
+        beginTime = GetTimeMicros();
+        RunScript(std::move(luaState));
+        pooledTime += GetTimeMicros() - beginTime;
+    }
+
+    BOOST_TEST_MESSAGE(CALL_COUNT << " calls: opened by call " << openTime << "us, pooled " << pooledTime << "us");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
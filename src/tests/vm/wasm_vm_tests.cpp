@@ -0,0 +1,258 @@
+// Copyright (c) 2017-2020 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "wasm/wasm_interface.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include "commons/util/time.h"
+#include "crypto/hash.h"
+#include "tests/benchmark.h"
+#include "wasm/exception/exceptions.hpp"
+
+using namespace std;
+using namespace wasm;
+
+extern void wasm_code_cache_free();
+
+static const int32_t CALL_COUNT = 5;
+
+/**
+ * The cpu bound contract, the action 1 divides by zero at the end
+ *
+ * (module
+ *   (import "env" "printui" (func $printui (param i64)))
+ *   (import "env" "db_store" (func $db_store (param i64 i32 i32 i32 i32) (result i32)))
+ *   (memory 1)
+ *   (func $fib (param $n i32) (result i64)
+ *     (if (result i64) (i32.lt_u (local.get $n) (i32.const 2))
+ *       (then (i64.extend_i32_u (local.get $n)))
+ *       (else (i64.add (call $fib (i32.sub (local.get $n) (i32.const 1)))
+ *                      (call $fib (i32.sub (local.get $n) (i32.const 2)))))))
+ *   (func (export "apply") (param $receiver i64) (param $contract i64) (param $action i64)
+ *     (local $i i32) (local $x i64) (local $sum i64)
+ *     (call $printui (call $fib (i32.const 25)))
+ *     ;; a lcg of 1M rounds seeded by the action, rotated into a ring of 4 KB and read back crosswise
+ *     (local.set $x (local.get $action))
+ *     (loop $l
+ *       (local.set $x (i64.add (i64.mul (local.get $x) (i64.const 6364136223846793005))
+ *                              (i64.const 1442695040888963407)))
+ *       (i64.store (i32.and (i32.shl (local.get $i) (i32.const 3)) (i32.const 4095))
+ *                  (i64.rotl (local.get $x) (i64.extend_i32_u (local.get $i))))
+ *       (local.set $sum (i64.xor (local.get $sum)
+ *                                (i64.load (i32.and (i32.mul (local.get $i) (i32.const 24)) (i32.const 4088)))))
+ *       (br_if $l (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 1))) (i32.const 1000000))))
+ *     (call $printui (local.get $x))
+ *     (call $printui (local.get $sum))
+ *     ;; stores the sum by the key "cpu_test"
+ *     (i64.store (i32.const 8192) (i64.const 0x747365745f757063))
+ *     (i64.store (i32.const 8200) (local.get $sum))
+ *     (drop (call $db_store (local.get $receiver) (i32.const 8192) (i32.const 8) (i32.const 8200) (i32.const 8)))
+ *     (if (i64.eq (local.get $action) (i64.const 1))
+ *       (then (drop (i32.div_u (i32.const 1) (i32.const 0)))))))
+ */
+static const vector<uint8_t> CPU_MODULE = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x19, 0x04, 0x60, 0x01, 0x7e, 0x00, 0x60,
+    0x03, 0x7e, 0x7e, 0x7e, 0x00, 0x60, 0x01, 0x7f, 0x01, 0x7e, 0x60, 0x05, 0x7e, 0x7f, 0x7f, 0x7f,
+    0x7f, 0x01, 0x7f, 0x02, 0x1e, 0x02, 0x03, 0x65, 0x6e, 0x76, 0x07, 0x70, 0x72, 0x69, 0x6e, 0x74,
+    0x75, 0x69, 0x00, 0x00, 0x03, 0x65, 0x6e, 0x76, 0x08, 0x64, 0x62, 0x5f, 0x73, 0x74, 0x6f, 0x72,
+    0x65, 0x00, 0x03, 0x03, 0x03, 0x02, 0x02, 0x01, 0x05, 0x03, 0x01, 0x00, 0x01, 0x07, 0x09, 0x01,
+    0x05, 0x61, 0x70, 0x70, 0x6c, 0x79, 0x00, 0x03, 0x0a, 0xc2, 0x01, 0x02, 0x1d, 0x00, 0x20, 0x00,
+    0x41, 0x02, 0x49, 0x04, 0x7e, 0x20, 0x00, 0xad, 0x05, 0x20, 0x00, 0x41, 0x01, 0x6b, 0x10, 0x02,
+    0x20, 0x00, 0x41, 0x02, 0x6b, 0x10, 0x02, 0x7c, 0x0b, 0x0b, 0xa1, 0x01, 0x02, 0x01, 0x7f, 0x02,
+    0x7e, 0x41, 0x19, 0x10, 0x02, 0x10, 0x00, 0x20, 0x02, 0x21, 0x04, 0x03, 0x40, 0x20, 0x04, 0x42,
+    0xad, 0xfe, 0xd5, 0xe4, 0xd4, 0x85, 0xfd, 0xa8, 0xd8, 0x00, 0x7e, 0x42, 0xcf, 0x82, 0x9e, 0xbb,
+    0xef, 0xef, 0xde, 0x82, 0x14, 0x7c, 0x21, 0x04, 0x20, 0x03, 0x41, 0x03, 0x74, 0x41, 0xff, 0x1f,
+    0x71, 0x20, 0x04, 0x20, 0x03, 0xad, 0x89, 0x37, 0x03, 0x00, 0x20, 0x05, 0x20, 0x03, 0x41, 0x18,
+    0x6c, 0x41, 0xf8, 0x1f, 0x71, 0x29, 0x03, 0x00, 0x85, 0x21, 0x05, 0x20, 0x03, 0x41, 0x01, 0x6a,
+    0x22, 0x03, 0x41, 0xc0, 0x84, 0x3d, 0x49, 0x0d, 0x00, 0x0b, 0x20, 0x04, 0x10, 0x00, 0x20, 0x05,
+    0x10, 0x00, 0x41, 0x80, 0xc0, 0x00, 0x42, 0xe3, 0xe0, 0xd5, 0xfb, 0xc5, 0xae, 0xd9, 0xb9, 0xf4,
+    0x00, 0x37, 0x03, 0x00, 0x41, 0x88, 0xc0, 0x00, 0x20, 0x05, 0x37, 0x03, 0x00, 0x20, 0x00, 0x41,
+    0x80, 0xc0, 0x00, 0x41, 0x08, 0x41, 0x88, 0xc0, 0x00, 0x41, 0x08, 0x10, 0x01, 0x1a, 0x20, 0x02,
+    0x42, 0x01, 0x51, 0x04, 0x40, 0x41, 0x01, 0x41, 0x00, 0x6e, 0x1a, 0x0b, 0x0b,
+};
+
+/**
+ * The contract growing its memory up to the limit, the action 1 stores out of the memory at the end
+ *
+ * (module
+ *   (import "env" "printui" (func $printui (param i64)))
+ *   (memory 1)
+ *   (func (export "apply") (param $receiver i64) (param $contract i64) (param $action i64)
+ *     (local $p i32) (local $sum i64)
+ *     ;; grows 16 pages at a time until it fails, writing and reading the last word of each new chunk
+ *     (block $done
+ *       (loop $l
+ *         (br_if $done (i32.eq (memory.grow (i32.const 16)) (i32.const -1)))
+ *         (local.set $p (i32.sub (i32.shl (memory.size) (i32.const 16)) (i32.const 8)))
+ *         (i64.store (local.get $p) (i64.extend_i32_u (memory.size)))
+ *         (local.set $sum (i64.add (local.get $sum) (i64.load (local.get $p))))
+ *         (br $l)))
+ *     (call $printui (i64.extend_i32_u (memory.size)))
+ *     (call $printui (local.get $sum))
+ *     (if (i64.eq (local.get $action) (i64.const 1))
+ *       (then (i64.store (i32.shl (memory.size) (i32.const 16)) (i64.const 0))))))
+ */
+static const vector<uint8_t> MEMORY_MODULE = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0b, 0x02, 0x60, 0x01, 0x7e, 0x00, 0x60,
+    0x03, 0x7e, 0x7e, 0x7e, 0x00, 0x02, 0x0f, 0x01, 0x03, 0x65, 0x6e, 0x76, 0x07, 0x70, 0x72, 0x69,
+    0x6e, 0x74, 0x75, 0x69, 0x00, 0x00, 0x03, 0x02, 0x01, 0x01, 0x05, 0x03, 0x01, 0x00, 0x01, 0x07,
+    0x09, 0x01, 0x05, 0x61, 0x70, 0x70, 0x6c, 0x79, 0x00, 0x01, 0x0a, 0x50, 0x01, 0x4e, 0x02, 0x01,
+    0x7f, 0x01, 0x7e, 0x02, 0x40, 0x03, 0x40, 0x41, 0x10, 0x40, 0x00, 0x41, 0x7f, 0x46, 0x0d, 0x01,
+    0x3f, 0x00, 0x41, 0x10, 0x74, 0x41, 0x08, 0x6b, 0x21, 0x03, 0x20, 0x03, 0x3f, 0x00, 0xad, 0x37,
+    0x03, 0x00, 0x20, 0x04, 0x20, 0x03, 0x29, 0x03, 0x00, 0x7c, 0x21, 0x04, 0x0c, 0x00, 0x0b, 0x0b,
+    0x3f, 0x00, 0xad, 0x10, 0x00, 0x20, 0x04, 0x10, 0x00, 0x20, 0x02, 0x42, 0x01, 0x51, 0x04, 0x40,
+    0x3f, 0x00, 0x41, 0x10, 0x74, 0x42, 0x00, 0x37, 0x03, 0x00, 0x0b, 0x0b,
+};
+
+// a contract context keeping the console and the data in memory
+class CWasmTestContext : public wasm_context_interface {
+public:
+    explicit CWasmTestContext(uint64_t actionIn) : action_(actionIn) {}
+
+    void execute_inline(const inline_transaction &trx) override {}
+    void notify_recipient(const uint64_t &recipient) override {}
+    bool has_recipient(const uint64_t &account) const override { return false; }
+    uint64_t receiver() override { return 7; }
+    uint64_t contract() override { return 7; }
+    uint64_t action() override { return action_; }
+    const char *get_action_data() override { return nullptr; }
+    uint32_t get_action_data_size() override { return 0; }
+
+    bool is_account(const uint64_t &account) const override { return true; }
+    void require_auth(const uint64_t &account) const override {}
+    bool has_authorization(const uint64_t &account) const override { return true; }
+    void require_auth2(const uint64_t &account, const uint64_t &permission) const override {}
+    uint64_t pending_block_time() override { return 0; }
+    TxID get_txid() override { return TxID(); }
+    uint64_t get_maintainer(const uint64_t &contract) override { return 0; }
+    void exit() override { wasmif.exit(); }
+    bool get_system_asset_price(uint64_t base, uint64_t quote, std::vector<char> &price) override { return false; }
+
+    bool set_data(const uint64_t &contract, const string &k, const string &v) override {
+        database[k] = v;
+        return true;
+    }
+    bool get_data(const uint64_t &contract, const string &k, string &v) override {
+        auto it = database.find(k);
+        if (it == database.end())
+            return false;
+        v = it->second;
+        return true;
+    }
+    bool erase_data(const uint64_t &contract, const string &k) override { return database.erase(k) > 0; }
+
+    std::vector<uint64_t> get_active_producers() override { return {}; }
+    vm::wasm_allocator *get_wasm_allocator() override { return &wasm_alloc; }
+    bool is_memory_in_wasm_allocator(const uint64_t &p) override {
+        return wasm_alloc.is_in_range(reinterpret_cast<const char *>(p));
+    }
+    std::chrono::milliseconds get_max_transaction_duration() override {
+        return std::chrono::milliseconds(max_wasm_execute_time_infinite);
+    }
+    void update_storage_usage(const uint64_t &account, const int64_t &size_in_bytes) override {}
+    bool contracts_console() override { return true; }
+    void console_append(const string &val) override { console += val; }
+
+    void pause_billing_timer() override {}
+    void resume_billing_timer() override {}
+
+    void emit_result(const string_view &name, const string_view &type, const string_view &value) override {}
+
+public:
+    wasm_interface wasmif;
+    vm::wasm_allocator wasm_alloc;
+    string console;
+    map<string, string> database;
+
+private:
+    uint64_t action_;
+};
+
+// the results of a contract executed by a vm, which must not differ from vm to vm
+struct CVmResult {
+    string console;
+    int64_t exceptionCode = 0;
+    map<string, string> database;
+};
+
+static CVmResult ExecuteByVm(vm_type vm, const vector<uint8_t> &code, uint64_t action) {
+    CWasmTestContext context(action);
+    context.wasmif.initialize(vm);
+
+    CVmResult result;
+    try {
+        context.wasmif.execute(code, HashOnce(code.data(), code.size()), &context);
+    } catch (wasm_chain::exception &e) {
+        result.exceptionCode = e.code();
+    }
+    result.console  = context.console;
+    result.database = context.database;
+    return result;
+}
+
+static void CheckSameResultByVms(const string &name, const vector<uint8_t> &code, uint64_t action,
+                                 CVmResult &interpreterResult) {
+    interpreterResult = ExecuteByVm(vm_type::eos_vm, code, action);
+    CVmResult jitResult = ExecuteByVm(vm_type::eos_vm_jit, code, action);
+    BOOST_CHECK_MESSAGE(interpreterResult.console == jitResult.console,
+                        name << " console: " << interpreterResult.console << " != " << jitResult.console);
+    BOOST_CHECK_MESSAGE(interpreterResult.exceptionCode == jitResult.exceptionCode,
+                        name << " exception: " << interpreterResult.exceptionCode << " != " << jitResult.exceptionCode);
+    BOOST_CHECK_MESSAGE(interpreterResult.database == jitResult.database, name << " data");
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_vm_tests)
+
+BOOST_AUTO_TEST_CASE(vm_differential_test)
+{
+    if (!wasm_jit_supported)
+        return;
+
+    CVmResult result;
+    CheckSameResultByVms("cpu", CPU_MODULE, 0, result);
+    BOOST_CHECK_EQUAL(result.console, "75025" "9436980158444776256" "13613459416577407232");
+    BOOST_CHECK_EQUAL(result.exceptionCode, 0);
+    BOOST_CHECK_EQUAL(result.database.size(), 1U);
+
+    CheckSameResultByVms("cpu divided by zero", CPU_MODULE, 1, result);
+    BOOST_CHECK(result.exceptionCode != 0);
+
+    // the memory is limited to 528 pages, so it grows from 1 to 513 pages
+    CheckSameResultByVms("memory", MEMORY_MODULE, 0, result);
+    BOOST_CHECK_EQUAL(result.console, "513" "8480");
+    BOOST_CHECK_EQUAL(result.exceptionCode, 0);
+
+    CheckSameResultByVms("memory out of bounds", MEMORY_MODULE, 1, result);
+    BOOST_CHECK_EQUAL(result.exceptionCode, wasm_chain::wasm_memory_exception::code_value);
+
+    wasm_code_cache_free();
+}
+
+// the calls per second of the contracts executed by each vm, the modules are instantiated before timing
+BENCHMARK_TEST_CASE(vm_throughput_benchmark)
+{
+    vector<vm_type> vms = {vm_type::eos_vm};
+    if (wasm_jit_supported)
+        vms.push_back(vm_type::eos_vm_jit);
+
+    for (auto vm : vms) {
+        for (const auto &item : vector<pair<string, const vector<uint8_t> *>>{{"cpu", &CPU_MODULE},
+                                                                               {"memory", &MEMORY_MODULE}}) {
+            ExecuteByVm(vm, *item.second, 0);
+
+            int64_t beginTime = GetTimeMicros();
+            for (int32_t i = 0; i < CALL_COUNT; i++)
+                BOOST_CHECK(ExecuteByVm(vm, *item.second, 0).exceptionCode == 0);
+            int64_t elapsed = GetTimeMicros() - beginTime;
+
+            BOOST_TEST_MESSAGE(wasm_interface::get_vm_type_name(vm)
+                               << " " << item.first << ": " << CALL_COUNT << " calls in " << elapsed << "us, "
+                               << (elapsed > 0 ? CALL_COUNT * 1000000 / elapsed : 0) << " calls/s");
+        }
+    }
+
+    wasm_code_cache_free();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,24 +16,18 @@ static bool GetUtxoTxFromChain(CCacheWrapper &cw, TxID &txid, std::shared_ptr<CC
     std::shared_ptr<CBaseTx> pBaseTx;
     CDiskTxPos txPos;
     if (cw.blockCache.ReadTxIndex(txid, txPos)) {
-        LOCK(cs_main);
-        CAutoFile file(OpenBlockFile(txPos, true), SER_DISK, CLIENT_VERSION);
-        CBlockHeader header;
-
-        try {
-            file >> header;
-            fseek(file, txPos.nTxOffset, SEEK_CUR);
-            file >> pBaseTx;
-
-            assert(pBaseTx);
-            pPrevUtxoTx = dynamic_pointer_cast<CCoinUtxoTransferTx>(pBaseTx);
-            if (!pPrevUtxoTx) {
-                return ERRORMSG("The expected tx(%s) type is CCoinUtxoTransferTx, but read tx type is %s",
-                                txid.ToString(), typeid(*pBaseTx).name());
-            }
-
-        } catch (std::exception &e) {
-            throw runtime_error(strprintf("%s : Deserialize or I/O error - %s", __func__, e.what()).c_str());
+        CTxBodyCache::InfoPtr pInfo;
+        if (!txBodyCache.GetOrRead(txid, txPos, pInfo))
+            throw runtime_error(strprintf("%s : read tx %s from block file failed", __func__, txid.ToString()).c_str());
+
+        pBaseTx = pInfo->tx;
+        if (!pBaseTx)
+            return ERRORMSG("utxo read preutxo tx(%s) from block file error", txid.ToString());
+
+        pPrevUtxoTx = dynamic_pointer_cast<CCoinUtxoTransferTx>(pBaseTx);
+        if (!pPrevUtxoTx) {
+            return ERRORMSG("The expected tx(%s) type is CCoinUtxoTransferTx, but read tx type is %s",
+                            txid.ToString(), typeid(*pBaseTx).name());
         }
     } else {
         return ERRORMSG("utxo read preutxo tx index error");
@@ -6,15 +6,19 @@
 #include "txmempool.h"
 #include "commons/uint256.h"
 #include "main.h"
+#include "persistence/blockundo.h"
 #include "persistence/txdb.h"
 #include "tx/tx.h"
 #include "miner/miner.h"
 
+#include <algorithm>
+
 using namespace std;
 
 CTxMemPoolEntry::CTxMemPoolEntry() {
     nTxSize   = 0;
     dPriority = 0.0;
+    dFeePerKb = 0.0;
 
     nTime   = 0;
     height = 0;
@@ -25,6 +29,7 @@ CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height
     nFees     = pTx->GetFees();
     nTxSize   = ::GetSerializeSize(*pTx, SER_NETWORK, PROTOCOL_VERSION);
     dPriority = pTx->GetPriority();
+    dFeePerKb = double(nFees.second) / nTxSize * 1000.0;
 }
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry &other) {
@@ -32,25 +37,62 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry &other) {
     this->nFees     = other.nFees;
     this->nTxSize   = other.nTxSize;
     this->dPriority = other.dPriority;
+    this->dFeePerKb = other.dFeePerKb;
 
     this->nTime  = other.nTime;
     this->height = other.height;
 }
 
+// the fuel fee is only known after the tx has been executed, the fee rate before that is the gross one
+void CTxMemPoolEntry::UpdateFeePerKb(CCacheWrapper &cw, int32_t height, uint32_t fuelRate) {
+    dFeePerKb = (double(nFees.second) - double(pTx->GetFuelFee(cw, height, fuelRate))) / nTxSize * 1000.0;
+}
+
 CTxMemPool::CTxMemPool() {
     // Sanity checks off by default for performance, because otherwise
     // accepting transactions becomes O(N^2) where N is the number
     // of transactions in the pool
     fSanityCheck         = false;
+    maxSize              = 0;
+    totalTxSize          = 0;
+}
+
+/*
+ * Records the op logs of the mempool cache into the undo of a tx while it is executed, it must outlive the
+ * savepoints opened for the tx.
+ */
+class CTxMemPoolUndoLogger {
+public:
+    CTxMemPoolUndoLogger(CCacheWrapper &cwIn, CTxMemPoolUndo &txUndo) : cw(cwIn) {
+        cw.SetDbOpLogMap(&txUndo.dbOpLogMap);
+    }
+    ~CTxMemPoolUndoLogger() { cw.SetDbOpLogMap(nullptr); }
+
+private:
+    CCacheWrapper &cw;
+};
+
+map<uint256, CTxMemPoolEntry>::iterator CTxMemPool::EraseEntry(map<uint256, CTxMemPoolEntry>::iterator it) {
+    auto undoIt = txUndoIndex.find(it->first);
+    if (undoIt != txUndoIndex.end()) {
+        txUndos.erase(undoIt->second);
+        txUndoIndex.erase(undoIt);
+    }
+    priorityIndex.erase(CTxMemPoolPriorityKey(it->first, it->second));
+    totalTxSize -= it->second.GetTxSize();
+    METRIC_GAUGE("mempool_tx_count").Add(-1);
+    METRIC_GAUGE("mempool_tx_bytes").Set(totalTxSize);
+    return memPoolTxs.erase(it);
 }
 
 void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive) {
     // Remove transaction from memory pool
     LOCK(cs);
     uint256 txid = pBaseTx->GetHash();
-    if (memPoolTxs.count(txid)) {
-        removed.push_front(std::shared_ptr<CBaseTx>(memPoolTxs[txid].GetTransaction()));
-        memPoolTxs.erase(txid);
+    auto it = memPoolTxs.find(txid);
+    if (it != memPoolTxs.end()) {
+        removed.push_front(std::shared_ptr<CBaseTx>(it->second.GetTransaction()));
+        EraseEntry(it);
         EraseTransactionFromWallet(txid);
     }
 }
@@ -59,25 +101,160 @@ void CTxMemPool::Remove(const uint256 &txid) {
     LOCK(cs);
     auto it = memPoolTxs.find(txid);
     if (it != memPoolTxs.end()) {
-        memPoolTxs.erase(it);
+        EraseEntry(it);
         EraseTransactionFromWallet(txid);
     }
 }
 
+void CTxMemPool::RemoveForBlock(const vector<std::shared_ptr<CBaseTx> > &vptx) {
+    LOCK(cs);
+    for (const auto &pTx : vptx) {
+        auto it = memPoolTxs.find(pTx->GetHash());
+        if (it != memPoolTxs.end())
+            EraseEntry(it);
+    }
+}
+
 bool CTxMemPool::AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state) {
     // Add to memory pool without checking anything.
     // Used by main.cpp AcceptToMemoryPool(), which DOES
     // all the appropriate checks.
     LOCK(cs);
+    CTxMemPoolUndo txUndo(txid);
+    vector<uint256> evictTxids;
     {
-        if (!CheckTxInMemPool(txid, entry, state, memPoolTxs.size()))
+        // reject the tx before executing it if even its gross fee rate can not evict the least prior tx
+        if (maxSize > 0 && totalTxSize + entry.GetTxSize() > maxSize && !priorityIndex.empty() &&
+            !(*priorityIndex.begin() < CTxMemPoolPriorityKey(txid, entry))) {
+            LogPrint(BCLog::INFO, "mempool is full, txid=%s, fee_per_kb=%.2f\n", txid.GetHex(), entry.GetFeePerKb());
+            return state.Invalid(false, REJECT_INSUFFICIENTFEE, "mempool-full");
+        }
+
+        // the changes of the tx are kept only if the tx stays in the mempool after the least prior txs are evicted
+        CTxMemPoolUndoLogger undoLogger(*cw, txUndo);
+        CCacheSavepoint savepoint(*cw);
+        if (!ExecuteTx(txid, entry, state, memPoolTxs.size(), txUndo))
             return false;
 
-        memPoolTxs.insert(make_pair(txid, entry));
+        auto it = memPoolTxs.insert(make_pair(txid, entry)).first;
+        CBlockIndex *pTip = chainActive.Tip();
+        it->second.UpdateFeePerKb(*cw, pTip->height + 1, GetElementForBurn(pTip));
+        priorityIndex.insert(CTxMemPoolPriorityKey(txid, it->second));
+        totalTxSize += it->second.GetTxSize();
+
+        evictTxids = GetTxsToEvict();
+        if (std::find(evictTxids.begin(), evictTxids.end(), txid) != evictTxids.end()) {
+            LogPrint(BCLog::INFO, "mempool is full, txid=%s, fee_per_kb=%.2f\n", txid.GetHex(),
+                     it->second.GetFeePerKb());
+            priorityIndex.erase(CTxMemPoolPriorityKey(txid, it->second));
+            totalTxSize -= it->second.GetTxSize();
+            memPoolTxs.erase(it);
+            return state.Invalid(false, REJECT_INSUFFICIENTFEE, "mempool-full");
+        }
+
+        savepoint.Commit();
+        METRIC_GAUGE("mempool_tx_count").Add(1);
+        METRIC_GAUGE("mempool_tx_bytes").Set(totalTxSize);
+    }
+    AddTxUndo(std::move(txUndo));
+
+    if (!evictTxids.empty()) {
+        Evict(evictTxids);
+        // the tx is evicted with the evicted txs it depends on
+        if (!memPoolTxs.count(txid))
+            return state.Invalid(false, REJECT_INSUFFICIENTFEE, "mempool-full");
     }
     return true;
 }
 
+// execute the tx in a savepoint of the mempool cache opened by the caller, the changes are op logged into its undo
+bool CTxMemPool::ExecuteTx(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state,
+                           int32_t index, CTxMemPoolUndo &txUndo) {
+    assert(cw->GetSavepointCount() > 0);
+    size_t priceJournalSize = cw->ppCache.GetJournalSize();
+    if (!CheckTxInMemPool(txid, entry, state, index))
+        return false;
+
+    txUndo.hasPriceChanges = cw->ppCache.GetJournalSize() > priceJournalSize;
+    return true;
+}
+
+void CTxMemPool::AddTxUndo(CTxMemPoolUndo &&txUndo) {
+    uint256 txid = txUndo.txid;
+    txUndos.push_back(std::move(txUndo));
+    txUndoIndex[txid] = std::prev(txUndos.end());
+}
+
+// the least prior txs to evict to bring the total size under the limit
+vector<uint256> CTxMemPool::GetTxsToEvict() const {
+    AssertLockHeld(cs);
+    vector<uint256> txids;
+    uint64_t size = totalTxSize;
+    for (auto it = priorityIndex.begin(); maxSize > 0 && size > maxSize && it != priorityIndex.end(); ++it) {
+        txids.push_back(it->txid);
+        size -= memPoolTxs.find(it->txid)->second.GetTxSize();
+    }
+    return txids;
+}
+
+/*
+ * Evict the txs and the txs depending on them, and roll back their changes of the mempool cache. The txs executed
+ * after an evicted tx and writing any key it wrote depend on it, so the evicted txs are rolled back in the reverse
+ * order of execution without touching the changes of the txs kept. The txs only reading the keys of the evicted txs
+ * are dropped by the rescan of the next block if they fail.
+ */
+void CTxMemPool::Evict(const vector<uint256> &txids) {
+    AssertLockHeld(cs);
+    set<uint256> evictTxids(txids.begin(), txids.end());
+    set<pair<string, string>> evictedKeys;  // db prefix, key
+    CBlockUndo evictUndo;
+    bool hasPriceChanges = false;
+    for (const auto &txUndo : txUndos) {
+        const auto &dbOpLogMap = txUndo.dbOpLogMap.GetMap();
+        bool isEvicted = evictTxids.count(txUndo.txid) > 0;
+        for (auto logsIt = dbOpLogMap.begin(); !isEvicted && !evictedKeys.empty() && logsIt != dbOpLogMap.end();
+             ++logsIt) {
+            for (const auto &opLog : logsIt->second) {
+                if (evictedKeys.count(make_pair(logsIt->first, opLog.GetKey()))) {
+                    isEvicted = true;
+                    break;
+                }
+            }
+        }
+        if (!isEvicted)
+            continue;
+
+        for (const auto &item : dbOpLogMap) {
+            for (const auto &opLog : item.second)
+                evictedKeys.emplace(item.first, opLog.GetKey());
+        }
+        evictUndo.vtxundo.emplace_back(txUndo.txid);
+        evictUndo.vtxundo.back().dbOpLogMap = txUndo.dbOpLogMap;
+        hasPriceChanges |= txUndo.hasPriceChanges;
+    }
+
+    // the price points are only journaled in savepoints, execute the txs kept again instead
+    if (!hasPriceChanges && !CBlockUndoExecutor(*cw, evictUndo).Execute())
+        hasPriceChanges = true;
+
+    for (const auto &txUndo : evictUndo.vtxundo) {
+        const uint256 &txid = txUndo.txid;
+        auto it = memPoolTxs.find(txid);
+        if (evictTxids.count(txid)) {
+            LogPrint(BCLog::INFO, "evict txid=%s from the full mempool, fee_per_kb=%.2f\n", txid.GetHex(),
+                     it->second.GetFeePerKb());
+        } else {
+            LogPrint(BCLog::INFO, "evict txid=%s depending on the evicted txs\n", txid.GetHex());
+        }
+        EraseEntry(it);
+        EraseTransactionFromWallet(txid);
+        METRIC_COUNTER("mempool_evicted_txs").Increase();
+    }
+
+    if (hasPriceChanges)
+        ReScanMemPoolTx();
+}
+
 void CTxMemPool::QueryHash(vector<uint256> &txids) {
     LOCK(cs);
 
@@ -110,14 +287,15 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
         return state.Invalid(false, REJECT_INVALID, "tx-duplicate-confirmed");
     }
 
-    auto spCW = std::make_shared<CCacheWrapper>(cw.get());
+    // execute the tx on the mempool cache in place, its changes are rolled back unless committed
+    CCacheSavepoint savepoint(*cw);
 
     if (bRehearsalExecute) { //always true so far
         const auto &bpRegid = GetBlockBpRegid(*chainActive.TipBlock());
         uint32_t fuelRate  = GetElementForBurn(pTip);
         uint32_t blockTime = pTip->GetBlockTime();
         uint32_t prevBlockTime = pTip->pprev != nullptr ? pTip->pprev->GetBlockTime() : pTip->GetBlockTime();
-        CTxExecuteContext context(newHeight, index, fuelRate, blockTime, prevBlockTime, bpRegid, spCW.get(), &state,
+        CTxExecuteContext context(newHeight, index, fuelRate, blockTime, prevBlockTime, bpRegid, cw.get(), &state,
                                 TxExecuteContextType::VALIDATE_MEMPOOL);
 
         if (!tx.ExecuteFullTx(context)) { //rehearsal only within cache env
@@ -127,13 +305,15 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
         }
     }
 
-    spCW->Flush();
+    savepoint.Commit();
 
     return true;
 }
 
 void CTxMemPool::SetMemPoolCache() {
     cw.reset(new CCacheWrapper(pCdMan));
+    txUndos.clear();
+    txUndoIndex.clear();
 }
 
 void CTxMemPool::ReScanMemPoolTx() {
@@ -143,13 +323,33 @@ void CTxMemPool::ReScanMemPoolTx() {
     LOCK(cs);
     CValidationState state;
     int index = 0;
+    CBlockIndex *pTip = chainActive.Tip();
+    int32_t height    = pTip->height + 1;
+    uint32_t fuelRate = GetElementForBurn(pTip);
+    txUndos.clear();
+    txUndoIndex.clear();
     for (map<uint256, CTxMemPoolEntry>::iterator iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end(); ++index) {
-        if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, index, true)) {
+        CTxMemPoolUndo txUndo(iterTx->first);
+        bool executed;
+        {
+            CTxMemPoolUndoLogger undoLogger(*cw, txUndo);
+            CCacheSavepoint savepoint(*cw);
+            executed = ExecuteTx(iterTx->first, iterTx->second, state, index, txUndo);
+            if (executed)
+                savepoint.Commit();
+        }
+        if (!executed) {
             uint256 txid = iterTx->first;
-            iterTx       = memPoolTxs.erase(iterTx++);
+            iterTx       = EraseEntry(iterTx);
             EraseTransactionFromWallet(txid);
             continue;
         }
+        AddTxUndo(std::move(txUndo));
+
+        // the fuel and the fuel rate may change with the new tip, re-rank the tx by its refreshed fee rate
+        priorityIndex.erase(CTxMemPoolPriorityKey(iterTx->first, iterTx->second));
+        iterTx->second.UpdateFeePerKb(*cw, height, fuelRate);
+        priorityIndex.insert(CTxMemPoolPriorityKey(iterTx->first, iterTx->second));
         ++iterTx;
     }
 }
@@ -158,6 +358,12 @@ void CTxMemPool::Clear() {
     LOCK(cs);
 
     memPoolTxs.clear();
+    priorityIndex.clear();
+    txUndos.clear();
+    txUndoIndex.clear();
+    totalTxSize = 0;
+    METRIC_GAUGE("mempool_tx_count").Set(0);
+    METRIC_GAUGE("mempool_tx_bytes").Set(0);
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
@@ -166,6 +372,11 @@ uint64_t CTxMemPool::Size() {
     return memPoolTxs.size();
 }
 
+uint64_t CTxMemPool::GetTotalTxSize() {
+    LOCK(cs);
+    return totalTxSize;
+}
+
 bool CTxMemPool::Exists(const uint256 txid) {
     LOCK(cs);
     return ((memPoolTxs.count(txid) != 0));
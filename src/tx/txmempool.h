@@ -7,6 +7,7 @@
 #ifndef COIN_TXMEMPOOL_H
 #define COIN_TXMEMPOOL_H
 
+#include "config/scoin.h"
 #include "entities/account.h"
 #include "persistence/cachewrapper.h"
 #include "sync.h"
@@ -14,6 +15,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 
 using namespace std;
 
@@ -30,6 +32,7 @@ private:
     std::pair<TokenSymbol, uint64_t> nFees;  // Cached to avoid expensive parent-transaction lookups
     uint32_t nTxSize;                     // Cached to avoid recomputing tx size
     double dPriority;                     // Cached to avoid recomputing priority
+    double dFeePerKb;                     // Fee rate net of the fuel fee, refreshed on each execution in mempool
 
     int64_t nTime;     // Local time when entering the mempool
     uint32_t height;  // Chain height when entering the mempool
@@ -44,11 +47,49 @@ public:
     inline std::pair<TokenSymbol, uint64_t> GetFees() const { return nFees; }
     inline uint32_t GetTxSize() const { return nTxSize; }
     inline double GetPriority() const { return dPriority; }
+    inline double GetFeePerKb() const { return dFeePerKb; }
+    void UpdateFeePerKb(CCacheWrapper &cw, int32_t height, uint32_t fuelRate);
 
     inline int64_t GetTime() const { return nTime; }
     inline uint32_t GetHeight() const { return height; }
 };
 
+/*
+ * Key of the mempool priority index. The txs up to the priority ceiling compete by their fee rates,
+ * while the system txs above the ceiling (e.g. price feed) rank by their priority levels.
+ */
+struct CTxMemPoolPriorityKey {
+    int32_t priorityLevel;
+    double feePerKb;
+    uint256 txid;
+
+    CTxMemPoolPriorityKey(const uint256 &txidIn, const CTxMemPoolEntry &entry)
+        : priorityLevel(GetPriorityLevel(entry.GetPriority())), feePerKb(entry.GetFeePerKb()), txid(txidIn) {}
+
+    static int32_t GetPriorityLevel(double priority) {
+        return priority <= TRANSACTION_PRIORITY_CEILING ? 0 : int32_t(priority / TRANSACTION_PRIORITY_CEILING);
+    }
+
+    bool operator<(const CTxMemPoolPriorityKey &other) const {
+        if (priorityLevel != other.priorityLevel)
+            return priorityLevel < other.priorityLevel;
+        if (feePerKb != other.feePerKb)
+            return feePerKb < other.feePerKb;
+        return txid < other.txid;
+    }
+};
+
+/*
+ * The changes of a tx executed on the mempool cache, to roll them back when the tx is evicted.
+ */
+struct CTxMemPoolUndo {
+    uint256 txid;
+    CDBOpLogMap dbOpLogMap;
+    bool hasPriceChanges = false;  // the price points are not op logged, they are only journaled in savepoints
+
+    explicit CTxMemPoolUndo(const uint256 &txidIn) : txid(txidIn) {}
+};
+
 /*
  * CTxMemPool stores valid-according-to-the-current-best-chain
  * transactions that may be included in the next block.
@@ -63,6 +104,7 @@ class CTxMemPool {
 public:
     mutable CCriticalSection cs;
     map<uint256, CTxMemPoolEntry > memPoolTxs;
+    set<CTxMemPoolPriorityKey> priorityIndex;  // ascending order, the most prior tx is the last one
     std::shared_ptr<CCacheWrapper> cw;
 
 public:
@@ -70,9 +112,11 @@ public:
 
 public:
     void SetSanityCheck(bool fSanityCheckIn) { fSanityCheck = fSanityCheckIn; }
+    void SetMaxSize(uint64_t maxSizeIn) { maxSize = maxSizeIn; }
     bool AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state);
     void Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive = false);
     void Remove(const uint256 &txid);
+    void RemoveForBlock(const vector<std::shared_ptr<CBaseTx> > &vptx);
     void QueryHash(vector<uint256> &txids);
     bool CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state, int32_t index,
                           bool bRehearsalExecute = true);
@@ -81,11 +125,25 @@ public:
     void Clear();
 
     uint64_t Size();
+    uint64_t GetTotalTxSize();
     bool Exists(const uint256 txid);
     std::shared_ptr<CBaseTx> Lookup(const uint256 txid) const;
 
+private:
+    map<uint256, CTxMemPoolEntry>::iterator EraseEntry(map<uint256, CTxMemPoolEntry>::iterator it);
+    bool ExecuteTx(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state, int32_t index,
+                   CTxMemPoolUndo &txUndo);
+    void AddTxUndo(CTxMemPoolUndo &&txUndo);
+    vector<uint256> GetTxsToEvict() const;
+    void Evict(const vector<uint256> &txids);
+
 private:
     bool fSanityCheck; // Normally false, true if -checkmempool or -regtest
+    uint64_t maxSize;       // Max total size of the txs in bytes, 0 means unlimited
+    uint64_t totalTxSize;   // Total size of the txs in bytes
+
+    list<CTxMemPoolUndo> txUndos;  // in the order the txs are executed on the mempool cache
+    map<uint256, list<CTxMemPoolUndo>::iterator> txUndoIndex;
 };
 
 
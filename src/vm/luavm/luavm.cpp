@@ -18,6 +18,7 @@
 #include "main.h"
 #include "tx/tx.h"
 #include "luavmrunenv.h"
+#include "commons/util/util.h"
 
 #if 0
 typedef struct NumArray{
@@ -191,6 +192,145 @@ tuple<bool, string> CLuaVM::CheckScriptSyntax(const char *filePath, HeightType h
     return std::make_tuple(true, string("OK"));
 }
 
+#ifdef TRACE_LUA_VM_BURN
+void TraceVmBurning(lua_State *L, const char* caption, const char* format, ...);
+#endif//TRACE_LUA_VM_BURN
+
+void CLuaStateDeleter::operator()(lua_State *L) const { lua_close(L); }
+
+CLuaStatePtr CLuaVM::OpenState(int32_t burnVersion, lua_CFunction mylib, uint64_t fuelLimit, void *pContext,
+                               string &strError) {
+    // 1.创建Lua运行环境
+    CLuaStatePtr lua_state_ptr(luaL_newstate());
+    if (!lua_state_ptr) {
+        LogPrint(BCLog::LUAVM, "luaL_newstate() failed\n");
+        strError = "CLuaVM::Run luaL_newstate() failed\n";
+        return nullptr;
+    }
+    lua_State *lua_state = lua_state_ptr.get();
+
+    if (!lua_StartBurner(lua_state, pContext, fuelLimit, burnVersion)) {
+        LogPrint(BCLog::LUAVM, "lua_StartBurner() failed\n");
+        strError = "CLuaVM::Run lua_StartBurner() failed\n";
+        return nullptr;
+    }
+
+#ifdef TRACE_LUA_VM_BURN
+    lua_SetBurnerTracer(lua_state, TraceVmBurning);
+#endif//TRACE_LUA_VM_BURN
+
+    //打开需要的库
+    vm_openlibs(lua_state);
+
+    if (!InitLuaLibsEx(lua_state)) {
+        LogPrint(BCLog::LUAVM, "InitLuaLibsEx error\n");
+        strError = "InitLuaLibsEx error\n";
+        return nullptr;
+    }
+
+    // 3.注册自定义模块
+    luaL_requiref(lua_state, "mylib", mylib, 1);
+
+    return lua_state_ptr;
+}
+
+CLuaStatePool::~CLuaStatePool() { Stop(); }
+
+CLuaStatePool &CLuaStatePool::Instance() {
+    static CLuaStatePool luaStatePool;
+    return luaStatePool;
+}
+
+CLuaStatePtr CLuaStatePool::Get(int32_t burnVersionIn, lua_CFunction mylibIn, uint64_t fuelLimit, void *pContext) {
+    CLuaStatePtr lua_state_ptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping)
+            return nullptr;
+
+        if (burnVersion != burnVersionIn || mylib != mylibIn) {
+            // the states of the previous feature fork version are never used
+            Clear();
+            burnVersion = burnVersionIn;
+            mylib       = mylibIn;
+        }
+        if (!states.empty()) {
+            lua_state_ptr.reset(states.front());
+            states.pop_front();
+        }
+
+        if (!worker.joinable())
+            worker = std::thread(&CLuaStatePool::ThreadPrepare, this);
+        cond.notify_one();
+    }
+
+    if (!lua_state_ptr) {
+        METRIC_COUNTER("luavm_state_pool_misses").Increase();
+        return nullptr;
+    }
+
+    // the fuel of opening the libs is burned already, the call opens its own state to fail as before if over limit
+    lua_burner_state *burnerState = lua_GetBurnerState(lua_state_ptr.get());
+    burnerState->pContext  = pContext;
+    burnerState->fuelLimit = fuelLimit;
+    if (lua_IsBurnedOut(lua_state_ptr.get())) {
+        METRIC_COUNTER("luavm_state_pool_misses").Increase();
+        return nullptr;
+    }
+
+    METRIC_COUNTER("luavm_state_pool_hits").Increase();
+    return lua_state_ptr;
+}
+
+void CLuaStatePool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cond.notify_all();
+    if (worker.joinable())
+        worker.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Clear();
+}
+
+void CLuaStatePool::Clear() {
+    for (auto lua_state : states)
+        lua_close(lua_state);
+    states.clear();
+}
+
+void CLuaStatePool::ThreadPrepare() {
+    RenameThread("coin-luastates");
+    while (true) {
+        int32_t version;
+        lua_CFunction lib;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this]() { return stopping || states.size() < LUA_STATE_POOL_SIZE; });
+            if (stopping)
+                return;
+            version = burnVersion;
+            lib     = mylib;
+        }
+
+        string strError;
+        CLuaStatePtr lua_state_ptr = CLuaVM::OpenState(version, lib, std::numeric_limits<uint64_t>::max(), nullptr,
+                                                       strError);
+        if (!lua_state_ptr) {
+            LogPrint(BCLog::LUAVM, "prepare lua state failed: %s", strError);
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait_for(lock, std::chrono::seconds(1), [this]() { return stopping; });
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (version == burnVersion && lib == mylib)
+            states.push_back(lua_state_ptr.release());
+    }
+}
+
 static void ReportBurnState(lua_State *L, CLuaVMRunEnv *pVmRunEnv) {
 
     lua_burner_state *burnerState = lua_GetBurnerState(L);
@@ -255,34 +395,18 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
         return std::make_tuple(-1, string("pVmRunEnv == NULL"));
     }
 
-    // 1.创建Lua运行环境
-    std::unique_ptr<lua_State, decltype(&lua_close)> lua_state_ptr(luaL_newstate(), &lua_close);
+    int64_t beginTime            = GetTimeMicros();
+    int32_t burnVersion          = pVmRunEnv->GetBurnVersion();
+    lua_CFunction mylib          = GetLuaMylib(pVmRunEnv->GetContext().height);
+    CLuaStatePtr lua_state_ptr   = CLuaStatePool::Instance().Get(burnVersion, mylib, fuelLimit, pVmRunEnv);
     if (!lua_state_ptr) {
-        LogPrint(BCLog::LUAVM, "luaL_newstate() failed\n");
-        return std::make_tuple(-1, string("CLuaVM::Run luaL_newstate() failed\n"));
+        string strError;
+        lua_state_ptr = OpenState(burnVersion, mylib, fuelLimit, pVmRunEnv, strError);
+        if (!lua_state_ptr)
+            return std::make_tuple(-1, strError);
     }
     lua_State *lua_state = lua_state_ptr.get();
 
-    if (!lua_StartBurner(lua_state, pVmRunEnv, fuelLimit, pVmRunEnv->GetBurnVersion())) {
-        LogPrint(BCLog::LUAVM, "lua_StartBurner() failed\n");
-        return std::make_tuple(-1, string("CLuaVM::Run lua_StartBurner() failed\n"));
-    }
-
-#ifdef TRACE_LUA_VM_BURN
-    lua_SetBurnerTracer(lua_state, TraceVmBurning);
-#endif//TRACE_LUA_VM_BURN
-
-    //打开需要的库
-    vm_openlibs(lua_state);
-
-    if (!InitLuaLibsEx(lua_state)) {
-        LogPrint(BCLog::LUAVM, "InitLuaLibsEx error\n");
-        return std::make_tuple(-1, string("InitLuaLibsEx error\n"));
-    }
-
-    // 3.注册自定义模块
-    luaL_requiref(lua_state, "mylib", GetLuaMylib(pVmRunEnv->GetContext().height), 1);
-
     // 4.往lua脚本传递合约内容
     lua_newtable(lua_state);  //新建一个表,压入栈顶
     lua_pushnumber(lua_state, -1);
@@ -331,6 +455,7 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
 
     uint64_t burnedFuel = lua_GetBurnedFuel(lua_state);
     ReportBurnState(lua_state, pVmRunEnv);
+    METRIC_HISTOGRAM("luavm_run").Record(GetTimeMicros() - beginTime);
     if (burnedFuel > fuelLimit) {
         return std::make_tuple(-1, string("CLuaVM::Run burned-out\n"));
     }
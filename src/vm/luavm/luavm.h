@@ -8,14 +8,58 @@
 
 #include "commons/types.h"
 
+#include <condition_variable>
 #include <cstdio>
+#include <deque>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
 
 class CLuaVMRunEnv;
+struct lua_State;
+typedef int (*lua_CFunction) (lua_State *L);
+
+/** Max number of the lua states opened ahead of the contract calls */
+static const uint32_t LUA_STATE_POOL_SIZE = 8;
+
+struct CLuaStateDeleter {
+    void operator()(lua_State *L) const;
+};
+typedef std::unique_ptr<lua_State, CLuaStateDeleter> CLuaStatePtr;
+
+/**
+ * The lua states opened with the libs of the current burn version by a background thread, so a contract call only
+ * loads and runs its script. The burner is started before the libs are opened just like a state opened by the call,
+ * and a state is used by one call only, so the fuel burned by a call does not change.
+ */
+class CLuaStatePool {
+public:
+    ~CLuaStatePool();
+
+    static CLuaStatePool &Instance();
+
+    /** Take a state opened with the mylib of the burn version, nullptr if none is ready */
+    CLuaStatePtr Get(int32_t burnVersion, lua_CFunction mylib, uint64_t fuelLimit, void *pContext);
+    void Stop();
+
+private:
+    void ThreadPrepare();
+    void Clear();
+
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<lua_State *> states;
+    int32_t burnVersion  = 0;
+    lua_CFunction mylib  = nullptr;
+    std::thread worker;
+    bool stopping = false;
+};
 
 class CLuaVM {
 public:
@@ -23,6 +67,9 @@ public:
     ~CLuaVM();
 
     std::tuple<uint64_t, string> Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv);
+    /** Open a state with the burner started and the libs of the burn version */
+    static CLuaStatePtr OpenState(int32_t burnVersion, lua_CFunction mylib, uint64_t fuelLimit, void *pContext,
+                                  string &strError);
     static std::tuple<bool, string> CheckScriptSyntax(const char *filePath, HeightType height);
 
 private:
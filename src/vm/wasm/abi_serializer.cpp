@@ -1,4 +1,5 @@
 #include <chrono>
+#include <mutex>
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
 
 //#include <wasm/exceptions.hpp>
@@ -14,6 +15,7 @@
 #include <boost/lexical_cast.hpp>
 
 #include "commons/json/json_spirit_writer.h"
+#include "commons/lrucache.hpp"
 
 using namespace boost;
 using namespace wasm;
@@ -71,6 +73,30 @@ namespace wasm {
         set_abi(abi, max_serialization_time);
     }
 
+    // the serializers of the contracts used recently, the abi bytes are the key to never mismatch an abi
+    static const uint32_t max_cached_abi_serializers = 256;
+
+    std::shared_ptr<const abi_serializer> abi_serializer::get_cached( const std::vector<char> &abi,
+                                                                     microseconds max_serialization_time ) {
+        static std::mutex cache_mutex;
+        static CLruCache<string, std::shared_ptr<const abi_serializer>> cache(max_cached_abi_serializers);
+
+        string key(abi.begin(), abi.end());
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto cached = cache.Get(key);
+            if (cached != nullptr) return *cached;
+        }
+
+        // built out of the lock, an invalid abi throws and is not cached
+        wasm::abi_def def = wasm::unpack<wasm::abi_def>(abi);
+        auto abis_ptr = std::make_shared<const abi_serializer>(def, max_serialization_time);
+
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache.Insert(key, abis_ptr);
+        return abis_ptr;
+    }
+
     void abi_serializer::add_specialized_unpack_pack( const string &name,
                                                       std::pair <abi_serializer::unpack_function, abi_serializer::pack_function> unpack_pack ) {
         built_in_types[name] = std::move(unpack_pack);
@@ -263,8 +289,8 @@ namespace wasm {
         vector<char> data(1024 * 1024);
         try {
 
-            wasm::abi_def def = wasm::unpack<wasm::abi_def>(abi);
-            wasm::abi_serializer abis(def, max_serialization_time);
+            auto abis_ptr = get_cached(abi, max_serialization_time);
+            const abi_serializer &abis = *abis_ptr;
             wasm::abi_traverse_context ctx(max_serialization_time);
             wasm::datastream<char *> ds(data.data(), data.size());
             for ( const auto &item : keys) {
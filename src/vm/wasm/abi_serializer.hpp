@@ -3,6 +3,7 @@
 #include <map>
 #include <string>
 #include <functional>
+#include <memory>
 #include <utility>
 #include <chrono>
 
@@ -72,14 +73,21 @@ namespace wasm {
         json_spirit::Value get_field_variant( const type_name &s, const json_spirit::Value &v, field_name field, bool is_optional ) const;
         json_spirit::Value get_field_variant( const type_name &s, const json_spirit::Value &v, uint32_t index ) const;
 
+        /**
+         *  The serializer of the abi, built once and shared by the later calls with the same abi. A contract changes
+         *  its abi only by setcode, which makes a new key, so a cached serializer is never stale.
+         */
+        static std::shared_ptr<const abi_serializer> get_cached( const std::vector<char> &abi,
+                                                                 microseconds max_serialization_time );
+
         static std::vector<char>
         pack( const std::vector<char> &abi, const string &action, const string &params, microseconds max_serialization_time ) {
 
             vector<char> data;
             try {
 
-                wasm::abi_def def = wasm::unpack<wasm::abi_def>(abi);
-                wasm::abi_serializer abis(def, max_serialization_time);
+                auto abis_ptr = get_cached(abi, max_serialization_time);
+                const abi_serializer &abis = *abis_ptr;
 
                 json_spirit::Value data_v;
                 json_spirit::read_string_or_throw(params, data_v);
@@ -104,8 +112,8 @@ namespace wasm {
            vector<char> data;
            try {
 
-                wasm::abi_def def = wasm::unpack<wasm::abi_def>(abi);
-                wasm::abi_serializer abis(def, max_serialization_time);
+                auto abis_ptr = get_cached(abi, max_serialization_time);
+                const abi_serializer &abis = *abis_ptr;
                 string action_type = abis.get_action_type(action);
                 if(action_type == string()){
                     action_type = action;
@@ -127,8 +135,8 @@ namespace wasm {
 
             json_spirit::Value data_v;
             try {
-                wasm::abi_def def = wasm::unpack<wasm::abi_def>(abi);
-                wasm::abi_serializer abis(def, max_serialization_time);
+                auto abis_ptr = get_cached(abi, max_serialization_time);
+                const abi_serializer &abis = *abis_ptr;
 
                 string action_type = abis.get_action_type(action);
                 if(action_type == string()){
@@ -149,8 +157,8 @@ namespace wasm {
             type_name name;
             try {
 
-                wasm::abi_def def = wasm::unpack<wasm::abi_def>(abi);
-                wasm::abi_serializer abis(def, max_serialization_time);
+                auto abis_ptr = get_cached(abi, max_serialization_time);
+                const abi_serializer &abis = *abis_ptr;
 
                 string t = wasm::name(table).to_string();
                 name = abis.get_table_type(t);
@@ -171,8 +179,8 @@ namespace wasm {
             json_spirit::Value data_v;
             try {
 
-                wasm::abi_def def = wasm::unpack<wasm::abi_def>(abi);
-                wasm::abi_serializer abis(def, max_serialization_time);
+                auto abis_ptr = get_cached(abi, max_serialization_time);
+                const abi_serializer &abis = *abis_ptr;
 
 
                 data_v = abis.binary_to_variant(name, data, max_serialization_time);
@@ -104,8 +104,10 @@ namespace eosio { namespace vm {
          switch(sig) {
           case SIGSEGV:
           case SIGBUS:
-          case SIGFPE:
             break;
+          case SIGFPE:
+            // the jit traps the integer division by zero or overflow in hardware, fails it as the interpreter does
+            throw wasm_interpreter_exception{ "integer divide by zero or overflow" };
           default:
             /* TODO fix this */
             assert(!"??????");
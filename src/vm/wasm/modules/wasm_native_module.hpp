@@ -152,6 +152,11 @@ namespace wasm {
 		                      "save contract '%s' error",
 		                      contractRegId.ToString())
 
+				// instantiate the module in background before its first execution
+				if (contractStore.vm_type == VMType::WASM_VM)
+					wasm_interface::preload(contractRegId.GetIntValue(), vector<uint8_t>(code.begin(), code.end()),
+											contractStore.code_hash);
+
 		    }
 
 			static void setcoder(wasm_context &context) {
@@ -1581,6 +1581,47 @@ BOOST_AUTO_TEST_CASE( abi_token ) {
 
 }
 
+BOOST_AUTO_TEST_CASE( abi_cached_serializer ) {
+
+    string abi;
+
+    char byte;
+    ifstream f("token.abi", ios::binary);
+    while (f.get(byte)) abi.push_back(byte);
+
+    wasm::variant var_abi;
+    json_spirit::read_string(abi, var_abi);
+    wasm::abi_def def;
+    wasm::from_variant(var_abi, def);
+    auto abiJson = wasm::pack<wasm::abi_def>(def);
+
+    auto abis_ptr = wasm::abi_serializer::get_cached(abiJson, max_serialization_time_testing);
+    WASM_TEST(abis_ptr == wasm::abi_serializer::get_cached(abiJson, max_serialization_time_testing), "abi_cached_serializer.shared")
+
+    // the rows of table accounts unpacked by a new serializer each as before, and by the cached one
+    string param = string(R"({"owner":"walker","balance":"100.00000000 BTC"})");
+    auto row = wasm::abi_serializer::pack(abiJson, "account", param, max_serialization_time_testing);
+    const int rows = 2000;
+
+    auto begin = system_clock::now();
+    for (int i = 0; i < rows; i++) {
+        wasm::abi_serializer abis(wasm::unpack<wasm::abi_def>(abiJson), max_serialization_time_testing);
+        abis.binary_to_variant(abis.get_table_type("accounts"), row, max_serialization_time_testing);
+    }
+    auto uncached_us = std::chrono::duration_cast<microseconds>(system_clock::now() - begin).count();
+
+    json_spirit::Value var;
+    begin = system_clock::now();
+    for (int i = 0; i < rows; i++) {
+        var = wasm::abi_serializer::unpack(abiJson, wasm::name("accounts").value, row, max_serialization_time_testing);
+    }
+    auto cached_us = std::chrono::duration_cast<microseconds>(system_clock::now() - begin).count();
+    WASM_TEST(param == json_spirit::write(var), "abi_cached_serializer.unpack")
+
+    WASM_TRACE("rows/s of table accounts: uncached %lld, cached %lld",
+               rows * 1000000LL / std::max<int64_t>(uncached_us, 1), rows * 1000000LL / std::max<int64_t>(cached_us, 1))
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
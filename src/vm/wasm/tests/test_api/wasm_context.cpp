@@ -3,6 +3,7 @@
 #include "wasm/exception/exceptions.hpp"
 #include "wasm/types/name.hpp"
 #include "wasm/wasm_constants.hpp"
+#include "crypto/hash.h"
 
 using namespace std;
 using namespace wasm;
@@ -97,11 +98,7 @@ namespace wasm {
 
     void wasm_context::initialize() {
 
-        static bool wasm_interface_inited = false;
-        if (!wasm_interface_inited) {
-            wasm_interface_inited = true;
-            wasmif.initialize(wasm::vm_type::eos_vm_jit);
-        }
+        wasmif.initialize(wasm_interface::get_vm_type());
         //RegisterNativeHandler(wasmio, NAME(setcode), WasmNativeSetcode);
         //RegisterNativeHandler(wasmio_bank, NAME(transfer), WasmNativeTransfer);
     }
@@ -142,7 +139,7 @@ namespace wasm {
         try {
             vector <uint8_t> code;
             if (get_code(_receiver, code) && code.size() > 0)
-                wasmif.execute(code, this);
+                wasmif.execute(code, HashOnce(code.data(), code.size()), this);
         }
         CHAIN_RETHROW_EXCEPTIONS( wasm_exception, "pending console output: %s", _pending_console_output.str() )
 
@@ -22,6 +22,8 @@ namespace wasm {
     const static uint32_t max_wasm_api_data_bytes       = 1024*1024;
     const static uint16_t max_inline_transactions_size  = 1024;
     const static uint16_t max_signatures_size           = 64;
+    const static uint32_t default_wasm_module_cache_size = 256*1024*1024;//bytes of the instantiated modules
+    const static uint16_t max_wasm_preload_jobs         = 256;
 
     static const uint64_t wasmio                        = REGID(0, 100); //0-100
     static const uint64_t wasmio_bank                   = REGID(0, 800); //0-800
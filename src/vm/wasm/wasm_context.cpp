@@ -102,7 +102,7 @@ namespace wasm {
 
     void wasm_context::initialize() {
 
-    	wasmif.initialize(wasm::vm_type::eos_vm_jit);
+    	wasmif.initialize(wasm_interface::get_vm_type());
 
         // static bool wasm_interface_inited = false;
         // if (!wasm_interface_inited) {
@@ -103,7 +103,7 @@ namespace wasm {
 
     void wasm_context_rpc::initialize() {
 
-        wasmif.initialize(wasm::vm_type::eos_vm_jit);
+        wasmif.initialize(wasm_interface::get_vm_type());
 
         // static bool wasm_interface_rpc_inited = false;
         // if (!wasm_interface_rpc_inited) {
@@ -15,9 +15,17 @@
 #include "wasm/exception/exceptions.hpp"
 
 #include "crypto/hash.h"
+#include "commons/lrucache.hpp"
+#include "commons/util/util.h"
 #include <openssl/ripemd.h>
 #include <openssl/sha.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 using namespace eosio;
 using namespace eosio::vm;
 
@@ -37,44 +45,218 @@ namespace wasm {
     using backend_validate_t = backend<wasm::wasm_context_interface, vm::interpreter>;
     using rhf_t              = eosio::vm::registered_host_functions<wasm_context_interface>;
 
-    std::optional<std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>>& get_wasm_instantiation_cache(){
-        static std::optional<std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>> wasm_instantiation_cache;
-        return wasm_instantiation_cache;
+    std::atomic<vm_type>& get_current_vm_type() {
+        static std::atomic<vm_type> current_vm_type(default_vm_type);
+        return current_vm_type;
     }
 
-    std::shared_ptr <wasm_runtime_interface>& get_runtime_interface(){
-        static std::shared_ptr <wasm_runtime_interface> runtime_interface;
+    // a runtime for each vm, created on first use, so the contracts can be executed by both of them in one process
+    std::shared_ptr <wasm_runtime_interface> get_runtime_interface(vm_type vm) {
+        static std::mutex runtime_mutex;
+        static std::shared_ptr <wasm_runtime_interface> runtime_interfaces[2];
+
+        std::lock_guard<std::mutex> lock(runtime_mutex);
+        auto &runtime_interface = runtime_interfaces[vm == vm_type::eos_vm_jit ? 1 : 0];
+        if (runtime_interface == nullptr) {
+            if (vm == vm_type::eos_vm_jit)
+                runtime_interface = std::make_shared<wasm::wasm_vm_runtime<vm::jit>>();
+            else
+                runtime_interface = std::make_shared<wasm::wasm_vm_runtime<vm::interpreter>>();
+        }
         return runtime_interface;
     }
 
+    // the instantiated modules by vm and code hash, bounded by the memory of the modules
+    class wasm_module_cache {
+    public:
+        struct entry {
+            uint64_t contract     = 0;
+            uint32_t memory_usage = 0;
+            std::shared_ptr<wasm_instantiated_module_interface> module;
+        };
+        using cache_t = CLruCache<string, entry>;
+
+        wasm_module_cache() : cache(default_wasm_module_cache_size, [](const cache_t::Item &item) {
+            return item.second.memory_usage;
+        }) {}
+
+        std::shared_ptr<wasm_instantiated_module_interface> get(vm_type vm, const code_version_t &hash) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto p_entry = cache.Get(to_key(vm, hash));
+            if (p_entry == nullptr) {
+                METRIC_COUNTER("wasm_module_cache_misses").Increase();
+                return nullptr;
+            }
+            METRIC_COUNTER("wasm_module_cache_hits").Increase();
+            return p_entry->module;
+        }
 
-    wasm_interface::wasm_interface() {}
-    wasm_interface::~wasm_interface() {}
+        bool exists(vm_type vm, const code_version_t &hash) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return cache.Exists(to_key(vm, hash));
+        }
 
-    void wasm_interface::exit() {
-        get_runtime_interface()->immediately_exit_currently_running_module();
+        void put(vm_type vm, const code_version_t &hash, uint64_t contract,
+                 const std::shared_ptr<wasm_instantiated_module_interface> &module) {
+            entry e;
+            e.contract     = contract;
+            e.memory_usage = (uint32_t)std::min<size_t>(module->get_memory_usage(), std::numeric_limits<uint32_t>::max());
+            e.module       = module;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            uint64_t evicted_count = cache.GetEvictedCount();
+            cache.Insert(to_key(vm, hash), e);
+            update_metrics(evicted_count);
+        }
+
+        void set_max_size(uint32_t max_bytes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            uint64_t evicted_count = cache.GetEvictedCount();
+            cache.SetMaxSize(max_bytes);
+            update_metrics(evicted_count);
+        }
+
+        vector<uint64_t> get_contracts() {
+            std::lock_guard<std::mutex> lock(mutex);
+            vector<uint64_t> contracts;
+            for (const auto &item : cache.GetQueue())
+                contracts.push_back(item.second.contract);
+            return contracts;
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            cache.Clear();
+            update_metrics(cache.GetEvictedCount());
+        }
+
+    private:
+        static string to_key(vm_type vm, const code_version_t &hash) {
+            return string(1, (char)vm) + string((const char*)hash.begin(), hash.size());
+        }
+
+        void update_metrics(uint64_t prev_evicted_count) {
+            METRIC_COUNTER("wasm_module_cache_evictions").Increase(cache.GetEvictedCount() - prev_evicted_count);
+            METRIC_GAUGE("wasm_module_cache_count").Set(cache.GetCount());
+            METRIC_GAUGE("wasm_module_cache_bytes").Set(cache.GetSize());
+        }
+
+    private:
+        std::mutex mutex;
+        cache_t    cache;
+    };
+
+    wasm_module_cache& get_module_cache() {
+        static wasm_module_cache module_cache;
+        return module_cache;
     }
 
-    std::shared_ptr <wasm_instantiated_module_interface> get_instantiated_backend(const vector <uint8_t> &code, const uint256 &hash) {
+    std::shared_ptr <wasm_instantiated_module_interface> instantiate_module(vm_type vm, uint64_t contract,
+                                                                            const vector <uint8_t> &code,
+                                                                            const uint256 &hash) {
+        int64_t begin_time = GetTimeMicros();
+        auto module = get_runtime_interface(vm)->instantiate_module((const char*)code.data(), code.size());
+        if (vm == vm_type::eos_vm_jit)
+            METRIC_HISTOGRAM("wasm_module_instantiate_jit").Record(GetTimeMicros() - begin_time);
+        else
+            METRIC_HISTOGRAM("wasm_module_instantiate").Record(GetTimeMicros() - begin_time);
+        get_module_cache().put(vm, hash, contract, module);
+        return module;
+    }
 
-        try {
-            auto bm_wasm_hash = MAKE_BENCHMARK("load wasm vm -- load code hash");
-            if (!get_wasm_instantiation_cache().has_value()){
-                 get_wasm_instantiation_cache() = std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>{};
+    // instantiates the modules of the contracts deployed or used before restart in a background thread
+    class wasm_module_preloader {
+    public:
+        ~wasm_module_preloader() { stop(); }
+
+        void push(vm_type vm, uint64_t contract, const vector <uint8_t> &code, const uint256 &hash) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || jobs.size() >= max_wasm_preload_jobs)
+                return;
+
+            jobs.push_back({vm, contract, code, hash});
+            if (!worker.joinable())
+                worker = std::thread(&wasm_module_preloader::run, this);
+            cond.notify_one();
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                jobs.clear();
             }
+            cond.notify_all();
+            if (worker.joinable())
+                worker.join();
+        }
+
+    private:
+        struct job {
+            vm_type vm;
+            uint64_t contract;
+            vector <uint8_t> code;
+            uint256 hash;
+        };
 
-            if (bm_wasm_hash) bm_wasm_hash->end();
-            auto it = get_wasm_instantiation_cache()->find(hash);
-            if (it == get_wasm_instantiation_cache()->end()) {
-                auto bm_wasm_load = MAKE_BENCHMARK("load wasm vm -- init module");
-                get_wasm_instantiation_cache().value()[hash] = get_runtime_interface()->instantiate_module((const char*)code.data(), code.size());
-                return get_wasm_instantiation_cache().value()[hash];
+        void run() {
+            RenameThread("coin-wasmpreload");
+            while (true) {
+                job j;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cond.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                    if (stopping)
+                        return;
+                    j = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+
+                if (get_module_cache().exists(j.vm, j.hash))
+                    continue;
+                try {
+                    instantiate_module(j.vm, j.contract, j.code, j.hash);
+                    METRIC_COUNTER("wasm_module_preloads").Increase();
+                } catch (wasm_chain::exception &e) {
+                    LogPrint(BCLog::WASM, "preload module of contract %s failed: %s\n",
+                             wasm::regid(j.contract).to_string(), e.to_detail_string());
+                } catch (std::exception &e) {
+                    LogPrint(BCLog::WASM, "preload module of contract %s failed: %s\n",
+                             wasm::regid(j.contract).to_string(), e.what());
+                }
             }
-            return it->second;
-        } catch (...) {
-            throw;
         }
 
+    private:
+        std::mutex              mutex;
+        std::condition_variable cond;
+        std::deque<job>         jobs;
+        std::thread             worker;
+        bool                    stopping = false;
+    };
+
+    wasm_module_preloader& get_module_preloader() {
+        static wasm_module_preloader module_preloader;
+        return module_preloader;
+    }
+
+
+    wasm_interface::wasm_interface() {}
+    wasm_interface::~wasm_interface() {}
+
+    void wasm_interface::exit() {
+        get_runtime_interface(vm)->immediately_exit_currently_running_module();
+    }
+
+    std::shared_ptr <wasm_instantiated_module_interface> get_instantiated_backend(vm_type vm, uint64_t contract,
+                                                                                  const vector <uint8_t> &code,
+                                                                                  const uint256 &hash) {
+        auto module = get_module_cache().get(vm, hash);
+        if (module == nullptr) {
+            auto bm_wasm_load = MAKE_BENCHMARK("load wasm vm -- init module");
+            module = instantiate_module(vm, contract, code, hash);
+        }
+        return module;
     }
 
     void wasm_interface::execute(const vector <uint8_t> &code, const uint256 &hash, wasm_context_interface *pWasmContext) {
@@ -82,9 +264,9 @@ namespace wasm {
 
         auto bm_wasm_load = MAKE_BENCHMARK("load wasm vm with code");
         pWasmContext->pause_billing_timer();
-        auto pInstantiated_module = get_instantiated_backend(code, hash);
+        auto pInstantiated_module = get_instantiated_backend(vm, pWasmContext->receiver(), code, hash);
         pWasmContext->resume_billing_timer();
-        if (bm_wasm_load) bm_wasm_load->end();
+        bm_wasm_load.end();
 
         auto bm_wasm_exec = MAKE_BENCHMARK("execute wasm vm with code");
         pInstantiated_module->apply(pWasmContext);
@@ -106,19 +288,46 @@ namespace wasm {
     }
 
     void wasm_interface::initialize(vm_type vm) {
+        this->vm = (vm == vm_type::eos_vm_jit && !wasm_jit_supported) ? vm_type::eos_vm : vm;
+    }
 
-        static bool wasm_interface_inited = false;
-        if(!wasm_interface_inited){
-            wasm_interface_inited = true;
+    void wasm_interface::set_vm_type(vm_type vm) {
+        get_current_vm_type() = (vm == vm_type::eos_vm_jit && !wasm_jit_supported) ? vm_type::eos_vm : vm;
+    }
+
+    vm_type wasm_interface::get_vm_type() {
+        return get_current_vm_type();
+    }
 
-	        if (vm == wasm::vm_type::eos_vm)
-	            get_runtime_interface() = std::make_shared<wasm::wasm_vm_runtime<vm::interpreter>>();
-	        else if (vm == wasm::vm_type::eos_vm_jit)
-	            get_runtime_interface() = std::make_shared<wasm::wasm_vm_runtime<vm::jit>>();
-	        else
-	            get_runtime_interface() = std::make_shared<wasm::wasm_vm_runtime<vm::interpreter>>();
-    	}
+    bool wasm_interface::parse_vm_type(const string &name, vm_type &vm) {
+        if (name == "interpreter") {
+            vm = vm_type::eos_vm;
+            return true;
+        }
+        if (name == "jit" && wasm_jit_supported) {
+            vm = vm_type::eos_vm_jit;
+            return true;
+        }
+        return false;
+    }
+
+    string wasm_interface::get_vm_type_name(vm_type vm) {
+        return vm == vm_type::eos_vm_jit ? "jit" : "interpreter";
+    }
+
+    void wasm_interface::preload(uint64_t contract, const vector <uint8_t> &code, const uint256 &hash) {
+        // the same vm as the contexts executing the contracts
+        vm_type vm = get_vm_type();
+        if (!get_module_cache().exists(vm, hash))
+            get_module_preloader().push(vm, contract, code, hash);
+    }
+
+    void wasm_interface::set_module_cache_size(uint32_t max_bytes) {
+        get_module_cache().set_max_size(max_bytes);
+    }
 
+    vector <uint64_t> wasm_interface::get_cached_contracts() {
+        return get_module_cache().get_contracts();
     }
 
     class wasm_host_methods {
@@ -1028,5 +1237,6 @@ namespace wasm {
 
 extern  void wasm_code_cache_free() {
      //free heap before shut down
-     wasm::get_wasm_instantiation_cache().reset();
+     wasm::get_module_preloader().stop();
+     wasm::get_module_cache().clear();
 }
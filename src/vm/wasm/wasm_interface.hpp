@@ -14,6 +14,15 @@ namespace wasm {
         eos_vm_jit
     };
 
+    // the jit of eos-vm emits x86_64 code and maps it executable on linux
+#if defined(__x86_64__) && defined(__linux__)
+    static const bool     wasm_jit_supported = true;
+    static const vm_type  default_vm_type    = vm_type::eos_vm_jit;
+#else
+    static const bool     wasm_jit_supported = false;
+    static const vm_type  default_vm_type    = vm_type::eos_vm;
+#endif
+
     class wasm_interface {
 
     public:
@@ -27,5 +36,21 @@ namespace wasm {
         void validate(const vector <uint8_t>& code);
         void exit();
 
+        // the vm executing the contracts, selected by -wasmvm at startup
+        static void set_vm_type(vm_type vm);
+        static vm_type get_vm_type();
+        // "interpreter" or "jit"
+        static bool parse_vm_type(const string &name, vm_type &vm);
+        static string get_vm_type_name(vm_type vm);
+
+        // instantiate the module of contract in background, so its first execution finds it in the module cache
+        static void preload(uint64_t contract, const vector <uint8_t>& code, const uint256 &hash);
+        // bound the memory of the instantiated modules in the module cache
+        static void set_module_cache_size(uint32_t max_bytes);
+        // the contracts of the modules in the module cache, the most recently used first
+        static vector <uint64_t> get_cached_contracts();
+
+    private:
+        vm_type vm = default_vm_type;
     };
 }
@@ -50,7 +50,7 @@ namespace wasm {
                         pContext->contract(),
                         pContext->action());
             };
-            if (bm_wasm_init) bm_wasm_init->end();
+            bm_wasm_init.end();
 
             auto bm_wasm_run = MAKE_BENCHMARK("execute wasm vm -- run");
             try {
@@ -68,6 +68,11 @@ namespace wasm {
             _runtime->_bkend = nullptr;
         }
 
+        size_t get_memory_usage() const override {
+            const auto &allocator = _instantiated_module->get_module().allocator;
+            return allocator._size + (allocator.is_jit ? allocator._code_size : 0);
+        }
+
     private:
         wasm_vm_runtime <Impl> *    _runtime;
         std::shared_ptr <backend_t> _instantiated_module;